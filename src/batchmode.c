@@ -1,22 +1,50 @@
 /** @file
  * implematation of batchmode
  */ 
+#include <inttypes.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include "gamma.h"
 #include "dynamic_array.h"
+#include "journal.h"
+#include "latency.h"
+#include "batchmode.h"
+
+/** commands take at most 5 numbers, longer lines are invalid anyway */
+#define BATCH_MAX_ARGS 6
+
+/**
+ * buffers reused by all commands, so steady batch loop does not allocate.
+ * args -storage of arguments of current line
+ * d -arguments of current line
+ * board -text of last printed board
+ * board_size -size of @p board buffer
+ * busy_fields, free_fields -results of all players (allocated by first command a)
+ */
+struct batch_buffers{
+    uint32_t args[BATCH_MAX_ARGS];
+    darray d;
+    char *board;
+    size_t board_size;
+    uint64_t *busy_fields;
+    uint64_t *free_fields;
+};
 
 /**
  * runs gamma_move for batchmode.
  * checks if amount of arguments in @param d is proper
  */ 
-static void batch_gamma_move(gamma_t* g,int *line,darray *d)
+static void batch_gamma_move(gamma_t* g,int *line,darray *d,journal_t *j)
 {
     if(d!=NULL && d->length==3)
     {
-        if(gamma_move(g,d->a[0],d->a[1],d->a[2]))printf("1\n");
+        if(gamma_move(g,d->a[0],d->a[1],d->a[2]))
+        {
+            journal_move(j,g,d->a[0],d->a[1],d->a[2]);
+            printf("1\n");
+        }
         else printf("0\n");
     }
     else
@@ -77,11 +105,15 @@ void batch_gamma_golden_possible(gamma_t* g,int *line,darray *d)
  * runs gamma_golden_move for batchmode.
  * checks if amount of arguments in @param d is proper
  */ 
-void batch_gamma_golden_move(gamma_t* g,int *line,darray *d)
+void batch_gamma_golden_move(gamma_t* g,int *line,darray *d,journal_t *j)
 {
     if(d!=NULL && d->length==3)
     {
-        if(gamma_golden_move(g,d->a[0],d->a[1],d->a[2]))printf("1\n");
+        if(gamma_golden_move(g,d->a[0],d->a[1],d->a[2]))
+        {
+            journal_golden_move(j,g,d->a[0],d->a[1],d->a[2]);
+            printf("1\n");
+        }
         else printf("0\n");
     }
     else
@@ -94,13 +126,96 @@ void batch_gamma_golden_move(gamma_t* g,int *line,darray *d)
  * runs gamma_board for batchmode.
  * checks if amount of arguments in @param d is proper
  */ 
-void batch_gamma_board(gamma_t* g,int *line,darray *d)
+void batch_gamma_board(gamma_t* g,int *line,darray *d,struct batch_buffers *b)
+{
+    if(d!=NULL && d->length==0)
+    {
+        char* s=gamma_board_into(g,b->board,&b->board_size);
+        if(s!=NULL)
+        {
+            b->board=s;
+            printf("%s",s);
+        }
+    }
+    else
+    {
+        fprintf(stderr,"ERROR %d\n",*line);
+    }
+}
+
+/**
+ * prints busy and free fields of all players for batchmode,
+ * one "busy free" line per player.
+ * checks if amount of arguments in @param d is proper
+ */ 
+void batch_gamma_all_fields(gamma_t* g,int *line,darray *d,struct batch_buffers *b)
+{
+    if(b->busy_fields==NULL && g!=NULL)
+    {
+        b->busy_fields=malloc((size_t)g->players*sizeof(uint64_t));
+        b->free_fields=malloc((size_t)g->players*sizeof(uint64_t));
+    }
+    if(d!=NULL && d->length==0 && b->busy_fields!=NULL && b->free_fields!=NULL
+       && gamma_all_busy_fields(g,b->busy_fields) && gamma_all_free_fields(g,b->free_fields))
+    {
+        for(uint32_t i=0;i<g->players;i++)printf("%"PRIu64" %"PRIu64"\n",b->busy_fields[i],b->free_fields[i]);
+    }
+    else
+    {
+        fprintf(stderr,"ERROR %d\n",*line);
+    }
+}
+
+/**
+ * runs gamma_count_rect for batchmode.
+ * checks if amount of arguments in @param d is proper
+ */ 
+void batch_gamma_count_rect(gamma_t* g,int *line,darray *d)
 {
-    if(d!=NULL && d->size==0)
+    if(d!=NULL && d->length==5)
     {
-        char* s=gamma_board(g);
-        printf("%s",s);
-        free(s);
+        printf("%"PRIu64"\n",gamma_count_rect(g,d->a[0],d->a[1],d->a[2],d->a[3],d->a[4]));
+    }
+    else
+    {
+        fprintf(stderr,"ERROR %d\n",*line);
+    }
+}
+
+/**
+ * prints engine statistics for batchmode, one "name value" line each.
+ * checks if amount of arguments in @param d is proper
+ */ 
+void batch_gamma_stats(gamma_t* g,int *line,darray *d)
+{
+    struct gamma_stats st;
+    if(d!=NULL && d->length==0 && gamma_stats(g,&st))
+    {
+        printf("counters_enabled %d\n",st.counters_enabled);
+        printf("rescans_one_player %"PRIu64"\n",st.counters.rescans_one_player);
+        printf("rescans_two_players %"PRIu64"\n",st.counters.rescans_two_players);
+        printf("rescans_all_players %"PRIu64"\n",st.counters.rescans_all_players);
+        printf("labeled_tiles %"PRIu64"\n",st.counters.labeled_tiles);
+        printf("golden_possible_trials %"PRIu64"\n",st.counters.golden_possible_trials);
+        printf("empty_fields_scans %"PRIu64"\n",st.counters.empty_fields_scans);
+        printf("free_fields_cached %"PRIu64"\n",st.counters.free_fields_cached);
+        printf("golden_possible_cached %"PRIu64"\n",st.counters.golden_possible_cached);
+        printf("summary_skipped_tiles %"PRIu64"\n",st.counters.summary_skipped_tiles);
+        printf("bytes_allocated %"PRIu64"\n",st.counters.bytes_allocated);
+        printf("board_mapped %d\n",st.board_mapped);
+        printf("pages %s\n",st.pages==GAMMA_PAGES_HUGE ? "huge"
+               : st.pages==GAMMA_PAGES_TRANSPARENT ? "transparent" : "normal");
+        printf("board_bytes %"PRIu64"\n",st.board_bytes);
+        printf("visited_bytes %"PRIu64"\n",st.visited_bytes);
+        printf("rows_bytes %"PRIu64"\n",st.rows_bytes);
+        printf("players_bytes %"PRIu64"\n",st.players_bytes);
+        printf("lists_bytes %"PRIu64"\n",st.lists_bytes);
+        printf("summary_bytes %"PRIu64"\n",st.summary_bytes);
+        printf("components_bytes %"PRIu64"\n",st.components_bytes);
+        printf("undo_bytes %"PRIu64"\n",st.undo_bytes);
+        printf("struct_bytes %"PRIu64"\n",st.struct_bytes);
+        printf("scratch_bytes %"PRIu64"\n",st.scratch_bytes);
+        printf("total_bytes %"PRIu64"\n",st.total_bytes);
     }
     else
     {
@@ -110,22 +225,31 @@ void batch_gamma_board(gamma_t* g,int *line,darray *d)
 
 /**
  * reads line as a command.
+ * successful moves are recorded in journal @p j (if it is not NULL),
+ * execution time is recorded in @p l (if it is not NULL).
+ * arguments are read into buffers @p b .
  */
-void recognise_command(gamma_t* g,int *line,int *z)
+void recognise_command(gamma_t* g,int *line,int *z,journal_t *j,latency_t *l,struct batch_buffers *b)
  {
     *z=getchar();
     int k=*z;
     *line=*line+1;
     if((*z)!=EOF && (*z)!='\n')*z=getchar();
-    darray* d=read_numbers_from_line(z); 
+    darray* d=NULL;
+    if(read_numbers_into(&b->d,z))d=&b->d;
+    uint64_t start=0;
+    if(l!=NULL)start=latency_clock();
     switch(k)
     {
-        case 'm':batch_gamma_move(g,line,d);break;
-        case 'g':batch_gamma_golden_move(g,line,d);break;
+        case 'm':batch_gamma_move(g,line,d,j);break;
+        case 'g':batch_gamma_golden_move(g,line,d,j);break;
         case 'b':batch_gamma_busy_fields(g,line,d);break;
         case 'f':batch_gamma_free_fields(g,line,d);break;
         case 'q':batch_gamma_golden_possible(g,line,d);break;
-        case 'p':batch_gamma_board(g,line,d);break;
+        case 'p':batch_gamma_board(g,line,d,b);break;
+        case 's':batch_gamma_stats(g,line,d);break;
+        case 'a':batch_gamma_all_fields(g,line,d,b);break;
+        case 'r':batch_gamma_count_rect(g,line,d);break;
         default:
         if(k!='#' && k!='\n' && k!=EOF)
         {
@@ -133,15 +257,27 @@ void recognise_command(gamma_t* g,int *line,int *z)
         }
         break;
     }
-    d=free_darray(d);
+    if(l!=NULL && k!='#' && k!='\n' && k!=EOF)
+    {
+        latency_record(l,k,*line,latency_clock()-start);
+    }
  }
 
 
-void main_batch(gamma_t* g,int *line)
+void main_batch(gamma_t* g,int *line,journal_t *j,latency_t *l)
 {
     int z=' ';
+    struct batch_buffers b;
+    fixed_darray(&b.d,b.args,BATCH_MAX_ARGS);
+    b.board=NULL;
+    b.board_size=0;
+    b.busy_fields=NULL;
+    b.free_fields=NULL;
     while(z!=EOF)
     {
-        recognise_command(g,line,&z);
+        recognise_command(g,line,&z,j,l,&b);
     }
+    free(b.board);
+    free(b.busy_fields);
+    free(b.free_fields);
 }
\ No newline at end of file
@@ -3,8 +3,13 @@
  */
 #ifndef BATCH_MODE
 #define BATCH_MODE
+#include "gamma.h"
+#include "journal.h"
+#include "latency.h"
 /**
- * runs game in batch mode
+ * runs game in batch mode.
+ * successful moves are recorded in journal @p j, if it is not NULL,
+ * time of every command is recorded in @p l, if it is not NULL.
  */ 
-void main_batch(gamma_t* g,int *line);
+void main_batch(gamma_t* g,int *line,journal_t *j,latency_t *l);
 #endif
\ No newline at end of file
@@ -0,0 +1,217 @@
+/** @file
+ * gamma game on bitboards, see bitboard.h.
+ */
+#include <stddef.h>
+
+#include "bitboard.h"
+#include "zobrist.h"
+
+bool bitboard_init(bitboard_t *b,uint32_t width,uint32_t height,uint32_t players,uint32_t areas)
+{
+    bool result=false;
+    if(b!=NULL && width>0 && height>0 && players>0 && areas>0
+       && (uint64_t)width*height<=BITBOARD_MAX_CELLS && players<=BITBOARD_MAX_PLAYERS)
+    {
+        uint32_t cells=width*height;
+        *b=(bitboard_t){0};
+        b->width=width;
+        b->height=height;
+        b->players=players;
+        b->max_areas=areas;
+        b->board=cells==64 ? UINT64_MAX : ((uint64_t)1<<cells)-1;
+        uint64_t first=0;
+        for(uint32_t y=0;y<height;y++)first|=(uint64_t)1<<(y*width);
+        b->inner_left=b->board&~first;
+        b->inner_right=b->board&~(first<<(width-1));
+        b->golden=((uint32_t)1<<players)-1;
+        result=true;
+    }
+    return result;
+}
+
+/**
+ * returns bit of tile < @p x , @p y > of @p b , 0 if it is not on the
+ * board.
+ */
+static uint64_t cell_bit(const bitboard_t *b,uint32_t x,uint32_t y)
+{
+    uint64_t result=0;
+    if(x<b->width && y<b->height)result=(uint64_t)1<<(y*b->width+x);
+    return result;
+}
+
+/**
+ * returns player having taken tile @p bit of @p b .
+ */
+static uint32_t owner(const bitboard_t *b,uint64_t bit)
+{
+    uint32_t result=0;
+    while((b->tiles[result]&bit)==0)result++;
+    return result+1;
+}
+
+/**
+ * returns true if @p player is a player of @p b .
+ */
+static bool valid_player(const bitboard_t *b,uint32_t player)
+{
+    return player>0 && player<=b->players;
+}
+
+uint32_t bitboard_field(const bitboard_t *b,uint32_t x,uint32_t y)
+{
+    uint32_t result=0;
+    uint64_t bit=b!=NULL ? cell_bit(b,x,y) : 0;
+    if(bit!=0 && (b->taken&bit)!=0)result=owner(b,bit);
+    return result;
+}
+
+/**
+ * returns amount of areas @p player of @p b would have after taking free
+ * (or not own) tile @p bit .
+ */
+static uint32_t areas_after_take(const bitboard_t *b,uint32_t player,uint64_t bit)
+{
+    uint64_t own=b->tiles[player-1];
+    return b->areas[player-1]+1-bitboard_areas_touched(b,own,bitboard_grow(b,bit));
+}
+
+/**
+ * returns amount of areas @p player of @p b would have after losing own
+ * tile @p bit .
+ */
+static uint32_t areas_after_loss(const bitboard_t *b,uint32_t player,uint64_t bit)
+{
+    uint64_t rest=b->tiles[player-1]&~bit;
+    uint64_t near=bitboard_grow(b,bit)&rest;
+    uint32_t result=b->areas[player-1]-1;
+    //tile with at most one own neighbour does not split its area
+    if((near&(near-1))==0)result+=near!=0;
+    else result+=bitboard_areas_touched(b,rest,near);
+    return result;
+}
+
+/**
+ * gives tile @p bit of @p b (number @p cell ) to @p player , taking it
+ * from @p old (0 for free tile) and keeping taken tiles and hash up to
+ * date.
+ */
+static void cell_change(bitboard_t *b,uint32_t cell,uint64_t bit,uint32_t old,uint32_t player)
+{
+    if(old!=0)
+    {
+        b->tiles[old-1]&=~bit;
+        b->hash^=zobrist_cell(cell,'0'+old);
+    }
+    b->tiles[player-1]|=bit;
+    b->taken|=bit;
+    b->hash^=zobrist_cell(cell,'0'+player);
+}
+
+bool bitboard_move(bitboard_t *b,uint32_t player,uint32_t x,uint32_t y)
+{
+    bool result=false;
+    uint64_t bit=b!=NULL ? cell_bit(b,x,y) : 0;
+    if(bit!=0 && valid_player(b,player) && (b->taken&bit)==0)
+    {
+        uint32_t areas=areas_after_take(b,player,bit);
+        //joining own areas is always possible, new area needs room
+        if(areas<=b->areas[player-1] || areas<=b->max_areas)
+        {
+            b->areas[player-1]=areas;
+            cell_change(b,y*b->width+x,bit,0,player);
+            result=true;
+        }
+    }
+    return result;
+}
+
+bool bitboard_golden_move(bitboard_t *b,uint32_t player,uint32_t x,uint32_t y)
+{
+    bool result=false;
+    uint64_t bit=b!=NULL ? cell_bit(b,x,y) : 0;
+    if(bit!=0 && valid_player(b,player) && (b->golden>>(player-1)&1)!=0
+       && (b->taken&bit)!=0 && (b->tiles[player-1]&bit)==0)
+    {
+        uint32_t victim=owner(b,bit);
+        uint32_t gained=areas_after_take(b,player,bit);
+        uint32_t lost=areas_after_loss(b,victim,bit);
+        if(gained<=b->max_areas && lost<=b->max_areas)
+        {
+            b->areas[player-1]=gained;
+            b->areas[victim-1]=lost;
+            cell_change(b,y*b->width+x,bit,victim,player);
+            b->golden&=~((uint32_t)1<<(player-1));
+            b->hash^=zobrist_golden(player);
+            result=true;
+        }
+    }
+    return result;
+}
+
+bool bitboard_golden_possible(const bitboard_t *b,uint32_t player)
+{
+    bool result=false;
+    if(b!=NULL && valid_player(b,player) && (b->golden>>(player-1)&1)!=0)
+    {
+        uint64_t others=b->taken&~b->tiles[player-1];
+        //below the limit a tile which does not split its area can be
+        //taken, at the limit only tiles next to own ones
+        if(b->areas[player-1]<b->max_areas)result=others!=0;
+        else
+        {
+            uint64_t near=bitboard_grow(b,b->tiles[player-1])&others;
+            while(near!=0 && !result)
+            {
+                uint64_t bit=near&-near;
+                result=areas_after_loss(b,owner(b,bit),bit)<=b->max_areas;
+                near&=near-1;
+            }
+        }
+    }
+    return result;
+}
+
+uint64_t bitboard_golden_moves(const bitboard_t *b,uint32_t player)
+{
+    uint64_t result=0;
+    if(b!=NULL && valid_player(b,player) && (b->golden>>(player-1)&1)!=0)
+    {
+        uint64_t others=b->taken&~b->tiles[player-1];
+        //at the limit only tiles next to own ones do not make a new area
+        if(b->areas[player-1]>=b->max_areas)others&=bitboard_grow(b,b->tiles[player-1]);
+        for(uint64_t bits=others;bits!=0;bits&=bits-1)
+        {
+            uint64_t bit=bits&-bits;
+            if(areas_after_take(b,player,bit)<=b->max_areas
+               && areas_after_loss(b,owner(b,bit),bit)<=b->max_areas)
+            {
+                result|=bit;
+            }
+        }
+    }
+    return result;
+}
+
+uint64_t bitboard_busy_fields(const bitboard_t *b,uint32_t player)
+{
+    uint64_t result=0;
+    if(b!=NULL && valid_player(b,player))result=__builtin_popcountll(b->tiles[player-1]);
+    return result;
+}
+
+uint64_t bitboard_legal_moves(const bitboard_t *b,uint32_t player)
+{
+    uint64_t result=0;
+    if(b!=NULL && valid_player(b,player))
+    {
+        if(b->areas[player-1]<b->max_areas)result=b->board&~b->taken;
+        else result=bitboard_grow(b,b->tiles[player-1])&~b->taken;
+    }
+    return result;
+}
+
+uint64_t bitboard_free_fields(const bitboard_t *b,uint32_t player)
+{
+    return __builtin_popcountll(bitboard_legal_moves(b,player));
+}
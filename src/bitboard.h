@@ -0,0 +1,152 @@
+/** @file
+ * gamma game on boards of at most 64 tiles kept as bitboards: tiles of
+ * every player are one word (bit y*width+x), so neighbours of a set of
+ * tiles are a few shifts and masks, areas are counted by flood fill of
+ * whole words and a game is copied by plain assignment.
+ * rules, results and hash are the same as of gamma.h (gamma_move,
+ * gamma_golden_move, gamma_golden_possible, gamma_busy_fields,
+ * gamma_free_fields, gamma_field, gamma_hash).
+ */
+#ifndef BITBOARD_H
+#define BITBOARD_H
+#include <stdbool.h>
+#include <stdint.h>
+
+/** most tiles of a board */
+#define BITBOARD_MAX_CELLS 64
+/** most players of a game */
+#define BITBOARD_MAX_PLAYERS 16
+
+/**
+ * state of a game:
+ * tiles -tiles of every player
+ * taken -tiles of all players
+ * board -all tiles of the board
+ * inner_left, inner_right -tiles not in the first (last) column
+ * areas -amount of areas of every player, always exact
+ * golden -bit player-1 is set if player still has golden move
+ * hash -Zobrist hash, the same as gamma_hash of such game
+ */
+typedef struct bitboard{
+    uint64_t tiles[BITBOARD_MAX_PLAYERS];
+    uint64_t taken;
+    uint64_t board;
+    uint64_t inner_left;
+    uint64_t inner_right;
+    uint64_t hash;
+    uint32_t width;
+    uint32_t height;
+    uint32_t players;
+    uint32_t max_areas;
+    uint32_t areas[BITBOARD_MAX_PLAYERS];
+    uint32_t golden;
+} bitboard_t;
+
+/**
+ * returns tiles of board of @p b next to tiles @p m (not only outside
+ * of @p m ).
+ */
+static inline uint64_t bitboard_grow(const bitboard_t *b,uint64_t m)
+{
+    uint32_t w=b->width;
+    //two shifts, so that width 64 does not shift by 64
+    uint64_t up=(m<<(w-1))<<1;
+    uint64_t down=(m>>(w-1))>>1;
+    return ((m<<1)&b->inner_left)|((m>>1)&b->inner_right)|((up|down)&b->board);
+}
+
+/**
+ * returns tiles of @p mask connected (inside of @p mask ) to tiles
+ * @p seed of @p b .
+ */
+static inline uint64_t bitboard_flood(const bitboard_t *b,uint64_t seed,uint64_t mask)
+{
+    uint64_t result=seed&mask;
+    uint64_t previous=0;
+    while(result!=previous)
+    {
+        previous=result;
+        result=(result|bitboard_grow(b,result))&mask;
+    }
+    return result;
+}
+
+/**
+ * returns amount of areas of @p mask which have tiles in @p touched .
+ */
+static inline uint32_t bitboard_areas_touched(const bitboard_t *b,uint64_t mask,uint64_t touched)
+{
+    uint32_t result=0;
+    touched&=mask;
+    //one tile is one area, no fill is needed
+    if((touched&(touched-1))==0)result=touched!=0;
+    else
+    {
+        while(touched!=0)
+        {
+            touched&=~bitboard_flood(b,touched&-touched,mask);
+            result++;
+        }
+    }
+    return result;
+}
+
+/**
+ * starts game of @p players players on empty board @p width x @p height
+ * in @p b , every player may have at most @p areas areas.
+ * @returns false if parameters are not valid for gamma_new or the game
+ * does not fit (more than BITBOARD_MAX_CELLS tiles or
+ * BITBOARD_MAX_PLAYERS players)
+ */
+bool bitboard_init(bitboard_t *b,uint32_t width,uint32_t height,uint32_t players,uint32_t areas);
+
+/**
+ * returns player having tile < @p x , @p y > of @p b , 0 if it is free
+ * or not on the board.
+ */
+uint32_t bitboard_field(const bitboard_t *b,uint32_t x,uint32_t y);
+
+/**
+ * makes move of @p player on tile < @p x , @p y > of @p b , like
+ * gamma_move.
+ * @returns true if move was legal
+ */
+bool bitboard_move(bitboard_t *b,uint32_t player,uint32_t x,uint32_t y);
+
+/**
+ * makes golden move of @p player on tile < @p x , @p y > of @p b , like
+ * gamma_golden_move.
+ * @returns true if move was legal
+ */
+bool bitboard_golden_move(bitboard_t *b,uint32_t player,uint32_t x,uint32_t y);
+
+/**
+ * checks if @p player can make golden move in @p b , like
+ * gamma_golden_possible.
+ */
+bool bitboard_golden_possible(const bitboard_t *b,uint32_t player);
+
+/**
+ * returns tiles of other players @p player can take by golden move in
+ * @p b (every such gamma_golden_move would succeed).
+ */
+uint64_t bitboard_golden_moves(const bitboard_t *b,uint32_t player);
+
+/**
+ * returns amount of tiles of @p player in @p b .
+ */
+uint64_t bitboard_busy_fields(const bitboard_t *b,uint32_t player);
+
+/**
+ * returns amount of free tiles @p player can take by normal move in
+ * @p b , like gamma_free_fields.
+ */
+uint64_t bitboard_free_fields(const bitboard_t *b,uint32_t player);
+
+/**
+ * returns free tiles @p player can take by normal move in @p b (like
+ * gamma_legal_moves).
+ */
+uint64_t bitboard_legal_moves(const bitboard_t *b,uint32_t player);
+
+#endif
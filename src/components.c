@@ -0,0 +1,60 @@
+/** @file
+ * implements components.h
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "components.h"
+
+bool components_init(struct components *c,uint32_t cells)
+{
+    c->parent=malloc((size_t)cells*sizeof(uint32_t));
+    c->size=malloc((size_t)cells*sizeof(uint32_t));
+    c->cells=cells;
+    bool result=c->parent!=NULL && c->size!=NULL;
+    if(!result)components_free(c);
+    return result;
+}
+
+void components_add(struct components *c,uint32_t cell)
+{
+    c->parent[cell]=cell;
+    c->size[cell]=1;
+}
+
+uint32_t components_find(struct components *c,uint32_t cell)
+{
+    while(c->parent[cell]!=cell)
+    {
+        c->parent[cell]=c->parent[c->parent[cell]];
+        cell=c->parent[cell];
+    }
+    return cell;
+}
+
+void components_join(struct components *c,uint32_t a,uint32_t b)
+{
+    a=components_find(c,a);
+    b=components_find(c,b);
+    if(a!=b)
+    {
+        if(c->size[a]<c->size[b])
+        {
+            uint32_t t=a;
+            a=b;
+            b=t;
+        }
+        c->parent[b]=a;
+        c->size[a]+=c->size[b];
+    }
+}
+
+void components_free(struct components *c)
+{
+    free(c->parent);
+    free(c->size);
+    c->parent=NULL;
+    c->size=NULL;
+    c->cells=0;
+}
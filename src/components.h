@@ -0,0 +1,53 @@
+/** @file
+ * connected areas of tiles kept as disjoint sets (union by size, path
+ * halving), so that adding a tile joins areas next to it in almost
+ * constant time. tiles can not be taken out of an area, whole sets are
+ * built again instead.
+ */
+#ifndef COMPONENTS_H
+#define COMPONENTS_H
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * disjoint sets of @p cells tiles (numbered y*width+x):
+ * parent -parent of every tile, root of a set is its own parent
+ * size -amount of tiles of every set, valid only for roots
+ * the root of the bigger set becomes root of joined sets, so the root
+ * (and id made of it) of an area stays the same when smaller areas are
+ * joined to it.
+ */
+struct components{
+    uint32_t *parent;
+    uint32_t *size;
+    uint32_t cells;
+};
+
+/**
+ * allocates sets of @p cells tiles in @p c , every tile alone.
+ * @returns false if there is no memory
+ */
+bool components_init(struct components *c,uint32_t cells);
+
+/**
+ * makes tile @p cell a set of its own.
+ */
+void components_add(struct components *c,uint32_t cell);
+
+/**
+ * returns root of set of tile @p cell , shortening the path to it.
+ */
+uint32_t components_find(struct components *c,uint32_t cell);
+
+/**
+ * joins sets of tiles @p a and @p b (if they are not joined yet), root
+ * of set of @p a stays the root if the sets are of the same size.
+ */
+void components_join(struct components *c,uint32_t a,uint32_t b);
+
+/**
+ * frees memory of @p c and leaves it empty.
+ */
+void components_free(struct components *c);
+
+#endif
@@ -5,13 +5,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
-struct dynamic_array{
-    uint32_t *a;
-    int length;
-    int size;
-    bool ok;
-};
-typedef struct dynamic_array darray;
+#include "dynamic_array.h"
 
 darray* new_darray()
 {
@@ -20,19 +14,36 @@ darray* new_darray()
     result->length=0;
     result->size=0;
     result->ok=true;
+    result->fixed=false;
     return result;
 }
 
+void fixed_darray(darray *d,uint32_t *storage,int capacity)
+{
+    d->a=storage;
+    d->length=0;
+    d->size=capacity;
+    d->ok=true;
+    d->fixed=true;
+}
+
 void add_darray(darray *d,uint32_t x)
 {
-    if(d->length==d->size)
+    if(d->length==d->size && d->fixed)
     {
-        d->size=d->size*2+1;
-        d->a=realloc(d->a, d->size * sizeof(uint32_t));
-        if(d->a==NULL)exit(1);//emergency
+        d->ok=false;
+    }
+    else
+    {
+        if(d->length==d->size)
+        {
+            d->size=d->size*2+1;
+            d->a=realloc(d->a, d->size * sizeof(uint32_t));
+            if(d->a==NULL)exit(1);//emergency
+        }
+        d->a[d->length]=x;
+        (d->length)++;
     }
-    d->a[d->length]=x;
-    (d->length)++;
 }
 
 darray* free_darray(darray *d)
@@ -123,10 +134,11 @@ static void end_bad_line_read(int *z)
     }
  }
 
-darray* read_numbers_from_line(int *z)
+bool read_numbers_into(darray *d,int *z)
 {
-    darray* result=new_darray();
     bool ok=true;
+    d->length=0;
+    d->ok=true;
     if((*z)!='\n'&& character_type(*z)!=1)
     {
         ok=false;
@@ -139,7 +151,7 @@ darray* read_numbers_from_line(int *z)
         ignore_whitespaces(z);
         if(pom.ok)
         {
-            add_darray(result,pom.n);
+            add_darray(d,pom.n);
         }
         else
         {
@@ -148,8 +160,18 @@ darray* read_numbers_from_line(int *z)
     }
     if(ok==false || (character_type(*z)==2 && ((*z)!=EOF && (*z)!='\n')))
     {
-        result=free_darray(result);
+        ok=false;
     }
     if((*z)!=EOF && (*z)!='\n')end_bad_line_read(z); 
+    return ok && d->ok;
+}
+
+darray* read_numbers_from_line(int *z)
+{
+    darray* result=new_darray();
+    if(!read_numbers_into(result,z))
+    {
+        result=free_darray(result);
+    }
     return result;
 }
@@ -4,12 +4,16 @@
 
 #ifndef DYNAM_ARRAY
 #define DYNAM_ARRAY
+#include <stdbool.h>
+#include <stdint.h>
 //needed for direct access to length
+//fixed arrays use storage given by caller and never grow
 struct dynamic_array{
     uint32_t *a;
     int length;
     int size;
     bool ok;
+    bool fixed;
 };
 typedef struct dynamic_array darray;
 
@@ -18,8 +22,15 @@ typedef struct dynamic_array darray;
  */
 darray* new_darray();
 
+/**
+ * initializes @p d as empty array of at most @p capacity numbers
+ * kept in @p storage, so reading lines into it does not allocate.
+ */
+void fixed_darray(darray *d,uint32_t *storage,int capacity);
+
 /**
  * add an element to array.
+ * if fixed array is full, element is dropped and ok is set to false.
  */
 void add_darray(darray *d,uint32_t x);
 
@@ -35,4 +46,11 @@ darray* free_darray(darray *d);
  */ 
 darray* read_numbers_from_line(int *z);
 
+/**
+ * reads line into existing array @p d (previous content is dropped).
+ * @returns false if there are some improper expresions
+ * or line does not fit into fixed array
+ */
+bool read_numbers_into(darray *d,int *z);
+
 #endif
\ No newline at end of file
@@ -3,13 +3,39 @@
  * @date 16.04.2020
 */
 
+#define _POSIX_C_SOURCE 200809L
+//MAP_ANONYMOUS, MAP_HUGETLB and madvise
+#define _DEFAULT_SOURCE
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "components.h"
+#include "gamma.h"
+#include "labeling.h"
+#include "rle.h"
+#include "summary.h"
+#include "tile_list.h"
+#include "tiled.h"
+#include "zobrist.h"
 
 #define ESC '\033'
 
+#ifdef GAMMA_STATS
+/** adds @p n to counter @p name of game @p g */
+#define STAT_ADD(g,name,n) ((g)->counters.name+=(n))
+#else
+/** counters are compiled out, @p g and @p n are still evaluated */
+#define STAT_ADD(g,name,n) ((void)(g),(void)(n))
+#endif
+
 /**  struct line
 holds pointer to content of line
 */
@@ -17,209 +43,583 @@ struct line{
     int *line;
 };
 
-/**     struct gamma
- * holds information about state of the game:
- * width -board width
- * height -board height
- * players -amount of players
- * areas -maximum allowed number of areas for one player
- * row -pointer to array of lines, stores state of the board
- * pom -pointer to array of lines, stores information whenever the tile was visited in rescan
- * players_golden- pointer to array with information whenever player executed their golden move already
- * players_area -pointer to  array with information about each player current area count
- * players_tiles -pointer to  array with information about each players current tile count
- * */
-struct gamma{
-    uint32_t width;
-    uint32_t height;
-    uint32_t players;
-    uint32_t  areas;
-    struct line *row;
-    struct line *pom;
-    bool *players_golden;
+/** 
+ * loops over row-major array board specialized for one cell width,
+ * generated from gamma_cells.h:
+ * cell_bytes -size of a cell
+ * board_fill -fills board with empty tiles
+ * empty_fields -counts free tiles next to tiles of a player
+ * empty_fields_all -counts free tiles next to tiles of every player
+ * empty_bits -marks free tiles in a bitmap
+ * rect_count -counts tiles of one value in a rectangle
+ * board_print -prints board with less than 10 players
+ * board_count -counts tiles of every player and hashes them, checking
+ *      values of tiles
+ */
+struct cell_ops{
+    uint32_t cell_bytes;
+    void (*board_fill)(gamma_t *g);
+    uint64_t (*empty_fields)(gamma_t *g,uint32_t player);
+    void (*empty_fields_all)(gamma_t *g,uint64_t *out);
+    uint64_t (*empty_bits)(gamma_t *g,uint64_t *bits);
+    uint64_t (*rect_count)(gamma_t *g,int v,uint32_t x0,uint32_t y0,uint32_t x1,uint32_t y1);
+    void (*board_print)(gamma_t *g,char *result);
+    bool (*board_count)(gamma_t *g,uint64_t *out,uint64_t *hash);
+};
+
+/** 
+ * checks if free tiles next to tiles of players with bits @p players
+ * (see summary_bit) can not be in block < @p bx , @p by > of summaries
+ * of @p g : the block has no free tile, or neither it nor blocks next
+ * to it may have tiles of such players.
+ */
+static bool summary_skip(gamma_t *g,uint32_t bx,uint32_t by,uint64_t players)
+{
+    uint32_t columns=g->summary_columns;
+    const struct block_summary *s=g->summary+(size_t)by*columns+bx;
+    bool result=s->empty==0;
+    if(!result)
+    {
+        result=(s->players&players)==0
+            && (bx==0 || ((s-1)->players&players)==0)
+            && (bx+1>=columns || ((s+1)->players&players)==0)
+            && (by==0 || ((s-columns)->players&players)==0)
+            && (by+1>=g->summary_rows || ((s+columns)->players&players)==0);
+    }
+    return result;
+}
+
+#define CELL_T uint8_t
+#define CELL_FN(name) name##_8
+#include "gamma_cells.h"
+#undef CELL_FN
+#undef CELL_T
+#define CELL_T uint16_t
+#define CELL_FN(name) name##_16
+#include "gamma_cells.h"
+#undef CELL_FN
+#undef CELL_T
+#define CELL_T uint32_t
+#define CELL_FN(name) name##_32
+#include "gamma_cells.h"
+#undef CELL_FN
+#undef CELL_T
+
+/** 
+ * returns size of the smallest cell holding tile values of @p players
+ * players ('0'+player).
+ */
+static uint32_t cell_bytes_for(uint64_t players)
+{
+    uint32_t result=4;
+    if('0'+players<=UINT8_MAX)result=1;
+    else if('0'+players<=UINT16_MAX)result=2;
+    return result;
+}
+
+/** 
+ * returns loops for array board of @p cell_bytes cells.
+ */
+static const struct cell_ops* cell_ops_for(uint32_t cell_bytes)
+{
+    const struct cell_ops *result=&ops_32;
+    if(cell_bytes==1)result=&ops_8;
+    else if(cell_bytes==2)result=&ops_16;
+    return result;
+}
+
+/**
+ * versions of player state and remembered query results:
+ * version -changed whenever tiles of the player or empty tiles next to
+ *          them change (starts at 1)
+ * free_version -version for which @p free_fields is valid (0 -none)
+ * free_global -version of whole game for which @p free_fields is valid,
+ *              0 if it depends only on tiles of the player
+ * golden_version -version of whole game for which @p golden_possible
+ *                 is valid (0 -none)
+ * area_exact -whether area count of the player is exact, not only an
+ *             upper bound (set by rescans, cleared by moves which may
+ *             join areas)
+ */
+struct player_cache{
+    uint64_t version;
+    uint64_t free_version;
+    uint64_t free_global;
+    uint64_t free_fields;
+    uint64_t golden_version;
+    bool golden_possible;
+    bool area_exact;
+};
+
+/**
+ * tile changed after checkpoint: number of the tile (y*width+x) and its
+ * value before the change.
+ */
+struct undo_change{
+    uint64_t cell;
+    int old;
+};
+
+/**
+ * checkpoint of a game: amount of changes recorded before it and hash
+ * of the game at it.
+ */
+struct undo_level{
+    size_t length;
+    uint64_t hash;
+};
+
+/**
+ * nested checkpoints of a game (gamma_checkpoint) and changes of tiles
+ * made after the first one, taken back by gamma_rollback:
+ * levels -checkpoints from the oldest
+ * depth, level_capacity -amount of checkpoints and size of @p levels
+ * players_area, players_tiles, players_golden, area_exact -state of
+ * players at every checkpoint, one block of @p players items per level
+ * changes -changed tiles in order of changes
+ * length, capacity -amount of changes and size of @p changes
+ * lost -a change could not be recorded (no memory)
+ */
+struct undo_log{
+    struct undo_level *levels;
+    uint32_t depth;
+    uint32_t level_capacity;
     uint32_t *players_area;
     uint64_t *players_tiles;
+    bool *players_golden;
+    bool *area_exact;
+    struct undo_change *changes;
+    size_t length;
+    size_t capacity;
+    bool lost;
+};
+
+/** arrays inside of game arena are aligned to cache lines */
+#define ARENA_ALIGN 64
+
+/** kinds of board kept in game arena */
+enum arena_board{
+    ARENA_ARRAY,/**< board and visited marks in the arena */
+    ARENA_MAPPED,/**< visited marks in the arena, board mapped from file */
+    ARENA_RLE,/**< table of run-length encoded rows */
+    ARENA_TILED/**< visited marks and board split into blocks in the arena */
 };
-typedef struct gamma gamma_t;
 
+/** 
+ * offsets of arrays inside of game arena (single block starting with
+ * struct gamma), and size of whole arena.
+ */
+struct arena_layout{
+    size_t row;
+    size_t players_tiles;
+    size_t players_area;
+    size_t players_golden;
+    size_t players_list;
+    size_t players_cache;
+    size_t visited;
+    size_t summary;
+    size_t board;
+    size_t size;
+};
 
-/**  
- * frees memory used by @p a pointers
+/** 
+ * freed arena blocks kept for reuse by gamma_new, one list per thread.
+ * next -next block on the list
+ * size -size of the block
+ * scratch, scratch_size -scratch array of the freed game, reused with the block
  */
-static void line_delete(struct line *a)
+struct pool_block{
+    struct pool_block *next;
+    size_t size;
+    uint32_t *scratch;
+    uint64_t scratch_size;
+};
+
+/** amount of threads used to recount areas, 0 -one per processor */
+static uint32_t label_threads=0;
+
+void gamma_threads(uint32_t threads)
 {
-    if(a!=NULL)
-    {
-        if((a->line)!=NULL)
-        {
-            free(a->line);
-        }
-    }
+    label_threads=threads;
 }
 
+/** size of huge page */
+#define HUGE_PAGE_SIZE ((size_t)2<<20)
 
-void gamma_delete(gamma_t *g)
+/** arenas at least this big are put on huge pages, 0 -never */
+static uint64_t huge_pages_min=(uint64_t)256<<20;
+
+void gamma_huge_pages(uint64_t min_bytes)
 {
-    if(g!=NULL)
+    huge_pages_min=min_bytes;
+}
+
+/** 
+ * allocates zeroed arena of @p *size bytes, on huge pages if it is big
+ * enough: MAP_HUGETLB first, then mapping with MADV_HUGEPAGE, then calloc.
+ * kind of pages is stored in @p pages , mapped arenas are rounded up to
+ * huge pages and their size is stored in @p *size .
+ */
+static void* arena_alloc(size_t *size,enum gamma_pages *pages)
+{
+    void *result=NULL;
+    *pages=GAMMA_PAGES_NORMAL;
+    if(huge_pages_min>0 && *size>=huge_pages_min && *size<=SIZE_MAX-HUGE_PAGE_SIZE)
     {
-        if(g->row!=NULL)
+        size_t length=(*size+HUGE_PAGE_SIZE-1)/HUGE_PAGE_SIZE*HUGE_PAGE_SIZE;
+        void *map=MAP_FAILED;
+#ifdef MAP_HUGETLB
+        map=mmap(NULL,length,PROT_READ|PROT_WRITE,MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB,-1,0);
+        if(map!=MAP_FAILED)*pages=GAMMA_PAGES_HUGE;
+#endif
+#ifdef MADV_HUGEPAGE
+        if(map==MAP_FAILED)
         {
-            for(uint32_t i=0;i<g->height;i++)
+            map=mmap(NULL,length,PROT_READ|PROT_WRITE,MAP_PRIVATE|MAP_ANONYMOUS,-1,0);
+            if(map!=MAP_FAILED && madvise(map,length,MADV_HUGEPAGE)==0)*pages=GAMMA_PAGES_TRANSPARENT;
+            else if(map!=MAP_FAILED)
             {
-                line_delete(&(g->row[i]));
+                munmap(map,length);
+                map=MAP_FAILED;
             }
-            free(g->row);
         }
-        if(g->pom!=NULL)
+#endif
+        if(map!=MAP_FAILED)
         {
-            for(uint32_t i=0;i<g->height;i++)
-            {
-                line_delete(&(g->pom[i]));
-            }
-            free(g->pom);
+            result=map;
+            *size=length;
         }
-        if(g->players_tiles!=NULL)free(g->players_tiles);
-        if(g->players_area!=NULL)free(g->players_area);
-        if(g->players_golden!=NULL)free(g->players_golden);
-        free(g);
     }
+    if(result==NULL)result=calloc(1,*size);
+    return result;
+}
+
+/** first block in the pool of current thread */
+static _Thread_local struct pool_block *pool_first=NULL;
+/** amount of blocks in the pool of current thread */
+static _Thread_local size_t pool_length=0;
+/** maximal amount of blocks in the pool of current thread, 0 disables it */
+static _Thread_local size_t pool_limit=0;
+
+void gamma_pool_limit(size_t blocks)
+{
+    pool_limit=blocks;
+    while(pool_length>pool_limit)
+    {
+        struct pool_block *b=pool_first;
+        pool_first=b->next;
+        pool_length--;
+        free(b->scratch);
+        free(b);
+    }
+}
+
+/** 
+ * frees lists of tiles of players of @p g , which are not used anymore
+ * (work falls back to going through whole board).
+ */
+static void lists_drop(gamma_t *g)
+{
+    for(uint32_t i=0;i<g->players;i++)tile_list_free(&g->players_list[i]);
+    g->players_list=NULL;
+}
+
+/** 
+ * adds tile @p cell to list @p l of @p g , counting memory of the list
+ * if it grows.
+ * @returns false if there is no memory for the list to grow
+ */
+static bool list_add(gamma_t *g,struct tile_list *l,uint32_t cell)
+{
+    uint32_t capacity=l->capacity;
+    bool result=tile_list_add(l,cell);
+    if(l->capacity!=capacity)STAT_ADD(g,bytes_allocated,(uint64_t)l->capacity*sizeof(uint32_t));
+    return result;
+}
+
+/** 
+ * frees checkpoint of @p g .
+ */
+static void undo_drop(gamma_t *g)
+{
+    struct undo_log *u=g->undo;
+    free(u->levels);
+    free(u->players_area);
+    free(u->players_tiles);
+    free(u->players_golden);
+    free(u->area_exact);
+    free(u->changes);
+    free(u);
+    g->undo=NULL;
 }
 
-/**     line_setup
- * function to alocate memory for line @p a array
- * and fill it with @p k
- * array is length of @p width
+/** 
+ * frees area ids of @p g , they are built again by next query.
  */
+static void components_drop(gamma_t *g)
+{
+    components_free(g->components);
+    free(g->components);
+    g->components=NULL;
+}
 
-static void line_setup(struct line *a,uint32_t width,uint32_t k)
+void gamma_delete(gamma_t *g)
 {
-    a->line=malloc(width*sizeof(uint32_t));
-    if(a->line!=NULL)
+    if(g!=NULL)
     {
-        for(uint32_t i=0;i<width;i++)
+        if(g->map!=NULL)munmap(g->map,g->map_size);
+        if(g->rle!=NULL)
+        {
+            for(uint32_t i=0;i<g->height;i++)rle_free(&g->rle[i]);
+        }
+        if(g->players_list!=NULL)lists_drop(g);
+        if(g->components!=NULL)components_drop(g);
+        if(g->undo!=NULL)undo_drop(g);
+        if(g->pages!=GAMMA_PAGES_NORMAL)
+        {
+            free(g->scratch);
+            munmap(g,g->arena_size);
+        }
+        else if(pool_length<pool_limit && g->map==NULL)
+        {
+            uint32_t *scratch=g->scratch;
+            uint64_t scratch_size=g->scratch_size;
+            size_t size=g->arena_size;
+            struct pool_block *b=(struct pool_block*)g;
+            b->next=pool_first;
+            b->size=size;
+            b->scratch=scratch;
+            b->scratch_size=scratch_size;
+            pool_first=b;
+            pool_length++;
+        }
+        else
         {
-            a->line[i]=k;
+            free(g->scratch);
+            free(g);
         }
     }
 }
 
-/** allocate memory for array of lines.
- * array is length of @p height
+/** 
+ * rounds @p x up to multiple of ARENA_ALIGN.
  */
-static struct line* row_setup(uint32_t height)
+static size_t arena_align(size_t x)
 {
-    struct line* result;
-    result=malloc(height*sizeof(struct line));
-    return result;
+    return (x+ARENA_ALIGN-1)/ARENA_ALIGN*ARENA_ALIGN;
 }
 
-/** allocate memory for array containg counts of each player current areas.
- * index for player k is k-1
- * array length is @p players
+/** 
+ * checks if board of size @p width x @p height can be addressed in memory.
  */
-static uint32_t* players_area_setup(uint32_t players)
+static bool board_size_ok(uint64_t width,uint64_t height)
 {
-    uint32_t *result;
-    result=calloc(players*sizeof(uint32_t),sizeof(uint32_t));
-    return result;
+    //tile indexes have to fit into union-find parents, see labeling.h
+    return (uint64_t)width*height <= SIZE_MAX/(4*sizeof(int))
+        && (uint64_t)width*height < UINT32_MAX;
 }
 
 /** 
- * allocate memory for array containg counts of each player current tiles
- *  index for player k is k-1
- * array length is @p players
+ * computes layout of arena for game with given dimensions and @p board
+ * kind, table of rows (struct line or struct rle_row, none for board
+ * split into blocks) is at offset row.
  */
-static uint64_t* players_tiles_setup(uint32_t players)
+static void arena_setup(struct arena_layout *a,uint32_t width,uint32_t height,
+                        uint32_t players,uint32_t cell_bytes,enum arena_board board)
 {
-    uint64_t *result;
-    result=calloc(players*sizeof(uint64_t),sizeof(uint64_t));
-    return result;
+    size_t cells=(size_t)width*height;
+    size_t board_cells=cells;
+    size_t row_size=board==ARENA_RLE ? sizeof(struct rle_row) : sizeof(struct line);
+    if(board==ARENA_TILED)
+    {
+        //blocks on right and top border are padded
+        board_cells=tiled_blocks(width)*tiled_blocks(height)*TILED_SIDE*TILED_SIDE;
+        row_size=0;
+    }
+    a->row=arena_align(sizeof(gamma_t));
+    a->players_tiles=arena_align(a->row+(size_t)height*row_size);
+    a->players_area=arena_align(a->players_tiles+(size_t)players*sizeof(uint64_t));
+    a->players_golden=arena_align(a->players_area+(size_t)players*sizeof(uint32_t));
+    a->players_list=arena_align(a->players_golden+(size_t)players*sizeof(bool));
+    //rle board has no tile lists, they would take more than its rows
+    size_t list_size=board==ARENA_RLE ? 0 : sizeof(struct tile_list);
+    a->players_cache=arena_align(a->players_list+(size_t)players*list_size);
+    a->visited=arena_align(a->players_cache+(size_t)players*sizeof(struct player_cache));
+    a->summary=a->visited;
+    a->board=a->visited;
+    if(board!=ARENA_RLE)
+    {
+        size_t blocks=(size_t)summary_blocks(width,SUMMARY_COLUMN_BITS)*summary_blocks(height,SUMMARY_ROW_BITS);
+        a->summary=arena_align(a->visited+cells*sizeof(int));
+        a->board=arena_align(a->summary+blocks*sizeof(struct block_summary));
+    }
+    a->size=a->board;
+    if(board==ARENA_ARRAY || board==ARENA_TILED)a->size=arena_align(a->board+board_cells*cell_bytes);
 }
 
 /** 
- * allocate memory for array containg bool value of true for each player
- * index for player k is k-1
- * array length is @p players
+ * takes block of @p size bytes from the pool of current thread.
+ * @returns NULL if there is no such block
  */
-static bool* players_bool_setup(uint32_t players)
+static void* pool_take(size_t size)
 {
-    bool *result;
-    result=malloc(players*sizeof(bool));
+    struct pool_block **b=&pool_first;
+    while(*b!=NULL && (*b)->size!=size)b=&((*b)->next);
+    struct pool_block *result=*b;
     if(result!=NULL)
     {
-        for(uint32_t i=0;i<players;i++)
+        *b=result->next;
+        pool_length--;
+    }
+    return result;
+}
+
+/** 
+ * points lines of @p a to consecutive rows of @p block .
+ * @p block has @p height rows of length @p width
+ */
+static void row_attach(struct line *a,int *block,uint32_t width,uint32_t height)
+{
+    for(uint32_t i=0;i<height;i++)
+    {
+        a[i].line=block+(size_t)i*width;
+    }
+}
+
+/** 
+ * sets summaries of all blocks of @p g to blocks of empty tiles.
+ */
+static void summary_clear(gamma_t *g)
+{
+    for(uint32_t by=0;by<g->summary_rows;by++)
+    {
+        uint32_t y=by<<SUMMARY_ROW_BITS;
+        uint32_t rows=g->height-y>SUMMARY_ROWS ? SUMMARY_ROWS : g->height-y;
+        for(uint32_t bx=0;bx<g->summary_columns;bx++)
         {
-            result[i]=true;
+            uint32_t x=bx<<SUMMARY_COLUMN_BITS;
+            uint32_t columns=g->width-x>SUMMARY_COLUMNS ? SUMMARY_COLUMNS : g->width-x;
+            struct block_summary *s=summary_at(g->summary,g->summary_columns,x,y);
+            s->empty=rows*columns;
+            s->busy=0;
+            s->owner=SUMMARY_NONE;
+            s->players=0;
         }
     }
-    return result;
 }
 
 /** 
- * allocate memory for structure gamma and initialize arrays inside of it.
+ * allocate single arena for structure gamma and all its arrays
+ * (reusing pooled block if there is one of the same size)
+ * and initialize it, except for the board content.
  * @param[in] width   – board width, positive number
  * @param[in] height  – board height, positive number
  * @param[in] players – number of players, positive
  * @param[in] areas   – max amount of areas taken by one player
+ * @param[in] cell_bytes – size of a cell of the board
+ * @param[in] board   – kind of board kept in arena
  */
 static gamma_t* gamma_setup(uint32_t width, uint32_t height,
-                            uint32_t players, uint32_t areas)
+                            uint32_t players, uint32_t areas, uint32_t cell_bytes,
+                            enum arena_board board)
 {
-    gamma_t* result;
-    result=malloc(sizeof *result);
+    struct arena_layout a;
+    arena_setup(&a,width,height,players,cell_bytes,board);
+    uint32_t *scratch=NULL;
+    uint64_t scratch_size=0;
+    struct pool_block *block=pool_take(a.size);
+    char *arena=(char*)block;
+    bool reused=block!=NULL;
+    enum gamma_pages pages=GAMMA_PAGES_NORMAL;
+    if(reused)
+    {
+        scratch=block->scratch;
+        scratch_size=block->scratch_size;
+        memset(arena,0,a.board);
+    }
+    else arena=arena_alloc(&a.size,&pages);
+    gamma_t* result=(gamma_t*)arena;
     if(result!=NULL)
     {
         result->height=height;
         result->width=width;
         result->players=players;
         result->areas=areas;
-        result->row=row_setup(height);
-        result->pom=row_setup(height);
-        result->players_area=players_area_setup(players);
-        result->players_tiles=players_tiles_setup(players);
-        result->players_golden=players_bool_setup(players);
-        if( result->row==NULL || result->pom==NULL || result->players_area==NULL
-                || result->players_tiles==NULL || result->players_golden==NULL )
-            {
-                gamma_delete(result);
-                result=NULL;
-            }
+        result->arena_size=a.size;
+        result->pages=pages;
+        result->scratch=scratch;
+        result->scratch_size=scratch_size;
+        result->players_tiles=(uint64_t*)(arena+a.players_tiles);
+        result->players_area=(uint32_t*)(arena+a.players_area);
+        result->players_golden=(bool*)(arena+a.players_golden);
+        result->players_cache=(struct player_cache*)(arena+a.players_cache);
+        if(board!=ARENA_RLE)result->players_list=(struct tile_list*)(arena+a.players_list);
+        result->version=1;
+        if(board==ARENA_RLE)result->rle=(struct rle_row*)(arena+a.row);
+        else
+        {
+            if(board!=ARENA_TILED)result->row=(struct line*)(arena+a.row);
+            result->visited=(int*)(arena+a.visited);
+            result->summary=(struct block_summary*)(arena+a.summary);
+            result->summary_columns=summary_blocks(width,SUMMARY_COLUMN_BITS);
+            result->summary_rows=summary_blocks(height,SUMMARY_ROW_BITS);
+            summary_clear(result);
+        }
+        if(board==ARENA_ARRAY || board==ARENA_TILED)result->board=(int*)(arena+a.board);
+        if(board==ARENA_TILED)result->tile_columns=tiled_blocks(width);
+        result->cell_bytes=cell_bytes;
+        if(board==ARENA_ARRAY || board==ARENA_MAPPED)result->cells=cell_ops_for(cell_bytes);
+        for(uint32_t i=0;i<players;i++)
+        {
+            result->players_golden[i]=true;
+            result->players_cache[i].version=1;
+        }
+        if(!reused)STAT_ADD(result,bytes_allocated,a.size);
     }
-
     return result;
 }
 
 
-gamma_t* gamma_new(uint32_t width, uint32_t height,
-                   uint32_t players, uint32_t areas)
+gamma_t* gamma_new_storage(uint32_t width, uint32_t height,
+                           uint32_t players, uint32_t areas,
+                           enum gamma_storage storage)
 {
     gamma_t *p=NULL;
-    bool ok=true;
-    if(width>0 && height>0 && players>0 && areas>0)
+    if(width>0 && height>0 && players>0 && areas>0 && board_size_ok(width,height))
     {
-        p=gamma_setup(width,height,players,areas);
-        if(p!=NULL && p->row!=NULL && p->pom!=NULL)
+        //rows of rle board are empty until first change
+        if(storage==GAMMA_STORAGE_RLE)p=gamma_setup(width,height,players,areas,sizeof(int),ARENA_RLE);
+        else if(storage==GAMMA_STORAGE_ARRAY)
         {
-           for(uint32_t i=0;i<height;i++)
-            {
-                line_setup(&(p->row[i]),width,'.');
-                if(p->row[i].line==NULL)ok=false;
-            }
-            for(uint32_t i=0;i<height;i++)
+            p=gamma_setup(width,height,players,areas,cell_bytes_for(players),ARENA_ARRAY);
+            if(p!=NULL)
             {
-                line_setup(&(p->pom[i]),width,0);
-                if(p->pom[i].line==NULL)ok=false;
+                p->cells->board_fill(p);
+                if(p->cell_bytes==sizeof(int))row_attach(p->row,p->board,width,height);
             }
-            if(ok==false)
+        }
+        else if(storage==GAMMA_STORAGE_TILED
+                && board_size_ok(tiled_blocks(width)*TILED_SIDE,tiled_blocks(height)*TILED_SIDE))
+        {
+            p=gamma_setup(width,height,players,areas,sizeof(int),ARENA_TILED);
+            if(p!=NULL)
             {
-                gamma_delete(p);
-                p=NULL;
+                //padding is never read, but printed boards are easier to debug
+                int *board=p->board;
+                size_t cells=tiled_blocks(width)*tiled_blocks(height)*TILED_SIDE*TILED_SIDE;
+                for(size_t i=0;i<cells;i++)board[i]='.';
             }
         }
     }
     return p;
 }
 
+gamma_t* gamma_new(uint32_t width, uint32_t height,
+                   uint32_t players, uint32_t areas)
+{
+    return gamma_new_storage(width,height,players,areas,GAMMA_STORAGE_ARRAY);
+}
+
 
 
 /**
@@ -233,6 +633,118 @@ static bool valid_tile(gamma_t *g,uint32_t x,uint32_t y)
     return ((x< g->width)&&(y< g->height));
 }
 
+/** 
+ * returns value of valid tile < @p x , @p y > of board of @p g ,
+ * whatever its storage is.
+ */
+static int cell_get(gamma_t *g,uint32_t x,uint32_t y)
+{
+    if(g->rle!=NULL)return rle_get(&g->rle[y],x);
+    else if(g->tile_columns>0)return ((int*)g->board)[tiled_index(g->tile_columns,x,y)];
+    else if(g->cell_bytes==1)return ((uint8_t*)g->board)[(size_t)y*g->width+x];
+    else if(g->cell_bytes==2)return ((uint16_t*)g->board)[(size_t)y*g->width+x];
+    else return g->row[y].line[x];
+}
+
+/** 
+ * stores numbers of tiles next to tile @p cell of @p g in @p out .
+ * @returns amount of such tiles (2 to 4, less on tiny boards)
+ */
+static uint32_t cell_neighbours(gamma_t *g,uint32_t cell,uint32_t *out)
+{
+    uint32_t w=g->width;
+    uint32_t x=cell%w;
+    uint32_t n=0;
+    if(x+1<w)out[n++]=cell+1;
+    if(x>0)out[n++]=cell-1;
+    if(cell/w+1<g->height)out[n++]=cell+w;
+    if(cell>=w)out[n++]=cell-w;
+    return n;
+}
+
+/** 
+ * joins new tile < @p x , @p y > of value @p value of @p g with areas
+ * of the same player next to it in area ids of @p g .
+ */
+static void components_grow(gamma_t *g,uint32_t x,uint32_t y,int value)
+{
+    uint32_t cell=y*g->width+x;
+    uint32_t near[4];
+    uint32_t n=cell_neighbours(g,cell,near);
+    components_add(g->components,cell);
+    for(uint32_t i=0;i<n;i++)
+    {
+        if(cell_get(g,near[i]%g->width,near[i]/g->width)==value)
+        {
+            //new tile joins the area, so the area keeps its root on ties
+            components_join(g->components,near[i],cell);
+        }
+    }
+}
+
+/** 
+ * records change of tile < @p x , @p y > of @p g with value @p old
+ * after checkpoint of @p g .
+ */
+static void undo_record(gamma_t *g,uint32_t x,uint32_t y,int old)
+{
+    struct undo_log *u=g->undo;
+    if(u->length==u->capacity && !u->lost)
+    {
+        size_t capacity=u->capacity*2+64;
+        struct undo_change *changes=realloc(u->changes,capacity*sizeof(struct undo_change));
+        if(changes!=NULL)
+        {
+            u->changes=changes;
+            u->capacity=capacity;
+            STAT_ADD(g,bytes_allocated,capacity*sizeof(struct undo_change));
+        }
+        else u->lost=true;
+    }
+    if(!u->lost)
+    {
+        struct undo_change c={(uint64_t)y*g->width+x,old};
+        u->changes[u->length++]=c;
+    }
+}
+
+/** 
+ * sets value of valid tile < @p x , @p y > of board of @p g to @p value ,
+ * moving the tile between lists of players (lists are dropped if they
+ * can not grow), updating summary of its block and area ids and
+ * recording the change after checkpoint.
+ */
+static void cell_set(gamma_t *g,uint32_t x,uint32_t y,int value)
+{
+    int old=cell_get(g,x,y);
+    uint64_t cell=(uint64_t)y*g->width+x;
+    if(g->undo!=NULL)undo_record(g,x,y,old);
+    if(old!='.')g->hash^=zobrist_cell(cell,old);
+    if(value!='.')g->hash^=zobrist_cell(cell,value);
+    bool grow=false;
+    if(g->components!=NULL && !g->components_stale)
+    {
+        //tiles can not be taken out of areas, they are built again when needed
+        grow=value!='.' && old=='.';
+        g->components_stale=!grow;
+    }
+    if(g->summary!=NULL)
+    {
+        summary_change(summary_at(g->summary,g->summary_columns,x,y),old,value);
+        if(g->players_list!=NULL)
+        {
+            if(old!='.')tile_list_remove(&g->players_list[old-'1'],cell);
+            if(value!='.' && !list_add(g,&g->players_list[value-'1'],cell))lists_drop(g);
+        }
+    }
+    if(g->rle!=NULL)rle_set(&g->rle[y],g->width,x,value);
+    else if(g->tile_columns>0)((int*)g->board)[tiled_index(g->tile_columns,x,y)]=value;
+    else if(g->cell_bytes==1)((uint8_t*)g->board)[(size_t)y*g->width+x]=value;
+    else if(g->cell_bytes==2)((uint16_t*)g->board)[(size_t)y*g->width+x]=value;
+    else g->row[y].line[x]=value;
+    if(grow)components_grow(g,x,y,value);
+}
+
 /** 
  * returns tile < @p x , @p y > value for valid tiles
  * and returns 0 for invalid tiles.
@@ -242,10 +754,47 @@ static bool valid_tile(gamma_t *g,uint32_t x,uint32_t y)
  */
 static uint32_t tile_value(gamma_t *g,uint32_t x,uint32_t y)
 {
-    if(valid_tile(g,x,y))return g->row[y].line[x];
+    if(valid_tile(g,x,y))return cell_get(g,x,y);
     else return 0;
 }
 
+/** 
+ * changes version of player owning tile of value @p value (if any).
+ */
+static void version_touch(gamma_t *g,uint32_t value)
+{
+    if(value!='.' && value!=0)g->players_cache[value-'1'].version++;
+}
+
+/** 
+ * records change of tile < @p x , @p y > of @p g from @p old to its
+ * current value: changes version of game, of both owners and of owners
+ * of neighbouring tiles (free tiles next to them changed).
+ */
+static void versions_bump(gamma_t *g,uint32_t x,uint32_t y,uint32_t old)
+{
+    if(!g->versions_frozen)
+    {
+        g->version++;
+        version_touch(g,old);
+        version_touch(g,cell_get(g,x,y));
+        version_touch(g,tile_value(g,x+1,y));
+        version_touch(g,tile_value(g,x-1,y));
+        version_touch(g,tile_value(g,x,y+1));
+        version_touch(g,tile_value(g,x,y-1));
+    }
+}
+
+/** 
+ * changes versions of game and all players, when something else than
+ * the board changed.
+ */
+static void versions_bump_all(gamma_t *g)
+{
+    g->version++;
+    for(uint32_t i=0;i<g->players;i++)g->players_cache[i].version++;
+}
+
 /** 
  * checks if @p player is vaild for @p g .
  * @p g game which state is to be changed
@@ -257,366 +806,1604 @@ static bool valid_player(gamma_t *g,uint32_t player)
 }
 
 /** 
- * sets @p g->pom arrays values to 0 (unvisited).
+ * update area count for @p player in @p g .
  * @p g -game which state is to be changed
+ * @p player -player number
  */
-static void area_dfs_cleanup(gamma_t *g)
+static void area_rescan_one_player(gamma_t *g,uint32_t player)
 {
-    for(uint32_t i=0;i<g->height;i++)
+    STAT_ADD(g,rescans_one_player,1);
+    uint64_t labeled=label_areas(g,player,player,label_threads);
+    STAT_ADD(g,labeled_tiles,labeled);
+    g->players_cache[player-1].area_exact=true;
+}
+
+/** 
+ * makes area count of @p player in @p g exact, rescanning areas of the
+ * player only if the count is an upper bound.
+ */
+static void area_exact(gamma_t *g,uint32_t player)
+{
+    if(!g->players_cache[player-1].area_exact)area_rescan_one_player(g,player);
+}
+
+/** 
+ * update area count for all players in @p g in one pass over the board.
+ * @p g -game which state is to be changed
+ */
+static void area_rescan_all_players(gamma_t *g)
+{
+    STAT_ADD(g,rescans_all_players,1);
+    uint64_t labeled=label_areas(g,0,0,label_threads);
+    STAT_ADD(g,labeled_tiles,labeled);
+    for(uint32_t i=0;i<g->players;i++)g->players_cache[i].area_exact=true;
+}
+
+/**
+ * checks if board of @p g loaded from snapshot has only free tiles and
+ * tiles of its players, and if amounts of tiles of players and hash of
+ * the game are the same as written in the snapshot.
+ */
+static bool snapshot_board_ok(gamma_t *g)
+{
+    bool result=false;
+    uint64_t *counted=calloc(g->players,sizeof(uint64_t));
+    uint64_t hash=0;
+    for(uint32_t i=0;i<g->players;i++)
+    {
+        if(!g->players_golden[i])hash^=zobrist_golden(i+1);
+    }
+    if(counted!=NULL && g->cells->board_count(g,counted,&hash) && hash==g->hash)
+    {
+        result=true;
+        for(uint32_t i=0;i<g->players && result;i++)result=counted[i]==g->players_tiles[i];
+    }
+    free(counted);
+    return result;
+}
+
+/** 
+ * checks board of @p g loaded by gamma_load and builds summaries of its
+ * blocks and lists of its players from it (lists are dropped if they can
+ * not grow). areas of players written in the snapshot are not trusted,
+ * they are counted again. @p g is marked broken if the board is not
+ * valid or a player has more areas than allowed.
+ */
+static void index_build(gamma_t *g)
+{
+    bool ok=snapshot_board_ok(g);
+    g->index_pending=false;
+    for(uint32_t y=0;y<g->height && ok;y++)
     {
-        for(uint32_t j=0;j<g->width;j++)g->pom[i].line[j]=0;
+        for(uint32_t x=0;x<g->width;x++)
+        {
+            int k=cell_get(g,x,y);
+            if(k!='.')
+            {
+                summary_change(summary_at(g->summary,g->summary_columns,x,y),'.',k);
+                if(g->players_list!=NULL && !list_add(g,&g->players_list[k-'1'],y*g->width+x))
+                {
+                    lists_drop(g);
+                }
+            }
+        }
     }
+    if(ok)area_rescan_all_players(g);
+    for(uint32_t i=0;i<g->players && ok;i++)ok=g->players_area[i]<=g->areas;
+    g->broken=!ok;
+}
+
+/** 
+ * builds what gamma_load left to be built on first use, before the first
+ * query or change of @p g needing it.
+ * @returns false if @p g is NULL or its loaded board is broken
+ */
+static bool index_ready(gamma_t *g)
+{
+    if(g!=NULL && g->index_pending)index_build(g);
+    return g!=NULL && !g->broken;
 }
 
+/** 
+ * checks if one of the tiles next to tile < @p x, @p y >
+ * belong to @p player .
+ * @p g -game which state is to be changed
+ * @p player -player number
+ * @p x -coordinate x of checked tile
+ * @p y -coordinate y of checked tile
+ */
+bool neigbours(gamma_t *g,uint32_t player, uint32_t x, uint32_t y)
+{
+    bool result=false;
+    if(tile_value(g,x+1,y)==player+'0')result=true;
+    else if(tile_value(g,x-1,y)==player+'0')result=true;
+    else if(tile_value(g,x,y+1)==player+'0')result=true;
+    else if(tile_value(g,x,y-1)==player+'0')result=true;
+    return result;
+}
+
+
+/**
+ * checks if valid @p player of @p g can start a new area.
+ * area count of a player is only an upper bound (joined areas are not
+ * subtracted), so at the limit areas of the player are rescanned,
+ * unless the count is known to be exact already.
+ */
+static bool area_room(gamma_t *g,uint32_t player)
+{
+    if(g->players_area[player-1]>=g->areas)area_exact(g,player);
+    return g->players_area[player-1]<g->areas;
+}
+
+/**
+ * counts areas of valid @p player of @p g in memory of its own, without
+ * changing @p g , stopping at @p limit areas. tiles of the player are
+ * taken from list of the player, if it is built, else from whole board.
+ * @returns true if the player has less than @p limit areas, false also
+ * if there is no memory
+ */
+static bool areas_below(gamma_t *g,uint32_t player,uint32_t limit)
+{
+    uint64_t cells=(uint64_t)g->width*g->height;
+    uint64_t *seen=calloc((cells+63)/64,sizeof(uint64_t));
+    uint64_t capacity=64,length=0;
+    uint64_t *stack=malloc(capacity*sizeof(uint64_t));
+    uint32_t areas=0;
+    bool ok=seen!=NULL && stack!=NULL;
+    const struct tile_list *l=NULL;
+    if(g->players_list!=NULL && !g->index_pending)l=&g->players_list[player-1];
+    uint64_t n=l!=NULL ? l->length : cells;
+    for(uint64_t i=0;i<n && ok && areas<limit;i++)
+    {
+        uint64_t start=l!=NULL ? l->cells[i] : i;
+        if((seen[start/64]>>(start%64)&1)==0 && cell_get(g,start%g->width,start/g->width)==(int)('0'+player))
+        {
+            //flood fill of the new area from its first tile
+            areas++;
+            seen[start/64]|=(uint64_t)1<<(start%64);
+            stack[length++]=start;
+            while(length>0 && ok)
+            {
+                uint64_t c=stack[--length];
+                uint32_t x=c%g->width,y=c/g->width;
+                uint32_t near[4][2]={{x+1,y},{x-1,y},{x,y+1},{x,y-1}};
+                for(int j=0;j<4 && ok;j++)
+                {
+                    uint64_t d=(uint64_t)near[j][1]*g->width+near[j][0];
+                    if(tile_value(g,near[j][0],near[j][1])==player+'0' && (seen[d/64]>>(d%64)&1)==0)
+                    {
+                        seen[d/64]|=(uint64_t)1<<(d%64);
+                        if(length==capacity)
+                        {
+                            uint64_t *grown=realloc(stack,capacity*2*sizeof(uint64_t));
+                            ok=grown!=NULL;
+                            if(ok)
+                            {
+                                stack=grown;
+                                capacity*=2;
+                            }
+                        }
+                        if(ok)stack[length++]=d;
+                    }
+                }
+            }
+        }
+    }
+    free(stack);
+    free(seen);
+    return ok && areas<limit;
+}
+
+/**
+ * returns amount of different areas of tiles next to free tile
+ * < @p x , @p y > of @p g with value @p v , read from up to date area ids.
+ */
+static uint32_t areas_next(gamma_t *g,uint32_t x,uint32_t y,int v)
+{
+    uint32_t roots[4];
+    uint32_t near[4];
+    uint32_t result=0;
+    uint32_t n=cell_neighbours(g,y*g->width+x,near);
+    for(uint32_t i=0;i<n;i++)
+    {
+        if(cell_get(g,near[i]%g->width,near[i]/g->width)==v)
+        {
+            uint32_t root=components_find(g->components,near[i]);
+            bool seen=false;
+            for(uint32_t j=0;j<result;j++)seen=seen || roots[j]==root;
+            if(!seen)roots[result++]=root;
+        }
+    }
+    return result;
+}
+
+/**
+ * puts tile of valid @p player on tile < @p x , @p y > of @p g if the
+ * move is legal, without changing versions.
+ */
+static bool move_apply(gamma_t *g,uint32_t player,uint32_t x,uint32_t y)
+{
+    bool result=false;
+    if(tile_value(g,x,y)=='.')
+    {
+        uint32_t v='0'+player;
+        uint32_t own=(tile_value(g,x+1,y)==v)+(tile_value(g,x-1,y)==v)
+                    +(tile_value(g,x,y+1)==v)+(tile_value(g,x,y-1)==v);
+        if(own>0 || area_room(g,player))
+        {
+            if(own==0)g->players_area[player-1]++;
+            //tile next to two own tiles may join two areas, up to date
+            //area ids tell how many
+            else if(own>1 && g->components!=NULL && !g->components_stale)
+            {
+                g->players_area[player-1]-=areas_next(g,x,y,v)-1;
+            }
+            else if(own>1)g->players_cache[player-1].area_exact=false;
+            cell_set(g,x,y,v);
+            g->players_tiles[player-1]++;
+            result=true;
+        }
+    }
+    return result;
+}
+
+bool gamma_move(gamma_t *g, uint32_t player, uint32_t x, uint32_t y)
+{
+    bool result=false;
+    if(index_ready(g) && valid_player(g,player))
+    {
+        result=move_apply(g,player,x,y);
+        if(result)versions_bump(g,x,y,'.');
+    }
+    return result;
+}
+
+bool gamma_move_legal(gamma_t *g, uint32_t player, uint32_t x, uint32_t y)
+{
+    bool result=false;
+    if(g!=NULL && !g->broken && valid_player(g,player) && tile_value(g,x,y)=='.')
+    {
+        //g is not changed: upper bound of areas is checked, when it is
+        //not exact (or not counted yet after load) areas are counted again
+        //without remembering them
+        bool bound=!g->index_pending && g->players_area[player-1]<g->areas;
+        result=neigbours(g,player,x,y) || bound
+            || (!g->players_cache[player-1].area_exact && areas_below(g,player,g->areas));
+    }
+    return result;
+}
+
+/** 
+ * sets bit @p i of @p bits .
+ * @returns true if the bit was not set before
+ */
+static bool bit_set(uint64_t *bits,uint64_t i)
+{
+    uint64_t mask=(uint64_t)1<<(i&63);
+    bool result=(bits[i>>6]&mask)==0;
+    bits[i>>6]|=mask;
+    return result;
+}
+
+/** 
+ * sets bits @p start to @p end (exclusive) of @p bits .
+ */
+static void bits_range(uint64_t *bits,uint64_t start,uint64_t end)
+{
+    while(start<end && (start&63)!=0)bit_set(bits,start++);
+    while(end-start>=64)
+    {
+        bits[start>>6]=UINT64_MAX;
+        start+=64;
+    }
+    while(start<end)bit_set(bits,start++);
+}
+
+/** 
+ * sets bits of free tiles of @p g in zeroed bitmap @p bits .
+ * @returns amount of free tiles
+ */
+static uint64_t empty_bits(gamma_t *g,uint64_t *bits)
+{
+    uint64_t result=0;
+    if(g->cells!=NULL)result=g->cells->empty_bits(g,bits);
+    else if(g->rle!=NULL)
+    {
+        for(uint32_t i=0;i<g->height;i++)
+        {
+            const struct rle_row *r=&g->rle[i];
+            uint64_t first=(uint64_t)i*g->width;
+            for(uint32_t k=0;k<rle_length(r);k++)
+            {
+                uint32_t end;
+                struct rle_run run=rle_run(r,g->width,k,&end);
+                if(run.value=='.')
+                {
+                    bits_range(bits,first+run.start,first+end);
+                    result+=end-run.start;
+                }
+            }
+        }
+    }
+    else
+    {
+        for(uint32_t i=0;i<g->height;i++)
+        {
+            for(uint32_t j=0;j<g->width;j++)
+            {
+                if(cell_get(g,j,i)=='.')result+=bit_set(bits,(uint64_t)i*g->width+j);
+            }
+        }
+    }
+    return result;
+}
+
+/** 
+ * returns amount of free tiles of board of @p g .
+ */
+static uint64_t free_fields_total(gamma_t *g)
+{
+    uint64_t s=0;
+    for(uint32_t i=0;i<g->players;i++)
+    {
+        s=s+g->players_tiles[i];
+    }
+    return (uint64_t)g->height*g->width-s;
+}
+
+/** 
+ * sets bits of free tiles next to tiles of valid @p player of @p g in
+ * zeroed bitmap @p bits , going only through neighbours of tiles of the
+ * player when they are listed, or through free tiles when there are
+ * less of them (full blocks are skipped).
+ * @returns amount of such tiles
+ */
+static uint64_t frontier_bits(gamma_t *g,uint32_t player,uint64_t *bits)
+{
+    uint64_t result=0;
+    if(g->summary!=NULL && free_fields_total(g)<g->players_tiles[player-1])
+    {
+        uint64_t words=((uint64_t)g->width*g->height+63)/64;
+        empty_bits(g,bits);
+        for(uint64_t i=0;i<words;i++)
+        {
+            for(uint64_t word=bits[i];word!=0;word&=word-1)
+            {
+                uint64_t cell=i*64+__builtin_ctzll(word);
+                if(neigbours(g,player,cell%g->width,cell/g->width))result++;
+                else bits[i]&=~((uint64_t)1<<(cell&63));
+            }
+        }
+    }
+    else if(g->players_list!=NULL)
+    {
+        const struct tile_list *l=&g->players_list[player-1];
+        for(uint32_t i=0;i<l->length;i++)
+        {
+            uint32_t near[4];
+            uint32_t n=cell_neighbours(g,l->cells[i],near);
+            for(uint32_t j=0;j<n;j++)
+            {
+                if(cell_get(g,near[j]%g->width,near[j]/g->width)=='.')result+=bit_set(bits,near[j]);
+            }
+        }
+    }
+    else
+    {
+        for(uint32_t i=0;i<g->height;i++)
+        {
+            for(uint32_t j=0;j<g->width;j++)
+            {
+                if(cell_get(g,j,i)=='.' && neigbours(g,player,j,i))
+                {
+                    result+=bit_set(bits,(uint64_t)i*g->width+j);
+                }
+            }
+        }
+    }
+    return result;
+}
+
+uint64_t gamma_legal_moves(gamma_t *g, uint32_t player, uint64_t *bitmap)
+{
+    uint64_t result=0;
+    if(index_ready(g) && bitmap!=NULL && valid_player(g,player))
+    {
+        uint64_t words=((uint64_t)g->width*g->height+63)/64;
+        memset(bitmap,0,words*sizeof(uint64_t));
+        if(area_room(g,player))result=empty_bits(g,bitmap);
+        else result=frontier_bits(g,player,bitmap);
+    }
+    return result;
+}
+
+size_t gamma_move_batch(gamma_t *g, const struct gamma_move_request *moves,
+                        size_t n, bool *results)
+{
+    size_t result=0;
+    if(index_ready(g) && moves!=NULL)
+    {
+        //versions of long batch are bumped once, at the end
+        bool bulk=n>=g->players;
+        bool frozen=g->versions_frozen;
+        if(bulk)g->versions_frozen=true;
+        for(size_t i=0;i<n;i++)
+        {
+            uint32_t player=moves[i].player;
+            bool ok=valid_player(g,player) && move_apply(g,player,moves[i].x,moves[i].y);
+            if(ok)
+            {
+                if(!bulk)versions_bump(g,moves[i].x,moves[i].y,'.');
+                result++;
+            }
+            if(results!=NULL)results[i]=ok;
+        }
+        if(bulk)
+        {
+            g->versions_frozen=frozen;
+            if(result>0 && !frozen)versions_bump_all(g);
+        }
+    }
+    return result;
+}
+
+
+/** 
+ * update area count for @p player1 and @p player2 in @p g .
+ * @p g -game which state is to be changed
+ * @p player1 -player1 number
+ * @p player2 -player2 number
+ */
+static void area_rescan_two_players(gamma_t *g,uint32_t player1,uint32_t player2)
+{
+    STAT_ADD(g,rescans_two_players,1);
+    uint64_t labeled=label_areas(g,player1,player2,label_threads);
+    STAT_ADD(g,labeled_tiles,labeled);
+    g->players_cache[player1-1].area_exact=true;
+    g->players_cache[player2-1].area_exact=true;
+}
+
+
+/** 
+ * sets if valid @p player of @p g still has golden move to @p available ,
+ * keeping hash of @p g up to date.
+ */
+static void golden_set(gamma_t *g,uint32_t player,bool available)
+{
+    if(g->players_golden[player-1]!=available)g->hash^=zobrist_golden(player);
+    g->players_golden[player-1]=available;
+}
+
+bool gamma_golden_move(gamma_t *g, uint32_t player, uint32_t x, uint32_t y)
+{
+    bool result=false;
+    if(index_ready(g))
+    {
+        uint32_t k=tile_value(g,x,y);
+
+        if(valid_player(g,player)&& g->players_golden[player-1]
+           && k!='.'&& (k-'0')!=player && k!=0)
+        {
+            uint32_t p1=g->players_area[k-'1'];
+            uint32_t p2=g->players_area[player-1];
+            bool e1=g->players_cache[k-'1'].area_exact;
+            bool e2=g->players_cache[player-1].area_exact;
+            cell_set(g,x,y,'0'+player);
+            area_rescan_two_players(g,k-'0',player);
+            if((g->players_area[player-1] <= g->areas)
+               && (g->players_area[k-'1'] <= g->areas))
+            {
+                golden_set(g,player,false);
+                g->players_tiles[player-1]++;
+                g->players_tiles[k-'1']--;
+                versions_bump(g,x,y,k);
+                result=true;
+            }
+            else
+            {
+                cell_set(g,x,y,k);
+                g->players_area[player-1]=p2;
+                g->players_area[k-'1']=p1;
+                g->players_cache[player-1].area_exact=e2;
+                g->players_cache[k-'1'].area_exact=e1;
+            }
+        }
+    }
+    return result;
+}
+bool gamma_weak_golden_possible(gamma_t *g, uint32_t player)
+{
+    bool result=false;
+    if(g!=NULL && valid_player(g,player) && g->players_golden[player-1])
+    {
+        uint64_t s=0;
+        for(uint32_t i=0;i<g->players;i++)
+        {
+            if(i!=player-1)s=s+g->players_tiles[i];
+        }
+        if(s>0)result=true;
+    }
+    return result;
+}
+/** 
+ * tries golden move of @p player at tile < @p x , @p y > of @p g and
+ * undoes it.
+ * @returns true if the move is possible
+ */
+static bool golden_trial(gamma_t *g,uint32_t player,uint32_t x,uint32_t y)
+{
+    bool result=false;
+    int k=cell_get(g,x,y);
+    uint32_t p1=0;
+    bool e1=false;
+    if(valid_player(g,k-'0'))
+    {
+        p1=g->players_area[k-'1'];
+        e1=g->players_cache[k-'1'].area_exact;
+    }
+    uint32_t p2=g->players_area[player-1];
+    bool e2=g->players_cache[player-1].area_exact;
+    STAT_ADD(g,golden_possible_trials,1);
+    if(gamma_golden_move(g,player,x,y))
+    {
+        result=true;
+        golden_set(g,player,true);
+        g->players_tiles[player-1]--;
+        g->players_tiles[k-'1']++; 
+        cell_set(g,x,y,k);
+        g->players_area[player-1]=p2;
+        g->players_area[k-'1']=p1;
+        g->players_cache[player-1].area_exact=e2;
+        g->players_cache[k-'1'].area_exact=e1;
+    }
+    return result;
+}
+
+/** 
+ * checks if @p player can make golden move in @p g , trying golden moves
+ * next to @p player tiles if needed.
+ */
+static bool golden_possible(gamma_t *g, uint32_t player)
+{
+    bool possible=false;
+    if(gamma_weak_golden_possible(g,player))
+    {
+        /*jezeli gracz ma mniej obszarow niż wartosc maksymalna i inni maja pola to zawsze
+         mozna wziac pole ktore nie rozdzieli pola innego gracza*/
+        area_exact(g,player);
+        if(g->players_area[player-1]<g->areas)
+        {
+            possible=true;
+        }
+        else
+        {
+            //every trial golden move is undone, so versions stay as they are
+            g->versions_frozen=true;
+            if(g->players_list!=NULL)
+            {
+                //only tiles next to tiles of the player are tried, trial
+                //tiles are added at the end of the list and taken back;
+                //dropped list is left empty, then whole board is tried
+                const struct tile_list *l=&g->players_list[player-1];
+                for(uint32_t i=0;i<l->length && !possible;i++)
+                {
+                    uint32_t near[4];
+                    uint32_t n=cell_neighbours(g,l->cells[i],near);
+                    for(uint32_t j=0;j<n && !possible;j++)
+                    {
+                        uint32_t x=near[j]%g->width,y=near[j]/g->width;
+                        int k=cell_get(g,x,y);
+                        if(k!='.' && k!=(int)('0'+player))possible=golden_trial(g,player,x,y);
+                    }
+                }
+            }
+            uint32_t i=0;
+            while(g->players_list==NULL && i< g->height && !possible)
+            {
+                uint32_t j=0;
+                while(j< g->width && !possible)
+                {
+                    if(neigbours(g,player,j,i))possible=golden_trial(g,player,j,i);
+                    j++;
+                }
+                i++;
+            }
+            g->versions_frozen=false;
+        }
+    }
+    return possible;
+}
+
+bool gamma_golden_possible(gamma_t *g, uint32_t player)
+{
+    bool result=false;
+    if(index_ready(g) && valid_player(g,player))
+    {
+        struct player_cache *c=&g->players_cache[player-1];
+        //answer depends on tiles of all players, so whole game version is checked
+        if(c->golden_version==g->version)
+        {
+            STAT_ADD(g,golden_possible_cached,1);
+            result=c->golden_possible;
+        }
+        else
+        {
+            result=golden_possible(g,player);
+            c->golden_version=g->version;
+            c->golden_possible=result;
+        }
+    }
+    return result;
+}
+
+uint64_t gamma_busy_fields(gamma_t *g, uint32_t player)
+{
+    if(index_ready(g) && valid_player(g,player))return g->players_tiles[player-1];
+    else return 0;
+}
+
+/** row without runs, used as neighbour of first and last row */
+static const struct rle_row rle_empty_row={NULL,0,0,0};
+
+/** 
+ * returns index of first run of @p r not earlier than @p i ,
+ * which ends after column @p s .
+ */
+static uint32_t rle_skip(const struct rle_row *r,uint32_t width,uint32_t i,uint32_t s)
+{
+    uint32_t end=0;
+    bool found=false;
+    while(!found && i<rle_length(r))
+    {
+        rle_run(r,width,i,&end);
+        if(end>s)found=true;
+        else i++;
+    }
+    return i;
+}
+
+/** 
+ * counts tiles of value @p v in columns [ @p s , @p e ) of @p r ,
+ * starting from run @p i .
+ */
+static uint64_t rle_overlap(const struct rle_row *r,uint32_t width,uint32_t i,
+                            int v,uint32_t s,uint32_t e)
+{
+    uint64_t result=0;
+    uint32_t end=0;
+    bool more=true;
+    while(more && i<rle_length(r))
+    {
+        struct rle_run run=rle_run(r,width,i,&end);
+        if(run.start>=e)more=false;
+        else if(run.value==v)result+=(end<e ? end : e)-(run.start>s ? run.start : s);
+        i++;
+    }
+    return result;
+}
+
+/** 
+ * counts columns in [ @p s , @p e ) in which both @p a and @p b have tiles
+ * of value @p v , starting from runs @p i and @p j .
+ */
+static uint64_t rle_overlap_both(const struct rle_row *a,const struct rle_row *b,uint32_t width,
+                                 uint32_t i,uint32_t j,int v,uint32_t s,uint32_t e)
+{
+    uint64_t result=0;
+    bool more=true;
+    while(more && i<rle_length(a) && j<rle_length(b))
+    {
+        uint32_t end_a=0,end_b=0;
+        struct rle_run run_a=rle_run(a,width,i,&end_a);
+        struct rle_run run_b=rle_run(b,width,j,&end_b);
+        if(run_a.start>=e || run_b.start>=e)more=false;
+        else
+        {
+            uint32_t low=run_a.start>run_b.start ? run_a.start : run_b.start;
+            uint32_t high=end_a<end_b ? end_a : end_b;
+            if(low<s)low=s;
+            if(high>e)high=e;
+            if(low<high && run_a.value==v && run_b.value==v)result+=high-low;
+            if(end_a<end_b)i++;
+            else j++;
+        }
+    }
+    return result;
+}
+
+/** 
+ * count amount of free tiles next to @p player tiles in rle board of @p g ,
+ * working on runs: for every empty run tiles touching runs of the player
+ * in rows above and below are counted (with inclusion-exclusion),
+ * and both ends of the run are checked against runs next to it.
+ */
+static uint64_t empty_fields_next_player_rle(gamma_t *g,uint32_t player)
+{
+    uint64_t result=0;
+    int v='0'+player;
+    uint32_t w=g->width;
+    for(uint32_t y=0;y<g->height;y++)
+    {
+        const struct rle_row *r=&g->rle[y];
+        const struct rle_row *up=y>0 ? &g->rle[y-1] : &rle_empty_row;
+        const struct rle_row *down=y+1<g->height ? &g->rle[y+1] : &rle_empty_row;
+        uint32_t i_up=0,i_down=0;
+        int previous=0;
+        for(uint32_t i=0;i<rle_length(r);i++)
+        {
+            uint32_t e=0;
+            struct rle_run run=rle_run(r,w,i,&e);
+            uint32_t s=run.start;
+            if(run.value=='.')
+            {
+                i_up=rle_skip(up,w,i_up,s);
+                i_down=rle_skip(down,w,i_down,s);
+                result+=rle_overlap(up,w,i_up,v,s,e)+rle_overlap(down,w,i_down,v,s,e)
+                    -rle_overlap_both(up,down,w,i_up,i_down,v,s,e);
+                uint32_t next_end=0;
+                bool left=previous==v && rle_get(up,s)!=v && rle_get(down,s)!=v;
+                bool right=i+1<rle_length(r) && rle_run(r,w,i+1,&next_end).value==v
+                    && rle_get(up,e-1)!=v && rle_get(down,e-1)!=v && !(left && e-1==s);
+                result+=left+right;
+            }
+            previous=run.value;
+        }
+    }
+    return result;
+}
+
+/** 
+ * count amount of free tiles next to @p player tiles in board of @p g
+ * split into blocks, block by block: neighbours inside of the block are
+ * read directly, only tiles on block border look into other blocks.
+ */
+static uint64_t empty_fields_next_player_tiled(gamma_t *g,uint32_t player)
+{
+    uint64_t result=0;
+    int v='0'+player;
+    for(uint32_t by=0;by<g->height;by+=TILED_SIDE)
+    {
+        uint32_t ny=g->height-by>TILED_SIDE ? TILED_SIDE : g->height-by;
+        for(uint32_t bx=0;bx<g->width;bx+=TILED_SIDE)
+        {
+            uint32_t nx=g->width-bx>TILED_SIDE ? TILED_SIDE : g->width-bx;
+            const int *block=(const int*)g->board+tiled_index(g->tile_columns,bx,by);
+            //blocks of tiles inside of skipped block of summaries are not read
+            uint32_t rows=ny;
+            if(summary_skip(g,bx>>SUMMARY_COLUMN_BITS,by>>SUMMARY_ROW_BITS,summary_bit(v)))
+            {
+                STAT_ADD(g,summary_skipped_tiles,nx*ny);
+                rows=0;
+            }
+            for(uint32_t y=0;y<rows;y++)
+            {
+                const int *cell=block+y*TILED_SIDE;
+                for(uint32_t x=0;x<nx;x++)
+                {
+                    const int *c=cell+x;
+                    if(*c=='.')
+                    {
+                        bool p;
+                        if(x+1<nx)p=c[1]==v;
+                        else p=tile_value(g,bx+x+1,by+y)==(uint32_t)v;
+                        if(!p && x>0)p=*(c-1)==v;
+                        else if(!p)p=tile_value(g,bx+x-1,by+y)==(uint32_t)v;
+                        if(!p && y+1<ny)p=c[TILED_SIDE]==v;
+                        else if(!p)p=tile_value(g,bx+x,by+y+1)==(uint32_t)v;
+                        if(!p && y>0)p=*(c-TILED_SIDE)==v;
+                        else if(!p)p=tile_value(g,bx+x,by+y-1)==(uint32_t)v;
+                        result+=p;
+                    }
+                }
+            }
+        }
+    }
+    return result;
+}
+
+/** 
+ * count amount of free tiles next to @p player tiles in board of @p g
+ * going through list of tiles of the player, counted tiles are marked
+ * in visited marks and cleared afterwards.
+ */
+static uint64_t empty_fields_next_player_list(gamma_t *g,uint32_t player)
+{
+    const struct tile_list *l=&g->players_list[player-1];
+    uint64_t result=0;
+    for(uint32_t i=0;i<l->length;i++)
+    {
+        uint32_t near[4];
+        uint32_t n=cell_neighbours(g,l->cells[i],near);
+        for(uint32_t j=0;j<n;j++)
+        {
+            uint32_t c=near[j];
+            if(g->visited[c]==0 && cell_get(g,c%g->width,c/g->width)=='.')
+            {
+                g->visited[c]=1;
+                result++;
+            }
+        }
+    }
+    for(uint32_t i=0;i<l->length;i++)
+    {
+        uint32_t near[4];
+        uint32_t n=cell_neighbours(g,l->cells[i],near);
+        for(uint32_t j=0;j<n;j++)g->visited[near[j]]=0;
+    }
+    return result;
+}
+
+/** 
+ * count amount of free tiles nex to to @p player tiles in board of @p g .
+ * @p g -game which state is to be changed
+ * @p player -player number
+ */
+static uint64_t empty_fields_next_player(gamma_t *g,uint32_t player)
+{
+    uint64_t result=0;
+    if(g!=NULL && g->players_list!=NULL
+       && (uint64_t)g->players_list[player-1].length*TILE_LIST_RATIO<(uint64_t)g->width*g->height)
+    {
+        result=empty_fields_next_player_list(g,player);
+    }
+    else if(g!=NULL && g->rle!=NULL)
+    {
+        STAT_ADD(g,empty_fields_scans,1);
+        result=empty_fields_next_player_rle(g,player);
+    }
+    else if(g!=NULL && g->tile_columns>0)
+    {
+        STAT_ADD(g,empty_fields_scans,1);
+        result=empty_fields_next_player_tiled(g,player);
+    }
+    else if(g!=NULL)
+    {
+        STAT_ADD(g,empty_fields_scans,1);
+        result=g->cells->empty_fields(g,player);
+    }
+    return result;
+}
+
+
+/** 
+ * checks if remembered result of gamma_free_fields in @p c is valid
+ * for current state of @p g .
+ */
+static bool free_fields_valid(gamma_t *g,const struct player_cache *c)
+{
+    return c->free_version==c->version && (c->free_global==0 || c->free_global==g->version);
+}
+
+/** 
+ * remembers @p result as free fields of @p player in @p g , @p global
+ * -result counts all free tiles, so any move changes it.
+ */
+static void free_fields_store(gamma_t *g,uint32_t player,uint64_t result,bool global)
+{
+    struct player_cache *c=&g->players_cache[player-1];
+    c->free_global=global ? g->version : 0;
+    c->free_version=c->version;
+    c->free_fields=result;
+}
+
+uint64_t gamma_free_fields(gamma_t *g, uint32_t player)
+{
+    uint64_t result=0;
+    if(index_ready(g) && valid_player(g,player))
+    {
+        struct player_cache *c=&g->players_cache[player-1];
+        if(free_fields_valid(g,c))
+        {
+            STAT_ADD(g,free_fields_cached,1);
+            result=c->free_fields;
+        }
+        else
+        {
+            if(g->players_area[player-1]==g->areas)area_exact(g,player);
+            bool global=g->players_area[player-1]<g->areas;
+            if(global)result=free_fields_total(g);
+            else result=empty_fields_next_player(g,player);
+            free_fields_store(g,player,result,global);
+        }
+    }
+    return result;
+}
+
+bool gamma_all_busy_fields(gamma_t *g, uint64_t *out)
+{
+    bool result=false;
+    if(index_ready(g) && out!=NULL)
+    {
+        memcpy(out,g->players_tiles,(size_t)g->players*sizeof(uint64_t));
+        result=true;
+    }
+    return result;
+}
+
+bool gamma_all_free_fields(gamma_t *g, uint64_t *out)
+{
+    bool result=false;
+    if(index_ready(g) && out!=NULL)
+    {
+        //players with maximal amount of areas, no remembered result and
+        //area count which is only an upper bound need area recount, more
+        //of them are recounted in one pass
+        uint32_t stale=0;
+        for(uint32_t i=0;i<g->players;i++)
+        {
+            const struct player_cache *c=&g->players_cache[i];
+            if(!free_fields_valid(g,c) && g->players_area[i]==g->areas && !c->area_exact)stale++;
+        }
+        if(stale>1)area_rescan_all_players(g);
+        //free tiles next to many players with many tiles are counted in one pass
+        uint32_t limited=0;
+        uint64_t tiles=0;
+        for(uint32_t i=0;i<g->players;i++)
+        {
+            if(!free_fields_valid(g,&g->players_cache[i]) && g->players_area[i]>=g->areas)
+            {
+                limited++;
+                tiles+=g->players_tiles[i];
+            }
+        }
+        bool pass=limited>1 && g->cells!=NULL && tiles*TILE_LIST_RATIO>=(uint64_t)g->width*g->height;
+        if(pass)
+        {
+            STAT_ADD(g,empty_fields_scans,1);
+            memset(out,0,(size_t)g->players*sizeof(uint64_t));
+            g->cells->empty_fields_all(g,out);
+        }
+        uint64_t total=free_fields_total(g);
+        for(uint32_t i=0;i<g->players;i++)
+        {
+            struct player_cache *c=&g->players_cache[i];
+            if(free_fields_valid(g,c))
+            {
+                STAT_ADD(g,free_fields_cached,1);
+                out[i]=c->free_fields;
+            }
+            else
+            {
+                if(g->players_area[i]==g->areas)area_exact(g,i+1);
+                bool global=g->players_area[i]<g->areas;
+                if(global)out[i]=total;
+                else if(!pass)out[i]=empty_fields_next_player(g,i+1);
+                free_fields_store(g,i+1,out[i],global);
+            }
+        }
+        result=true;
+    }
+    return result;
+}
+
+
+/** 
+ * counts tiles of value @p v in rectangle with corners < @p x0 , @p y0 >
+ * and < @p x1 , @p y1 > (inclusive, inside of the board) of @p g ,
+ * tile by tile.
+ */
+static uint64_t rect_scan(gamma_t *g,int v,uint32_t x0,uint32_t y0,uint32_t x1,uint32_t y1)
+{
+    uint64_t result=0;
+    if(g->cells!=NULL)result=g->cells->rect_count(g,v,x0,y0,x1,y1);
+    else
+    {
+        for(uint32_t i=y0;i<=y1;i++)
+        {
+            for(uint32_t j=x0;j<=x1;j++)result+=cell_get(g,j,i)==v;
+        }
+    }
+    return result;
+}
+
+/** 
+ * counts tiles of value @p v in rectangle of @p g (as in rect_scan) block
+ * by block: parts of blocks which summary tells the count for (no such
+ * tiles, only such tiles, or whole block) are not read.
+ */
+static uint64_t rect_blocks(gamma_t *g,int v,uint32_t x0,uint32_t y0,uint32_t x1,uint32_t y1)
+{
+    uint64_t result=0;
+    for(uint32_t by=y0>>SUMMARY_ROW_BITS;by<=y1>>SUMMARY_ROW_BITS;by++)
+    {
+        uint32_t top=by<<SUMMARY_ROW_BITS;
+        uint32_t r0=top>y0 ? top : y0;
+        uint32_t r1=y1-top>=SUMMARY_ROWS ? top+SUMMARY_ROWS-1 : y1;
+        for(uint32_t bx=x0>>SUMMARY_COLUMN_BITS;bx<=x1>>SUMMARY_COLUMN_BITS;bx++)
+        {
+            uint32_t left=bx<<SUMMARY_COLUMN_BITS;
+            uint32_t c0=left>x0 ? left : x0;
+            uint32_t c1=x1-left>=SUMMARY_COLUMNS ? left+SUMMARY_COLUMNS-1 : x1;
+            const struct block_summary *b=g->summary+(size_t)by*g->summary_columns+bx;
+            uint64_t area=(uint64_t)(c1-c0+1)*(r1-r0+1);
+            bool whole=area==(uint64_t)b->empty+b->busy;
+            bool known=true;
+            if(v=='.')
+            {
+                if(b->busy==0)result+=area;
+                else if(whole)result+=b->empty;
+                else known=b->empty==0;
+            }
+            else if(summary_may_have(b,v))
+            {
+                bool only=b->owner==(uint32_t)v;
+                if(only && b->empty==0)result+=area;
+                else if(only && whole)result+=b->busy;
+                else known=false;
+            }
+            if(known)STAT_ADD(g,summary_skipped_tiles,area);
+            else result+=rect_scan(g,v,c0,r0,c1,r1);
+        }
+    }
+    return result;
+}
+
+uint64_t gamma_count_rect(gamma_t *g, uint32_t player, uint32_t x0, uint32_t y0,
+                          uint32_t x1, uint32_t y1)
+{
+    uint64_t result=0;
+    if(index_ready(g) && (player==0 || valid_player(g,player)) && valid_tile(g,x0,y0)
+       && x0<=x1 && y0<=y1)
+    {
+        if(x1>=g->width)x1=g->width-1;
+        if(y1>=g->height)y1=g->height-1;
+        int v=player==0 ? '.' : (int)('0'+player);
+        uint64_t area=(uint64_t)(x1-x0+1)*(y1-y0+1);
+        if(area==(uint64_t)g->width*g->height)
+        {
+            result=player==0 ? free_fields_total(g) : g->players_tiles[player-1];
+        }
+        else if(g->rle!=NULL)
+        {
+            for(uint32_t i=y0;i<=y1;i++)result+=rle_count(&g->rle[i],g->width,x0,x1,v);
+        }
+        else if(player>0 && g->players_list!=NULL
+                && (uint64_t)g->players_list[player-1].length*TILE_LIST_RATIO<area)
+        {
+            //player with few tiles: its tiles are checked instead of the rectangle
+            const struct tile_list *l=&g->players_list[player-1];
+            for(uint32_t i=0;i<l->length;i++)
+            {
+                uint32_t x=l->cells[i]%g->width,y=l->cells[i]/g->width;
+                result+=x>=x0 && x<=x1 && y>=y0 && y<=y1;
+            }
+        }
+        else result=rect_blocks(g,v,x0,y0,x1,y1);
+    }
+    return result;
+}
+
+/** 
+ * makes area ids of @p g up to date, building them again in one pass
+ * over the board if they are stale or were not built yet.
+ * @returns false if board has too many tiles or there is no memory
+ */
+static bool components_ready(gamma_t *g)
+{
+    uint64_t cells=(uint64_t)g->width*g->height;
+    if(g->components==NULL && cells<UINT32_MAX)
+    {
+        g->components=malloc(sizeof(struct components));
+        if(g->components!=NULL && !components_init(g->components,cells))
+        {
+            free(g->components);
+            g->components=NULL;
+        }
+        if(g->components!=NULL)STAT_ADD(g,bytes_allocated,sizeof(struct components)+cells*2*sizeof(uint32_t));
+        g->components_stale=true;
+    }
+    if(g->components!=NULL && g->components_stale)
+    {
+        for(uint32_t i=0;i<g->height;i++)
+        {
+            for(uint32_t j=0;j<g->width;j++)
+            {
+                int v=cell_get(g,j,i);
+                uint32_t cell=i*g->width+j;
+                if(v!='.')
+                {
+                    components_add(g->components,cell);
+                    if(j>0 && cell_get(g,j-1,i)==v)components_join(g->components,cell,cell-1);
+                    if(i>0 && cell_get(g,j,i-1)==v)components_join(g->components,cell,cell-g->width);
+                }
+            }
+        }
+        g->components_stale=false;
+    }
+    return g->components!=NULL;
+}
+
+uint64_t gamma_area_id(gamma_t *g, uint32_t x, uint32_t y)
+{
+    uint64_t result=0;
+    if(index_ready(g) && valid_tile(g,x,y) && cell_get(g,x,y)!='.' && components_ready(g))
+    {
+        result=(uint64_t)components_find(g->components,y*g->width+x)+1;
+    }
+    return result;
+}
+
+uint64_t gamma_area_size(gamma_t *g, uint64_t id)
+{
+    uint64_t result=0;
+    if(index_ready(g) && id>0 && id<=(uint64_t)g->width*g->height && components_ready(g))
+    {
+        uint32_t cell=id-1;
+        //only roots of sets of taken tiles are areas
+        if(g->components->parent[cell]==cell && cell_get(g,cell%g->width,cell/g->width)!='.')
+        {
+            result=g->components->size[cell];
+        }
+    }
+    return result;
+}
 
 /** 
- * basic stack implementation
- * availible : pop and push
- * @p x tile x coordinate
- * @p y tile y coordinate
- * @p next is pointer to lower elements in stack
- */
-struct stack{
-    uint32_t x;
-    uint32_t y;
-    struct stack *next;
-};
-
-/** adds tile coordinates to stack.
- * @p s -pointer to stack pointer
- * @p x -tile x coordinate
- * @p y -tile y coordinate
- * @p r -pointer to stack size
+ * counts area of tile @p cell of value @p v of @p g if the tile is root
+ * of its set, storing its id in @p ids if there is still room in it.
  */
-static void push(struct stack **s,uint32_t x,uint32_t y,uint64_t *r)
-{
-    struct stack *a=NULL;
-    a=malloc(sizeof *a);
-    if(a==NULL)exit(1);
-    a->x=x;
-    a->y=y;
-    a->next=*s;
-    *s=a;
-    *r=*r+1;
-}
-/** copies tile from top of the stack and removes stack top node.
- * @p s -pointer to stack pointer
- * @p x -pointer to coordinate x of tile
- * @p y -pointer to coordinate y of tile
- * @p r -pointer to stack size
- *  */
-static void pop(struct stack **s,uint32_t *x,uint32_t *y,uint64_t *r)
+static void player_area_add(gamma_t *g,uint32_t cell,int v,uint64_t *ids,uint64_t size,uint64_t *count)
 {
-    struct stack *a=*s;
-    *x=a->x;
-    *y=a->y;
-    *r=*r-1;
-    *s=a->next;
-    free(a);
+    if(g->components->parent[cell]==cell && cell_get(g,cell%g->width,cell/g->width)==v)
+    {
+        if(ids!=NULL && *count<size)ids[*count]=(uint64_t)cell+1;
+        (*count)++;
+    }
 }
 
-
-/** 
- * marks all tiles in the same area as starting point to visited state 
- *  (tile in g->pom =1).
- * @param g- pointer to current game state
- * @param x- current tile column (indexed from 0)
- * @param y- current tile line (indexed from 0)
- * @param p- value of starting tile (one on which the function is called first)
- */
-static void area_dfs(gamma_t *g,uint32_t x,uint32_t y,uint32_t p)
+uint64_t gamma_player_areas(gamma_t *g, uint32_t player, uint64_t *ids, uint64_t size)
 {
-    uint64_t r=0;
-    struct stack *s=NULL;
-    push(&s,x,y,&r);
-    g->pom[y].line[x]=1;
-    while(r>0)
+    uint64_t result=0;
+    if(index_ready(g) && valid_player(g,player) && components_ready(g))
     {
-        pop(&s,&x,&y,&r);
-        if(tile_value(g,x+1,y)==p && (g->pom[y].line[x+1]==0))
+        int v='0'+player;
+        if(g->players_list!=NULL)
         {
-            push(&s,x+1,y,&r);
-            g->pom[y].line[x+1]=1;
+            const struct tile_list *l=&g->players_list[player-1];
+            for(uint32_t i=0;i<l->length;i++)player_area_add(g,l->cells[i],v,ids,size,&result);
         }
-        if(tile_value(g,x-1,y)==p && (g->pom[y].line[x-1]==0))
+        else
         {
-            push(&s,x-1,y,&r);
-            g->pom[y].line[x-1]=1;
+            uint32_t cells=g->width*g->height;
+            for(uint32_t i=0;i<cells;i++)player_area_add(g,i,v,ids,size,&result);
         }
-        if(tile_value(g,x,y+1)==p && (g->pom[y+1].line[x]==0))
+        //count of areas is exact now
+        g->players_area[player-1]=result;
+        g->players_cache[player-1].area_exact=true;
+    }
+    return result;
+}
+
+uint32_t gamma_field(gamma_t *g, uint32_t x, uint32_t y)
+{
+    uint32_t result=0;
+    if(index_ready(g) && valid_tile(g,x,y) && cell_get(g,x,y)!='.')
+    {
+        result=cell_get(g,x,y)-'0';
+    }
+    return result;
+}
+
+bool gamma_set_field(gamma_t *g, uint32_t player, uint32_t x, uint32_t y)
+{
+    bool result=false;
+    if(index_ready(g) && valid_tile(g,x,y) && (player==0 || valid_player(g,player)))
+    {
+        uint32_t k=tile_value(g,x,y);
+        if(k!='.')
         {
-            push(&s,x,y+1,&r);
-            g->pom[y+1].line[x]=1;
+            g->players_tiles[k-'1']--;
+            g->players_cache[k-'1'].area_exact=false;
         }
-        if(tile_value(g,x,y-1)==p && (g->pom[y-1].line[x]==0))
+        if(player==0)cell_set(g,x,y,'.');
+        else
         {
-            push(&s,x,y-1,&r);
-            g->pom[y-1].line[x]=1;
+            cell_set(g,x,y,'0'+player);
+            g->players_tiles[player-1]++;
+            g->players_cache[player-1].area_exact=false;
         }
+        versions_bump(g,x,y,k);
+        result=true;
     }
+    return result;
 }
 
 /** 
- * update area count for @p player in @p g .
- * @p g -game which state is to be changed
- * @p player -player number
+ * makes room for one more checkpoint in undo log of @p g .
+ * @returns false if there is no memory
  */
-static void area_rescan_one_player(gamma_t *g,uint32_t player)
+static bool undo_grow(gamma_t *g)
 {
-    uint32_t k=0;
-    g->players_area[player-1]=0;
-    for(uint32_t i=0;i<g->height;i++)
+    struct undo_log *u=g->undo;
+    uint32_t players=g->players;
+    bool result=true;
+    if(u->depth==u->level_capacity)
     {
-        for(uint32_t j=0;j<g->width;j++)
+        size_t capacity=(size_t)u->level_capacity*2+4;
+        size_t items=capacity*players;
+        struct undo_level *levels=realloc(u->levels,capacity*sizeof(struct undo_level));
+        if(levels!=NULL)u->levels=levels;
+        uint32_t *area=realloc(u->players_area,items*sizeof(uint32_t));
+        if(area!=NULL)u->players_area=area;
+        uint64_t *tiles=realloc(u->players_tiles,items*sizeof(uint64_t));
+        if(tiles!=NULL)u->players_tiles=tiles;
+        bool *golden=realloc(u->players_golden,items*sizeof(bool));
+        if(golden!=NULL)u->players_golden=golden;
+        bool *exact=realloc(u->area_exact,items*sizeof(bool));
+        if(exact!=NULL)u->area_exact=exact;
+        result=levels!=NULL && area!=NULL && tiles!=NULL && golden!=NULL && exact!=NULL;
+        if(result)
         {
-            k=tile_value(g,j,i);
-            if((k=='0'+player)&&(g->pom[i].line[j]==0))
-            {
-                area_dfs(g,j,i,k);
-                g->players_area[player-1]++;
-            }
+            u->level_capacity=capacity;
+            STAT_ADD(g,bytes_allocated,capacity*sizeof(struct undo_level)
+                     +items*(sizeof(uint32_t)+sizeof(uint64_t)+2*sizeof(bool)));
         }
     }
-    area_dfs_cleanup(g);
-}
-
-/** 
- * checks if one of the tiles next to tile < @p x, @p y >
- * belong to @p player .
- * @p g -game which state is to be changed
- * @p player -player number
- * @p x -coordinate x of checked tile
- * @p y -coordinate y of checked tile
- */
-bool neigbours(gamma_t *g,uint32_t player, uint32_t x, uint32_t y)
-{
-    bool result=false;
-    if(tile_value(g,x+1,y)==player+'0')result=true;
-    else if(tile_value(g,x-1,y)==player+'0')result=true;
-    else if(tile_value(g,x,y+1)==player+'0')result=true;
-    else if(tile_value(g,x,y-1)==player+'0')result=true;
     return result;
 }
 
-
-bool gamma_move(gamma_t *g, uint32_t player, uint32_t x, uint32_t y)
+bool gamma_checkpoint(gamma_t *g)
 {
     bool result=false;
-    if(g!=NULL && tile_value(g,x,y)=='.'&&valid_player(g,player))
+    if(index_ready(g))
     {
-        g->row[y].line[x]='0'+player;
-        if(neigbours(g,player,x,y)==false)
+        if(g->undo==NULL)
         {
-            g->players_area[player-1]++;
+            g->undo=calloc(1,sizeof(struct undo_log));
+            if(g->undo!=NULL)STAT_ADD(g,bytes_allocated,sizeof(struct undo_log));
         }
-        if(g->players_area[player-1] == g->areas+1)area_rescan_one_player(g,player);
-        if(g->players_area[player-1] <= g->areas)
+        struct undo_log *u=g->undo;
+        if(u!=NULL && undo_grow(g))
         {
-            g->players_tiles[player-1]++;
+            size_t first=(size_t)u->depth*g->players;
+            memcpy(u->players_area+first,g->players_area,(size_t)g->players*sizeof(uint32_t));
+            memcpy(u->players_tiles+first,g->players_tiles,(size_t)g->players*sizeof(uint64_t));
+            memcpy(u->players_golden+first,g->players_golden,(size_t)g->players*sizeof(bool));
+            for(uint32_t i=0;i<g->players;i++)u->area_exact[first+i]=g->players_cache[i].area_exact;
+            u->levels[u->depth].length=u->length;
+            u->levels[u->depth].hash=g->hash;
+            u->depth++;
             result=true;
         }
-        else
-        {
-            g->row[y].line[x]='.';
-            if(neigbours(g,player,x,y)==false)g->players_area[player-1]--;
-        }
-
+        else if(u!=NULL && u->depth==0)undo_drop(g);
     }
     return result;
 }
 
-
-/** 
- * update area count for @p player1 and @p player2 in @p g .
- * @p g -game which state is to be changed
- * @p player1 -player1 number
- * @p player2 -player2 number
- */
-static void area_rescan_two_players(gamma_t *g,uint32_t player1,uint32_t player2)
+bool gamma_rollback(gamma_t *g)
 {
-    uint32_t k=0;
-    g->players_area[player1-1]=0;
-    g->players_area[player2-1]=0;
-
-    for(uint32_t i=0;i<g->height;i++)
+    bool result=false;
+    if(index_ready(g) && g->undo!=NULL)
     {
-        for(uint32_t j=0;j<g->width;j++)
+        struct undo_log *u=g->undo;
+        if(u->lost)undo_drop(g);
+        else
         {
-            k=tile_value(g,j,i);
-            if((k=='0'+player1)&&(g->pom[i].line[j]==0))
-            {
-                area_dfs(g,j,i,k);
-                g->players_area[player1-1]++;
-            }
-            else if((k=='0'+player2)&&(g->pom[i].line[j]==0))
+            const struct undo_level *l=&u->levels[u->depth-1];
+            size_t first=(size_t)(u->depth-1)*g->players;
+            //changes of rollback itself are not recorded
+            g->undo=NULL;
+            for(size_t i=u->length;i>l->length;i--)
             {
-                area_dfs(g,j,i,k);
-                g->players_area[player2-1]++;
+                const struct undo_change *c=&u->changes[i-1];
+                cell_set(g,c->cell%g->width,c->cell/g->width,c->old);
             }
+            g->undo=u;
+            //area ids lost the taken back tiles, they are built again now,
+            //so that moves after rollback keep counts of areas exact
+            if(g->components!=NULL && u->length>l->length)components_ready(g);
+            //board is the same as at checkpoint, so are counters of players
+            memcpy(g->players_area,u->players_area+first,(size_t)g->players*sizeof(uint32_t));
+            memcpy(g->players_tiles,u->players_tiles+first,(size_t)g->players*sizeof(uint64_t));
+            memcpy(g->players_golden,u->players_golden+first,(size_t)g->players*sizeof(bool));
+            for(uint32_t i=0;i<g->players;i++)g->players_cache[i].area_exact=u->area_exact[first+i];
+            g->hash=l->hash;
+            if(u->length>l->length)versions_bump_all(g);
+            u->length=l->length;
+            result=true;
         }
     }
-    area_dfs_cleanup(g);
+    return result;
 }
 
-
-bool gamma_golden_move(gamma_t *g, uint32_t player, uint32_t x, uint32_t y)
+bool gamma_checkpoint_drop(gamma_t *g)
 {
     bool result=false;
-    if(g!=NULL)
+    if(g!=NULL && g->undo!=NULL)
     {
-        uint32_t k=tile_value(g,x,y);
-
-        if(valid_player(g,player)&& g->players_golden[player-1]
-           && k!='.'&& (k-'0')!=player && k!=0)
-        {
-            uint32_t p1=g->players_area[k-'1'];
-            uint32_t p2=g->players_area[player-1];
-            g->row[y].line[x]='0'+player;
-            area_rescan_two_players(g,k-'0',player);
-            if((g->players_area[player-1] <= g->areas)
-               && (g->players_area[k-'1'] <= g->areas))
-            {
-                g->players_golden[player-1]=false;
-                g->players_tiles[player-1]++;
-                g->players_tiles[k-'1']--;
-                result=true;
-            }
-            else
-            {
-                g->row[y].line[x]=k;
-                g->players_area[player-1]=p2;
-                g->players_area[k-'1']=p1;
-            }
-        }
+        //changes after the checkpoint now belong to the one before it
+        g->undo->depth--;
+        if(g->undo->depth==0)undo_drop(g);
+        result=true;
     }
     return result;
 }
-bool gamma_weak_golden_possible(gamma_t *g, uint32_t player)
+
+uint64_t gamma_hash(gamma_t *g)
+{
+    uint64_t result=0;
+    if(index_ready(g))result=g->hash;
+    return result;
+}
+
+bool gamma_set_golden(gamma_t *g, uint32_t player, bool available)
 {
     bool result=false;
-    if(g!=NULL && valid_player(g,player) && g->players_golden[player-1])
+    if(index_ready(g) && valid_player(g,player))
     {
-        uint64_t s=0;
-        for(uint32_t i=0;i<g->players;i++)
-        {
-            if(i!=player-1)s=s+g->players_tiles[i];
-        }
-        if(s>0)result=true;
+        golden_set(g,player,available);
+        g->version++;
+        result=true;
     }
     return result;
 }
-bool gamma_golden_possible(gamma_t *g, uint32_t player)
+
+void gamma_recount_areas(gamma_t *g)
 {
-    bool possible=false;
-    if(gamma_weak_golden_possible(g,player))
+    if(index_ready(g))
     {
-        /*jezeli gracz ma mniej obszarow niż wartosc maksymalna i inni maja pola to zawsze
-         mozna wziac pole ktore nie rozdzieli pola innego gracza*/
-        area_rescan_one_player(g,player);
-        if(g->players_area[player-1]<g->areas)
+        area_rescan_all_players(g);
+        versions_bump_all(g);
+    }
+}
+
+bool gamma_stats(gamma_t *g, struct gamma_stats *out)
+{
+    bool result=false;
+    if(g!=NULL && out!=NULL)
+    {
+        memset(out,0,sizeof *out);
+#ifdef GAMMA_STATS
+        out->counters_enabled=true;
+        out->counters=g->counters;
+#endif
+        out->board_mapped=g->map!=NULL;
+        out->pages=g->pages;
+        if(g->rle!=NULL)
         {
-            possible=true;
+            for(uint32_t i=0;i<g->height;i++)
+            {
+                out->board_bytes+=(uint64_t)g->rle[i].capacity*sizeof(struct rle_run);
+            }
+            out->rows_bytes=(uint64_t)g->height*sizeof(struct rle_row);
+        }
+        else if(g->tile_columns>0)
+        {
+            out->board_bytes=g->tile_columns*tiled_blocks(g->height)*TILED_SIDE*TILED_SIDE*sizeof(int);
+            out->visited_bytes=(uint64_t)g->width*g->height*sizeof(int);
         }
         else
         {
-            uint32_t i=0;
-            while(i< g->height && !possible)
+            out->board_bytes=(uint64_t)g->width*g->height*g->cell_bytes;
+            out->visited_bytes=(uint64_t)g->width*g->height*sizeof(int);
+            out->rows_bytes=(uint64_t)g->height*sizeof(struct line);
+        }
+        out->players_bytes=(uint64_t)g->players*(sizeof(uint32_t)+sizeof(uint64_t)+sizeof(bool)
+                                                 +sizeof(struct player_cache));
+        if(g->players_list!=NULL)
+        {
+            out->lists_bytes=(uint64_t)g->players*sizeof(struct tile_list);
+            for(uint32_t i=0;i<g->players;i++)
             {
-                uint32_t j=0;
-                while(j< g->width && !possible)
-                {
-                    int k=g->row[i].line[j];
-                    uint32_t p1=0;
-                    if(valid_player(g,k-'0'))
-                    {
-                        p1=g->players_area[k-'1'];
-                    }
-                    uint32_t p2=g->players_area[player-1];
-                    if(neigbours(g,player, j, i) && gamma_golden_move(g,player,j,i))
-                    {
-                        possible=true;
-                        g->players_golden[player-1]=true;
-                        g->players_tiles[player-1]--;
-                        g->players_tiles[k-'1']++; 
-                        g->row[i].line[j]=k;
-                        g->players_area[player-1]=p2;
-                        g->players_area[k-'1']=p1;
-                    }
-                    j++;
-                }
-                i++;
+                out->lists_bytes+=(uint64_t)g->players_list[i].capacity*sizeof(uint32_t);
             }
         }
+        if(g->summary!=NULL)
+        {
+            out->summary_bytes=(uint64_t)g->summary_columns*g->summary_rows*sizeof(struct block_summary);
+        }
+        if(g->components!=NULL)
+        {
+            out->components_bytes=sizeof(struct components)
+                +(uint64_t)g->components->cells*2*sizeof(uint32_t);
+        }
+        if(g->undo!=NULL)
+        {
+            const struct undo_log *u=g->undo;
+            out->undo_bytes=sizeof *u+u->level_capacity*(sizeof(struct undo_level)
+                +(uint64_t)g->players*(sizeof(uint32_t)+sizeof(uint64_t)+2*sizeof(bool)))
+                +u->capacity*sizeof(struct undo_change);
+        }
+        out->struct_bytes=sizeof *g;
+        out->scratch_bytes=g->scratch_size*sizeof(uint32_t);
+        out->total_bytes=out->board_bytes+out->visited_bytes+out->rows_bytes
+            +out->players_bytes+out->lists_bytes+out->summary_bytes+out->components_bytes
+            +out->undo_bytes+out->struct_bytes+out->scratch_bytes;
+        result=true;
     }
-    return possible;
+    return result;
 }
 
-uint64_t gamma_busy_fields(gamma_t *g, uint32_t player)
+/** snapshot file layout version */
+#define SNAPSHOT_VERSION 2
+/** value used to detect snapshots written on machine with different byte order */
+#define SNAPSHOT_BYTE_ORDER 0x01020304u
+/** board in snapshot starts at multiple of this value, so it can be mapped directly */
+#define SNAPSHOT_ALIGN 4096
+
+/** 
+ * header of snapshot file, followed by:
+ * players_tiles, players_area, players_golden arrays,
+ * padding to SNAPSHOT_ALIGN and board rows of @p cell_size byte cells.
+ */
+struct snapshot_header{
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t cell_size;
+    uint32_t width;
+    uint32_t height;
+    uint32_t players;
+    uint32_t areas;
+    uint32_t reserved;
+    uint64_t players_offset;
+    uint64_t board_offset;
+    uint64_t file_size;
+    uint64_t hash;
+};
+
+/** 
+ * fills header of snapshot for game @p g .
+ */
+static void snapshot_header_setup(gamma_t *g,struct snapshot_header *h)
 {
-    if(g!=NULL && valid_player(g,player))return g->players_tiles[player-1];
-    else return 0;
+    memset(h,0,sizeof *h);
+    memcpy(h->magic,"GAMMASNP",8);
+    h->version=SNAPSHOT_VERSION;
+    h->byte_order=SNAPSHOT_BYTE_ORDER;
+    h->cell_size=g->cell_bytes;
+    h->width=g->width;
+    h->height=g->height;
+    h->players=g->players;
+    h->areas=g->areas;
+    h->players_offset=sizeof *h;
+    uint64_t end=h->players_offset+(uint64_t)g->players*(sizeof(uint64_t)+sizeof(uint32_t)+sizeof(bool));
+    h->board_offset=(end+SNAPSHOT_ALIGN-1)/SNAPSHOT_ALIGN*SNAPSHOT_ALIGN;
+    h->file_size=h->board_offset+(uint64_t)g->width*g->height*g->cell_bytes;
+    h->hash=g->hash;
 }
 
 /** 
- * count amount of free tiles nex to to @p player tiles in board of @p g .
- * @p g -game which state is to be changed
- * @p player -player number
+ * writes values of all tiles of row @p y of rle board or board split
+ * into blocks of @p g to @p line .
  */
-static uint64_t empty_fields_next_player(gamma_t *g,uint32_t player)
+static void row_expand(gamma_t *g,uint32_t y,int *line)
 {
-    uint64_t result=0;
-    if(g!=NULL)
+    if(g->tile_columns>0)
     {
-        for(uint32_t i=0;i<g->height;i++)
+        for(uint32_t x=0;x<g->width;x+=TILED_SIDE)
         {
-            for(uint32_t j=0;j<g->width;j++)
-            {
-                if(g->row[i].line[j]=='.')
-                {
-                    int p=0;
-                    if(tile_value(g,j+1,i)=='0'+player)p=1;
-                    if(tile_value(g,j-1,i)=='0'+player)p=1;
-                    if(tile_value(g,j,i+1)=='0'+player)p=1;
-                    if(tile_value(g,j,i-1)=='0'+player)p=1;
-                    if(p==1)result++;
-                }
-            }
+            uint32_t n=g->width-x>TILED_SIDE ? TILED_SIDE : g->width-x;
+            memcpy(line+x,(const int*)g->board+tiled_index(g->tile_columns,x,y),n*sizeof(int));
         }
     }
-    return result;
+    else for(uint32_t i=0;i<rle_length(&g->rle[y]);i++)
+    {
+        uint32_t end=0;
+        struct rle_run run=rle_run(&g->rle[y],g->width,i,&end);
+        for(uint32_t x=run.start;x<end;x++)line[x]=run.value;
+    }
 }
 
-
-uint64_t gamma_free_fields(gamma_t *g, uint32_t player)
+bool gamma_save(gamma_t *g, const char *path)
 {
-    uint64_t result=0;
-    if(g!=NULL && valid_player(g,player))
+    bool result=false;
+    FILE *f=NULL;
+    if(g!=NULL && path!=NULL)f=fopen(path,"wb");
+    if(f!=NULL)
     {
-        if(g->players_area[player-1]==g->areas)area_rescan_one_player(g,player);
-        if(g->players_area[player-1]<g->areas)
+        struct snapshot_header h;
+        snapshot_header_setup(g,&h);
+        result=fwrite(&h,sizeof h,1,f)==1
+            && fwrite(g->players_tiles,sizeof(uint64_t),g->players,f)==g->players
+            && fwrite(g->players_area,sizeof(uint32_t),g->players,f)==g->players
+            && fwrite(g->players_golden,sizeof(bool),g->players,f)==g->players;
+        uint64_t position=h.players_offset+(uint64_t)g->players*(sizeof(uint64_t)+sizeof(uint32_t)+sizeof(bool));
+        while(result && position<h.board_offset)
         {
-            uint64_t s=0;
-            for(uint32_t i=0;i<g->players;i++)
-            {
-                s=s+g->players_tiles[i];
-            }
-            result=g->height*g->width-s;
+            result=fputc(0,f)!=EOF;
+            position++;
         }
-        else
+        int *line=NULL;
+        bool expand=g->rle!=NULL || g->tile_columns>0;
+        if(expand)
+        {
+            line=malloc((size_t)g->width*sizeof(int));
+            if(line==NULL)result=false;
+        }
+        for(uint32_t i=0;i<g->height && result;i++)
         {
-            result=empty_fields_next_player(g,player);
+            //array board is written as it is, with its cell size
+            const char *row=(const char*)g->board+(size_t)i*g->width*g->cell_bytes;
+            if(expand)row_expand(g,i,line);
+            result=fwrite(expand ? (const char*)line : row,g->cell_bytes,g->width,f)==g->width;
         }
+        free(line);
+        if(fclose(f)!=0)result=false;
     }
     return result;
 }
 
+/** 
+ * checks if header @p h describes valid snapshot of file of @p size bytes.
+ */
+static bool snapshot_header_ok(const struct snapshot_header *h,uint64_t size)
+{
+    bool ok=memcmp(h->magic,"GAMMASNP",8)==0 && h->version==SNAPSHOT_VERSION
+        && h->byte_order==SNAPSHOT_BYTE_ORDER
+        && (h->cell_size==1 || h->cell_size==2 || h->cell_size==sizeof(int))
+        && h->width>0 && h->height>0 && h->players>0 && h->areas>0
+        && cell_bytes_for(h->players)<=h->cell_size && board_size_ok(h->width,h->height);
+    if(ok)
+    {
+        struct snapshot_header expected;
+        gamma_t dimensions;
+        dimensions.width=h->width;
+        dimensions.height=h->height;
+        dimensions.players=h->players;
+        dimensions.areas=h->areas;
+        dimensions.cell_bytes=h->cell_size;
+        dimensions.hash=h->hash;
+        snapshot_header_setup(&dimensions,&expected);
+        ok=h->players_offset==expected.players_offset
+            && h->board_offset==expected.board_offset
+            && h->file_size==expected.file_size && h->file_size<=size;
+    }
+    return ok;
+}
+
+gamma_t* gamma_load(const char *path)
+{
+    gamma_t *g=NULL;
+    int fd=-1;
+    struct stat st;
+    if(path!=NULL)fd=open(path,O_RDONLY);
+    if(fd>=0 && fstat(fd,&st)==0 && (uint64_t)st.st_size>=sizeof(struct snapshot_header))
+    {
+        //private mapping: moves made after load do not change the file
+        void *map=mmap(NULL,st.st_size,PROT_READ|PROT_WRITE,MAP_PRIVATE,fd,0);
+        if(map!=MAP_FAILED)
+        {
+            struct snapshot_header h;
+            memcpy(&h,map,sizeof h);
+            if(snapshot_header_ok(&h,st.st_size))
+            {
+                g=gamma_setup(h.width,h.height,h.players,h.areas,h.cell_size,ARENA_MAPPED);
+            }
+            if(g!=NULL)
+            {
+                const char *players=(const char*)map+h.players_offset;
+                memcpy(g->players_tiles,players,h.players*sizeof(uint64_t));
+                players+=h.players*sizeof(uint64_t);
+                memcpy(g->players_area,players,h.players*sizeof(uint32_t));
+                players+=h.players*sizeof(uint32_t);
+                for(uint32_t i=0;i<h.players;i++)
+                {
+                    //any byte other than 0 means golden move is left
+                    g->players_golden[i]=((const unsigned char*)players)[i]!=0;
+                }
+                g->hash=h.hash;
+                g->map=map;
+                g->map_size=st.st_size;
+                g->board=(char*)map+h.board_offset;
+                if(g->cell_bytes==sizeof(int))row_attach(g->row,g->board,h.width,h.height);
+                //board is read only by the first query or move needing it,
+                //which checks it and builds summaries and lists
+                g->index_pending=true;
+            }
+            else munmap(map,st.st_size);
+        }
+    }
+    if(fd>=0)close(fd);
+    return g;
+}
 
 /**
  * sets fragment of string to printout to represantation of given tile
 */
 void tile_print(gamma_t *g,uint32_t y, uint32_t x,char *s,int length)
 {
-    uint32_t p=g->row[y].line[x];
+    uint32_t p=cell_get(g,x,y);
     if(p!='.')
     {
         p=p-'0';
@@ -644,52 +2431,109 @@ void tile_print(gamma_t *g,uint32_t y, uint32_t x,char *s,int length)
     }
     
 }
-char* gamma_board(gamma_t *g)
+/** 
+ * prints rle board of @p g to @p result run by run, @p length is amount
+ * of digits of player numbers (0 if there are less than 10 players).
+ */
+static void board_print_rle(gamma_t *g,char *result,int length)
 {
-    char *result=NULL;
-    if(g!=NULL)
+    //every tile takes cell characters, rows end with new line
+    size_t cell=length>0 ? length+1 : 1;
+    size_t line=(size_t)g->width*cell+1;
+    for(uint32_t i=0;i<g->height;i++)
     {
-        if(g->players<10)
+        char *row=result+(size_t)(g->height-i-1)*line;
+        for(uint32_t k=0;k<rle_length(&g->rle[i]);k++)
         {
-            result=malloc((g->height* (g->width+1)+1) *sizeof(char));
-            if(result!=NULL)
+            uint32_t end=0;
+            struct rle_run run=rle_run(&g->rle[i],g->width,k,&end);
+            if(length==0)memset(row+run.start,run.value,end-run.start);
+            else
             {
-                for(uint32_t i=0;i<g->height;i++)
-                {
-                    for(uint32_t j=0;j<g->width;j++)result[(g->width+1)*(g->height-i-1)+j]=g->row[i].line[j];
-                    result[(g->width+1)*(g->height-i)-1]='\n';
-                }
-                result[g->height*(g->width+1)]=0;
+                tile_print(g,i,run.start,row+run.start*cell,length);
+                row[run.start*cell+length]='|';
+                for(uint32_t x=run.start+1;x<end;x++)memcpy(row+x*cell,row+run.start*cell,cell);
             }
         }
-        else
+        row[line-1]='\n';
+    }
+    result[(size_t)g->height*line]=0;
+}
+
+/** 
+ * prints board of @p g split into blocks, with less than 10 players,
+ * to @p result row by row, copying whole rows of blocks at once.
+ */
+static void board_print_tiled(gamma_t *g,char *result)
+{
+    size_t line=(size_t)g->width+1;
+    for(uint32_t i=0;i<g->height;i++)
+    {
+        char *row=result+(size_t)(g->height-i-1)*line;
+        for(uint32_t x=0;x<g->width;x+=TILED_SIDE)
+        {
+            const int *block=(const int*)g->board+tiled_index(g->tile_columns,x,i);
+            uint32_t n=g->width-x>TILED_SIDE ? TILED_SIDE : g->width-x;
+            for(uint32_t k=0;k<n;k++)row[x+k]=block[k];
+        }
+        row[line-1]='\n';
+    }
+    result[(size_t)g->height*line]=0;
+}
+
+char* gamma_board_into(gamma_t *g,char *buffer,size_t *size)
+{
+    char *result=NULL;
+    if(index_ready(g) && size!=NULL)
+    {
+        int length=0;
+        if(g->players>=10)
         {
             int k=g->players;
-            int length=0;
             while(k>0)
             {
                 k=k/10;
                 length++;
             }
-            result=malloc((g->height*(g->width*(length+1)+1)+1)*sizeof(char));
+        }
+        //one character per tile, or length digits and separator
+        size_t line=g->players<10 ? g->width+1 : (size_t)g->width*(length+1)+1;
+        size_t needed=(size_t)g->height*line+1;
+        result=buffer;
+        if(*size<needed)
+        {
+            result=realloc(buffer,needed*sizeof(char));
             if(result!=NULL)
             {
-                for(uint32_t i=0;i<g->height;i++)
+                STAT_ADD(g,bytes_allocated,needed);
+                *size=needed;
+            }
+        }
+        if(result!=NULL && g->rle!=NULL)board_print_rle(g,result,length);
+        else if(result!=NULL && g->tile_columns>0 && g->players<10)board_print_tiled(g,result);
+        else if(result!=NULL && g->players<10)g->cells->board_print(g,result);
+        else if(result!=NULL)
+        {
+            for(uint32_t i=0;i<g->height;i++)
+            {
+                for(uint32_t j=0;j<g->width;j++)
                 {
-                    for(uint32_t j=0;j<g->width;j++)
-                    {
-                        tile_print(g ,i ,j ,result +(g->height-i-1) *(g->width *(length+1) +1) +j*(length+1), length);
-                        result[ (g->height-i-1) *(g->width* (length+1) +1) +j *(length+1) +length]='|';
-                    }
-                    result[(g->width*(length+1)+1)*(g->height-i)-1]='\n';
+                    tile_print(g ,i ,j ,result +(g->height-i-1) *(g->width *(length+1) +1) +j*(length+1), length);
+                    result[ (g->height-i-1) *(g->width* (length+1) +1) +j *(length+1) +length]='|';
                 }
-                result[g->height*(g->width*(length+1)+1)]=0;
+                result[(g->width*(length+1)+1)*(g->height-i)-1]='\n';
             }
+            result[g->height*(g->width*(length+1)+1)]=0;
         }
-        
     }
     return result;
 }
+
+char* gamma_board(gamma_t *g)
+{
+    size_t size=0;
+    return gamma_board_into(g,NULL,&size);
+}
 /** @brief write inverse ANSI code to char table starting at index *i.
  */ 
 void write_inverse(char* c,int *i)
@@ -810,7 +2654,7 @@ char* gamma_board_interactive_less_than_10(gamma_t *g,uint32_t current_player, u
             uint64_t y=g->height-j-1;
             for(uint64_t x=0; x< g->width; x++)
             {
-                if(g->row[y].line[x]-'0'==player)
+                if(cell_get(g,x,y)-'0'==player)
                 {
                     write_background_green_color(result,&i);
                 }
@@ -819,14 +2663,14 @@ char* gamma_board_interactive_less_than_10(gamma_t *g,uint32_t current_player, u
                     write_inverse(result,&i);
                 }
 
-                result[i]= g->row[y].line[x];
+                result[i]= cell_get(g,x,y);
                 i++;
 
                 if(y==cursor_y && x==cursor_x)
                 {
                     write_end_inverse(result,&i);
                 }   
-                if(g->row[y].line[x]-'0'==player)
+                if(cell_get(g,x,y)-'0'==player)
                 {
                     write_background_black_color(result,&i);
                 }
@@ -865,7 +2709,7 @@ char* gamma_board_interactive_more_than_9(gamma_t *g,uint32_t current_player, ui
             uint64_t y=g->height-j-1;
             for(uint64_t x=0; x< g->width; x++)
             {
-                if(g->row[y].line[x]-'0'==player)
+                if(cell_get(g,x,y)-'0'==player)
                 {
                     write_background_green_color(result, &i);
                 }
@@ -873,12 +2717,12 @@ char* gamma_board_interactive_more_than_9(gamma_t *g,uint32_t current_player, ui
                 {
                     write_inverse(result,&i);
                 }
-                write_tile(result, &i, g->row[y].line[x], length);
+                write_tile(result, &i, cell_get(g,x,y), length);
                 if(y==cursor_y && x==cursor_x)
                 {
                     write_end_inverse(result, &i);
                 } 
-                if(g->row[y].line[x]-'0'==player)
+                if(cell_get(g,x,y)-'0'==player)
                 {
                     write_background_black_color(result, &i);
                 }
@@ -896,7 +2740,7 @@ char* gamma_board_interactive_more_than_9(gamma_t *g,uint32_t current_player, ui
 char*  gamma_board_interactive(gamma_t *g,uint32_t current_player, uint32_t cursor_x,uint32_t cursor_y)
 {
     char *result=NULL;
-    if(g!=NULL)
+    if(index_ready(g))
     {
         if(g->players<10)
         {
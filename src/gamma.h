@@ -11,10 +11,127 @@
 #define GAMMA_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 /**
- * Struktura przechowująca stan gry.
+ * Liczniki kosztownych operacji silnika. Są aktualizowane tylko wtedy, gdy
+ * program skompilowano z GAMMA_STATS (opcja CMake o tej samej nazwie),
+ * w przeciwnym wypadku nie zajmują miejsca w @ref gamma i nie kosztują nic:
+ * rescans_one_player -przeliczenia obszarów jednego gracza (całej planszy
+ *      lub, gdy gracz ma mało pól, jego listy pól),
+ * rescans_two_players -przeliczenia obszarów dwóch graczy (jak wyżej),
+ * rescans_all_players -przeliczenia obszarów wszystkich graczy,
+ * labeled_tiles -pola etykietowane przy przeliczaniu obszarów,
+ * golden_possible_trials -próbne złote ruchy w gamma_golden_possible,
+ * empty_fields_scans -przejścia planszy liczące wolne pola obok gracza,
+ * free_fields_cached -wyniki @ref gamma_free_fields wzięte z pamięci
+ *      podręcznej (bez liczenia),
+ * golden_possible_cached -wyniki @ref gamma_golden_possible wzięte
+ *      z pamięci podręcznej,
+ * summary_skipped_tiles -pola pominięte przy przejściach planszy dzięki
+ *      podsumowaniom bloków (bez wolnych pól lub z dala od pól gracza),
+ * bytes_allocated -łączna liczba bajtów zaalokowanych przez silnik dla gry.
+ */
+struct gamma_counters{
+    uint64_t rescans_one_player;
+    uint64_t rescans_two_players;
+    uint64_t rescans_all_players;
+    uint64_t labeled_tiles;
+    uint64_t golden_possible_trials;
+    uint64_t empty_fields_scans;
+    uint64_t free_fields_cached;
+    uint64_t golden_possible_cached;
+    uint64_t summary_skipped_tiles;
+    uint64_t bytes_allocated;
+};
+
+/**
+ * Rodzaj stron pamięci, na których umieszczono grę:
+ * GAMMA_PAGES_NORMAL -zwykłe strony (blok zaalokowany przez calloc),
+ * GAMMA_PAGES_TRANSPARENT -zwykłe strony, które jądro może łączyć
+ *      w strony 2 MB (madvise(MADV_HUGEPAGE)),
+ * GAMMA_PAGES_HUGE -strony 2 MB zarezerwowane w systemie (MAP_HUGETLB).
+ */
+enum gamma_pages{
+    GAMMA_PAGES_NORMAL,
+    GAMMA_PAGES_TRANSPARENT,
+    GAMMA_PAGES_HUGE
+};
+
+/**
+ * Struktura przechowująca stan gry:
+ * width -szerokość planszy,
+ * height -wysokość planszy,
+ * players -liczba graczy,
+ * areas -maksymalna liczba obszarów jednego gracza,
+ * row -tablica wierszy planszy, wskazujących na kolejne fragmenty @p board
+ *      (tylko dla pól 4-bajtowych),
+ * rle -tablica wierszy planszy zakodowanych jako ciągi pól tej samej
+ *      wartości (@ref GAMMA_STORAGE_RLE) lub NULL – wtedy @p row, @p board
+ *      i @p visited nie są używane,
+ * board -ciągły blok pamięci z zawartością planszy (wiersz po wierszu,
+ *      a przy @p tile_columns > 0 blokami, zob. tiled.h) złożony z pól
+ *      o rozmiarze @p cell_bytes,
+ * cell_bytes -rozmiar pola planszy w bajtach: 1, 2 lub 4 dla tablicy pól
+ *      zapisanej wiersz po wierszu (najmniejszy, w którym mieści się numer
+ *      gracza), 4 dla pozostałych sposobów przechowywania,
+ * cells -funkcje przechodzące tablicę pól o rozmiarze @p cell_bytes
+ *      (NULL, jeśli plansza nie jest zapisana wiersz po wierszu),
+ * tile_columns -liczba bloków w jednym rzędzie bloków planszy podzielonej
+ *      na bloki (@ref GAMMA_STORAGE_TILED) lub 0 – wtedy @p board jest
+ *      zapisana wiersz po wierszu, a przy planszy podzielonej na bloki
+ *      @p row nie jest używane,
+ * visited -ciągły blok pamięci używany przy przeliczaniu obszarów
+ *      (poza nim wyzerowany),
+ * summary -podsumowania bloków planszy (summary.h): liczba wolnych
+ *      i zajętych pól, jedyny właściciel pól bloku, o ile jest, i maska
+ *      graczy, którzy mogą mieć w nim pola, uaktualniane przy każdej
+ *      zmianie pola (NULL dla
+ *      @ref GAMMA_STORAGE_RLE),
+ * summary_columns, summary_rows -liczba bloków podsumowań w rzędzie
+ *      bloków i liczba rzędów bloków,
+ * map -obszar pamięci, w którym zmapowano plik z zapisem gry, lub NULL,
+ *      jeśli plansza została zaalokowana (@p board wskazuje wtedy do
+ *      wnętrza tego obszaru),
+ * map_size -rozmiar zmapowanego obszaru,
+ * players_golden -czy gracz może jeszcze wykonać złoty ruch,
+ * players_area -liczba obszarów każdego gracza,
+ * players_tiles -liczba pól każdego gracza,
+ * players_list -lista pól każdego gracza (tile_list.h), dzięki której
+ *      przeliczanie obszarów i liczenie pól obok gracza o niewielu polach
+ *      nie przechodzi całej planszy (NULL dla @ref GAMMA_STORAGE_RLE),
+ * index_pending -czy planszę gry wczytanej przez @ref gamma_load trzeba
+ *      jeszcze sprawdzić, przeliczyć obszary graczy i zbudować z niej
+ *      podsumowania bloków i listy pól (robi to pierwsze pytanie lub ruch,
+ *      który ich potrzebuje),
+ * broken -czy wczytana plansza okazała się uszkodzona (gra odrzuca wtedy
+ *      wszystkie ruchy i pytania),
+ * players_cache -wersje stanu każdego gracza (zmieniane przy każdej
+ *      zmianie jego pól lub wolnych pól obok nich), zapamiętane wyniki
+ *      @ref gamma_free_fields i @ref gamma_golden_possible oraz to, czy
+ *      liczba obszarów gracza jest dokładna, a nie tylko oszacowaniem
+ *      z góry,
+ * components -obszary wszystkich graczy jako zbiory rozłączne
+ *      (components.h), tworzone przy pierwszym pytaniu o obszary
+ *      (@ref gamma_area_id), uzupełniane przy każdym ruchu zwykłym
+ *      i budowane od nowa po zabraniu pola (NULL, dopóki nikt nie pytał),
+ * components_stale -czy @p components trzeba zbudować od nowa,
+ * undo -stan gry w zagnieżdżonych punktach kontrolnych
+ *      (@ref gamma_checkpoint) i zmiany pól wykonane po pierwszym z nich
+ *      lub NULL,
+ * hash -skrót Zobrista gry (@ref gamma_hash), zmieniany przy każdej
+ *      zmianie pola i złotego ruchu,
+ * version -wersja całej gry, zmieniana przy każdej zmianie planszy,
+ * versions_frozen -czy wersje nie są zmieniane (próbne ruchy, po których
+ *      plansza wraca do poprzedniego stanu),
+ * scratch -pomocnicza tablica przeliczania obszarów (liczniki obszarów
+ *      w pasach planszy), powiększana w razie potrzeby,
+ * scratch_size -pojemność @p scratch (w liczbach),
+ * arena_size -rozmiar bloku pamięci, w którym umieszczono strukturę
+ *      i wszystkie jej tablice (poza @p scratch i zmapowaną planszą),
+ * pages -rodzaj stron pamięci tego bloku (@ref gamma_huge_pages),
+ * counters -liczniki operacji (tylko z GAMMA_STATS).
  */
 struct gamma{
     uint32_t width;
@@ -22,13 +139,59 @@ struct gamma{
     uint32_t players;
     uint32_t  areas;
     struct line *row;
-    struct line *pom;
+    struct rle_row *rle;
+    void *board;
+    uint32_t cell_bytes;
+    const struct cell_ops *cells;
+    uint32_t tile_columns;
+    int *visited;
+    struct block_summary *summary;
+    uint32_t summary_columns;
+    uint32_t summary_rows;
+    void *map;
+    uint64_t map_size;
     bool *players_golden;
     uint32_t *players_area;
     uint64_t *players_tiles;
+    struct tile_list *players_list;
+    bool index_pending;
+    bool broken;
+    struct player_cache *players_cache;
+    struct components *components;
+    bool components_stale;
+    struct undo_log *undo;
+    uint64_t hash;
+    uint64_t version;
+    bool versions_frozen;
+    uint32_t *scratch;
+    uint64_t scratch_size;
+    uint64_t arena_size;
+    enum gamma_pages pages;
+#ifdef GAMMA_STATS
+    struct gamma_counters counters;
+#endif
 };
 typedef struct gamma gamma_t;
 
+/**
+ * Sposób przechowywania planszy:
+ * GAMMA_STORAGE_ARRAY -tablica pól (1 bajt na pole do 207 graczy, 2 bajty
+ *      do 65487 graczy, inaczej 4 bajty, do tego 4 bajty na pole do
+ *      przeliczania obszarów),
+ * GAMMA_STORAGE_RLE -wiersze jako ciągi pól tej samej wartości, zmiana pola
+ *      kosztuje O(log liczby ciągów w wierszu), a pamięć zależy od liczby
+ *      ciągów, a nie pól – opłaca się przy dużych jednolitych obszarach,
+ * GAMMA_STORAGE_TILED -tablica pól podzielona na bloki 8x8 pól, sąsiednie
+ *      pola w pionie leżą blisko siebie w pamięci – opłaca się przy
+ *      szerokich planszach, na których wiersze nie mieszczą się w pamięci
+ *      podręcznej.
+ */
+enum gamma_storage{
+    GAMMA_STORAGE_ARRAY,
+    GAMMA_STORAGE_RLE,
+    GAMMA_STORAGE_TILED
+};
+
 /** @brief Tworzy strukturę przechowującą stan gry.
  * Alokuje pamięć na nową strukturę przechowującą stan gry.
  * Inicjuje tę strukturę tak, aby reprezentowała początkowy stan gry.
@@ -43,6 +206,22 @@ typedef struct gamma gamma_t;
 gamma_t* gamma_new(uint32_t width, uint32_t height,
                    uint32_t players, uint32_t areas);
 
+/** @brief Tworzy strukturę przechowującą stan gry z wybraną planszą.
+ * Działa jak @ref gamma_new, ale pozwala wybrać sposób przechowywania
+ * planszy. Gra wczytana przez @ref gamma_load zawsze używa tablicy pól.
+ * @param[in] width   – szerokość planszy, liczba dodatnia,
+ * @param[in] height  – wysokość planszy, liczba dodatnia,
+ * @param[in] players – liczba graczy, liczba dodatnia,
+ * @param[in] areas   – maksymalna liczba obszarów,
+ *                      jakie może zająć jeden gracz, liczba dodatnia,
+ * @param[in] storage – sposób przechowywania planszy.
+ * @return Wskaźnik na utworzoną strukturę lub NULL, gdy nie udało się
+ * zaalokować pamięci lub któryś z parametrów jest niepoprawny.
+ */
+gamma_t* gamma_new_storage(uint32_t width, uint32_t height,
+                           uint32_t players, uint32_t areas,
+                           enum gamma_storage storage);
+
 /** @brief Usuwa strukturę przechowującą stan gry.
  * Usuwa z pamięci strukturę wskazywaną przez @p g.
  * Nic nie robi, jeśli wskaźnik ten ma wartość NULL.
@@ -50,6 +229,37 @@ gamma_t* gamma_new(uint32_t width, uint32_t height,
  */
 void gamma_delete(gamma_t *g);
 
+/** @brief Ustala rozmiar puli zwolnionych gier.
+ * Gra usunięta przez @ref gamma_delete trafia do puli bieżącego wątku
+ * (jeśli pula nie jest pełna), a @ref gamma_new wykorzystuje ponownie
+ * blok o takim samym rozmiarze zamiast alokować nowy. Domyślnie pula jest
+ * wyłączona. Zmniejszenie rozmiaru zwalnia nadmiarowe bloki.
+ * @param[in] blocks  – maksymalna liczba bloków w puli, 0 wyłącza pulę.
+ */
+void gamma_pool_limit(size_t blocks);
+
+/** @brief Ustala liczbę wątków przeliczających obszary.
+ * Pełne przeliczenie obszarów dzieli planszę na pasy wierszy etykietowane
+ * równolegle, a następnie łączy obszary stykające się na granicach pasów.
+ * Małe plansze są zawsze przeliczane przez jeden wątek.
+ * @param[in] threads – maksymalna liczba wątków, 0 oznacza jeden wątek
+ *                      na procesor (domyślnie).
+ */
+void gamma_threads(uint32_t threads);
+
+/** @brief Ustala, od jakiego rozmiaru gra jest umieszczana na dużych stronach.
+ * Blok pamięci gry (struktura, plansza i tablica odwiedzin) o rozmiarze
+ * co najmniej @p min_bytes jest mapowany na stronach 2 MB (MAP_HUGETLB),
+ * a gdy system ich nie udostępnia – na zwykłych stronach z prośbą
+ * o łączenie ich w duże (madvise(MADV_HUGEPAGE)), a w ostateczności
+ * alokowany zwyczajnie. Zmniejsza to liczbę chybień w TLB przy dostępach
+ * do dużych plansz. Takie bloki nie trafiają do puli zwolnionych gier.
+ * Wybrany rodzaj stron podaje @ref gamma_stats.
+ * @param[in] min_bytes – najmniejszy rozmiar bloku na dużych stronach,
+ *                        0 wyłącza duże strony, domyślnie 256 MB.
+ */
+void gamma_huge_pages(uint64_t min_bytes);
+
 /** @brief Wykonuje ruch.
  * Ustawia pionek gracza @p player na polu (@p x, @p y).
  * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
@@ -64,6 +274,64 @@ void gamma_delete(gamma_t *g);
  */
 bool gamma_move(gamma_t *g, uint32_t player, uint32_t x, uint32_t y);
 
+/**
+ * Ruch dla @ref gamma_move_batch:
+ * player -numer gracza,
+ * x, y -współrzędne pola.
+ */
+struct gamma_move_request{
+    uint32_t player;
+    uint32_t x;
+    uint32_t y;
+};
+
+/** @brief Wykonuje ciąg ruchów.
+ * Wykonuje po kolei ruchy @p moves tak, jak kolejne wywołania
+ * @ref gamma_move, ale szybciej: parametry gry są sprawdzane raz, a przy
+ * długich ciągach wersje zapamiętanych wyników zapytań są zmieniane raz,
+ * na końcu.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] moves   – tablica @p n ruchów,
+ * @param[in] n       – liczba ruchów,
+ * @param[out] results – tablica @p n wyników (wynik @ref gamma_move dla
+ *                      każdego ruchu) lub NULL.
+ * @return Liczba wykonanych ruchów, zero, gdy @p g lub @p moves jest NULL.
+ */
+size_t gamma_move_batch(gamma_t *g, const struct gamma_move_request *moves,
+                        size_t n, bool *results);
+
+/** @brief Sprawdza, czy ruch jest legalny.
+ * Podaje wynik, jaki dałoby wywołanie @ref gamma_move, ale nie zmienia
+ * stanu gry. Gdy liczba obszarów gracza jest tylko oszacowaniem z góry,
+ * a ruch tworzy nowy obszar, obszary gracza są liczone w osobnej pamięci
+ * przy każdym wywołaniu (wynik nie jest zapamiętywany). Gdy brakuje na to
+ * pamięci, wynikiem jest @p false.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza, liczba dodatnia niewiększa od wartości
+ *                      @p players z funkcji @ref gamma_new,
+ * @param[in] x       – numer kolumny,
+ * @param[in] y       – numer wiersza.
+ * @return Wartość @p true, jeśli ruch jest legalny, a @p false,
+ * gdy nie jest lub któryś z parametrów jest niepoprawny.
+ */
+bool gamma_move_legal(gamma_t *g, uint32_t player, uint32_t x, uint32_t y);
+
+/** @brief Podaje wszystkie legalne ruchy gracza.
+ * Ustawia w @p bitmap bity pól (@p x, @p y), na których @ref gamma_move
+ * gracza @p player by się udał (bit numer @p y * @p width + @p x,
+ * bit k w słowie k / 64 na pozycji k % 64), a pozostałe zeruje.
+ * Gracz, który może zacząć nowy obszar, może zająć każde wolne pole
+ * (bloki planszy bez wolnych pól są pomijane), a pozostali tylko wolne
+ * pola obok swoich pól (przeglądane przez listę pól gracza).
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza, liczba dodatnia niewiększa od wartości
+ *                      @p players z funkcji @ref gamma_new,
+ * @param[out] bitmap – tablica (@p width * @p height + 63) / 64 słów.
+ * @return Liczba legalnych ruchów lub zero, gdy któryś z parametrów jest
+ * niepoprawny.
+ */
+uint64_t gamma_legal_moves(gamma_t *g, uint32_t player, uint64_t *bitmap);
+
 /** @brief Wykonuje złoty ruch.
  * Ustawia pionek gracza @p player na polu (@p x, @p y) zajętym przez innego
  * gracza, usuwając pionek innego gracza.
@@ -101,6 +369,91 @@ uint64_t gamma_busy_fields(gamma_t *g, uint32_t player);
  */
 uint64_t gamma_free_fields(gamma_t *g, uint32_t player);
 
+/** @brief Podaje liczby pól zajętych przez wszystkich graczy.
+ * Zapisuje w @p out liczbę pól zajętych przez każdego gracza, tak jak
+ * @ref gamma_busy_fields, bez przechodzenia planszy.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[out] out    – tablica co najmniej @p players liczb, gracz
+ *                      @p player trafia na pozycję @p player - 1.
+ * @return Wartość @p true, jeśli wyniki zostały zapisane, a @p false,
+ * gdy któryś z parametrów jest NULL.
+ */
+bool gamma_all_busy_fields(gamma_t *g, uint64_t *out);
+
+/** @brief Podaje liczby pól, jakie jeszcze mogą zająć wszyscy gracze.
+ * Zapisuje w @p out wynik @ref gamma_free_fields dla każdego gracza.
+ * Zapamiętane wyniki są brane bez liczenia, obszary wielu graczy są
+ * przeliczane razem, a wolne pola obok wielu graczy o wielu polach
+ * liczone w jednym przejściu planszy (dla planszy zapisanej wiersz po
+ * wierszu), więc odświeżenie wyników wszystkich graczy kosztuje tyle
+ * co jedno przejście, a nie @p players przejść.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[out] out    – tablica co najmniej @p players liczb, gracz
+ *                      @p player trafia na pozycję @p player - 1.
+ * @return Wartość @p true, jeśli wyniki zostały zapisane, a @p false,
+ * gdy któryś z parametrów jest NULL.
+ */
+bool gamma_all_free_fields(gamma_t *g, uint64_t *out);
+
+/** @brief Podaje liczbę pól gracza lub wolnych pól w prostokącie.
+ * Liczy pola gracza @p player (lub wolne pola, gdy @p player jest zerem)
+ * w prostokącie o rogach (@p x0, @p y0) i (@p x1, @p y1) włącznie.
+ * Prostokąt wystający poza planszę jest do niej przycinany. Bloki 64x8
+ * pól, dla których podsumowania (uaktualniane przy każdym ruchu) podają
+ * wynik, nie są czytane, pola gracza o niewielu polach są brane z jego
+ * listy pól, a wiersze planszy @ref GAMMA_STORAGE_RLE liczone po ciągach.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza lub zero dla wolnych pól,
+ * @param[in] x0      – numer kolumny lewego rogu, mniejszy od szerokości,
+ * @param[in] y0      – numer wiersza dolnego rogu, mniejszy od wysokości,
+ * @param[in] x1      – numer kolumny prawego rogu, niemniejszy od @p x0,
+ * @param[in] y1      – numer wiersza górnego rogu, niemniejszy od @p y0.
+ * @return Liczba pól lub zero, gdy któryś z parametrów jest niepoprawny.
+ */
+uint64_t gamma_count_rect(gamma_t *g, uint32_t player, uint32_t x0, uint32_t y0,
+                          uint32_t x1, uint32_t y1);
+
+/** @brief Podaje identyfikator obszaru, do którego należy pole.
+ * Obszary są zbiorami rozłącznymi uzupełnianymi przy każdym zwykłym ruchu
+ * (pierwsze pytanie o obszary buduje je w jednym przejściu planszy, a po
+ * złotym ruchu lub @ref gamma_set_field są budowane od nowa przy
+ * następnym pytaniu). Identyfikator obszaru pozostaje ten sam, dopóki
+ * obszar nie zostanie połączony z innym, co najmniej tak dużym obszarem
+ * lub nie straci pola.
+ * Zajmuje 8 bajtów na pole planszy.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] x       – numer kolumny,
+ * @param[in] y       – numer wiersza.
+ * @return Dodatni identyfikator obszaru lub zero, gdy pole jest wolne,
+ * któryś z parametrów jest niepoprawny, plansza ma co najmniej 2^32 pól
+ * albo nie udało się zaalokować pamięci.
+ */
+uint64_t gamma_area_id(gamma_t *g, uint32_t x, uint32_t y);
+
+/** @brief Podaje liczbę pól obszaru.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] id      – identyfikator obszaru z @ref gamma_area_id lub
+ *                      @ref gamma_player_areas.
+ * @return Liczba pól obszaru lub zero, gdy @p id nie jest identyfikatorem
+ * obecnego obszaru lub któryś z parametrów jest niepoprawny.
+ */
+uint64_t gamma_area_size(gamma_t *g, uint64_t id);
+
+/** @brief Podaje obszary gracza.
+ * Zapisuje w @p ids identyfikatory (jak w @ref gamma_area_id) co najwyżej
+ * @p size obszarów gracza @p player i podaje dokładną liczbę jego
+ * obszarów, którą zapamiętuje też jako liczbę obszarów gracza. Pola
+ * gracza są brane z jego listy pól, jeśli jest.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza, liczba dodatnia niewiększa od wartości
+ *                      @p players z funkcji @ref gamma_new,
+ * @param[out] ids    – tablica @p size identyfikatorów lub NULL,
+ * @param[in] size    – rozmiar tablicy @p ids.
+ * @return Liczba obszarów gracza lub zero, gdy któryś z parametrów jest
+ * niepoprawny albo nie udało się zaalokować pamięci.
+ */
+uint64_t gamma_player_areas(gamma_t *g, uint32_t player, uint64_t *ids, uint64_t size);
+
 /** @brief Sprawdza, czy gracz może wykonać złoty ruch.
  * Próbuje wykonac ruch dla kazdego pola po kolei, do momentu znalezienia takiego pola.
  * Po znalezieniu tego pola przywraca stan struktury gamma do stanu przed ruchem.
@@ -110,6 +463,161 @@ uint64_t gamma_free_fields(gamma_t *g, uint32_t player);
  */
 bool gamma_golden_possible(gamma_t *g, uint32_t player);
 
+/** @brief Podaje właściciela pola.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] x       – numer kolumny,
+ * @param[in] y       – numer wiersza.
+ * @return Numer gracza zajmującego pole (@p x, @p y) lub zero, jeśli pole
+ * jest wolne albo któryś z parametrów jest niepoprawny.
+ */
+uint32_t gamma_field(gamma_t *g, uint32_t x, uint32_t y);
+
+/** @brief Ustawia pole z pominięciem zasad gry.
+ * Służy do odtwarzania zapisanego stanu gry. Aktualizuje liczbę pól graczy,
+ * ale nie liczby ich obszarów – po ustawieniu wszystkich pól należy wywołać
+ * @ref gamma_recount_areas.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza lub zero, aby zwolnić pole,
+ * @param[in] x       – numer kolumny,
+ * @param[in] y       – numer wiersza.
+ * @return Wartość @p true, jeśli pole zostało ustawione, a @p false,
+ * gdy któryś z parametrów jest niepoprawny.
+ */
+bool gamma_set_field(gamma_t *g, uint32_t player, uint32_t x, uint32_t y);
+
+/** @brief Ustawia dostępność złotego ruchu gracza.
+ * Służy do odtwarzania zapisanego stanu gry.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] player  – numer gracza,
+ * @param[in] available – czy gracz może jeszcze wykonać złoty ruch.
+ * @return Wartość @p true, jeśli udało się ustawić, a @p false,
+ * gdy któryś z parametrów jest niepoprawny.
+ */
+bool gamma_set_golden(gamma_t *g, uint32_t player, bool available);
+
+/** @brief Zapamiętuje stan gry, do którego można wrócić.
+ * Zapamiętuje liczniki graczy, a od tej chwili każda zmiana pola jest
+ * zapisywana, żeby @ref gamma_rollback mogła ją cofnąć w czasie
+ * proporcjonalnym do liczby zmian (bez kopiowania planszy). Punkty
+ * kontrolne można zagnieżdżać (np. jeden na poziom przeszukiwania gry),
+ * @ref gamma_rollback wraca do ostatniego z nich.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry.
+ * @return Wartość @p true, jeśli punkt kontrolny został ustawiony, a @p false,
+ * gdy @p g jest NULL lub nie udało się zaalokować pamięci.
+ */
+bool gamma_checkpoint(gamma_t *g);
+
+/** @brief Cofa grę do ostatniego punktu kontrolnego.
+ * Cofa wszystkie zmiany pól wykonane po ostatnim punkcie kontrolnym
+ * i przywraca liczniki graczy, punkt kontrolny pozostaje ustawiony. Zbudowane wcześniej
+ * identyfikatory obszarów (@ref gamma_area_id) są budowane od nowa, żeby
+ * kolejne ruchy dalej liczyły obszary dokładnie.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry.
+ * @return Wartość @p true, jeśli gra została cofnięta, a @p false, gdy
+ * @p g jest NULL, nie ma punktu kontrolnego lub zabrakło pamięci na zapis
+ * zmian (wtedy wszystkie punkty kontrolne są usuwane, a gra zostaje bez
+ * zmian).
+ */
+bool gamma_rollback(gamma_t *g);
+
+/** @brief Usuwa ostatni punkt kontrolny.
+ * Zmiany wykonane po nim zostają i może je cofnąć @ref gamma_rollback
+ * do poprzedniego punktu kontrolnego. Po usunięciu ostatniego punktu
+ * zmiany pól nie są już zapisywane.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry.
+ * @return Wartość @p true, jeśli punkt kontrolny został usunięty, a @p false,
+ * gdy @p g jest NULL lub nie ma punktu kontrolnego.
+ */
+bool gamma_checkpoint_drop(gamma_t *g);
+
+/** @brief Podaje skrót Zobrista gry.
+ * Skrót jest sumą xor kluczy zajętych pól (numer pola i jego właściciel)
+ * i graczy, którzy wykonali już złoty ruch, więc zależy tylko od planszy
+ * i dostępności złotych ruchów, a nie od kolejności ruchów. Jest
+ * uaktualniany przy każdej zmianie pola, pusta gra ma skrót 0. Klucze
+ * opisuje plik zobrist.h.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry.
+ * @return Skrót gry lub 0, gdy @p g jest NULL.
+ */
+uint64_t gamma_hash(gamma_t *g);
+
+/** @brief Przelicza liczby obszarów wszystkich graczy.
+ * Wykonuje jedno przejście po planszy. Wywoływana po odtworzeniu stanu gry
+ * za pomocą @ref gamma_set_field.
+ * @param[in,out] g   – wskaźnik na strukturę przechowującą stan gry.
+ */
+void gamma_recount_areas(gamma_t *g);
+
+/** @brief Zapisuje stan gry do pliku.
+ * Zapisuje binarny obraz gry (nagłówek z wersją formatu i skrótem gry,
+ * liczby pól i obszarów graczy, dostępność złotych ruchów oraz planszę). Plansza
+ * zaczyna się od granicy strony, aby @ref gamma_load mogła ją zmapować
+ * bez przetwarzania.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] path    – ścieżka do pliku.
+ * @return Wartość @p true, jeśli udało się zapisać, a @p false w przeciwnym
+ * przypadku.
+ */
+bool gamma_save(gamma_t *g, const char *path);
+
+/** @brief Wczytuje stan gry z pliku.
+ * Mapuje plik zapisany przez @ref gamma_save do pamięci. Plansza nie jest
+ * kopiowana, a ruchy wykonane po wczytaniu nie zmieniają pliku. Przy
+ * wczytaniu sprawdzany jest tylko nagłówek i rozmiar pliku, więc strony
+ * planszy są czytane dopiero przy pierwszym dostępie. Planszę sprawdza
+ * pierwszy ruch lub pytanie (poza @ref gamma_move_legal, @ref gamma_save
+ * i @ref gamma_stats): każde pole musi być wolne lub należeć do jednego
+ * z graczy, a liczby pól graczy i skrót gry (@ref gamma_hash) muszą
+ * zgadzać się z zapisanymi. Obszary graczy są wtedy przeliczane i żaden
+ * gracz nie może mieć ich więcej niż dozwolone, a z planszy budowane są
+ * podsumowania bloków i listy pól graczy. Jeśli plansza jest uszkodzona,
+ * gra odrzuca wszystkie ruchy, a pytania zwracają zero, @p false lub NULL
+ * (grę trzeba jedynie usunąć przez @ref gamma_delete).
+ * @param[in] path    – ścieżka do pliku.
+ * @return Wskaźnik na utworzoną strukturę lub NULL, gdy plik nie istnieje,
+ * ma uszkodzony nagłówek lub zły rozmiar, pochodzi z niezgodnej wersji lub
+ * nie udało się zaalokować pamięci.
+ */
+gamma_t* gamma_load(const char *path);
+
+/**
+ * Statystyki gry zwracane przez @ref gamma_stats:
+ * counters_enabled -czy liczniki zostały wkompilowane (GAMMA_STATS),
+ * counters -wartości liczników (zera, jeśli nie zostały wkompilowane),
+ * board_mapped -czy plansza jest zmapowanym plikiem (@ref gamma_load),
+ * pages -rodzaj stron pamięci planszy i tablicy odwiedzin,
+ * board_bytes, visited_bytes, rows_bytes, players_bytes, lists_bytes,
+ * summary_bytes, components_bytes, undo_bytes, struct_bytes,
+ * scratch_bytes -obecny rozmiar poszczególnych struktur w bajtach,
+ * total_bytes -suma powyższych rozmiarów.
+ */
+struct gamma_stats{
+    bool counters_enabled;
+    struct gamma_counters counters;
+    bool board_mapped;
+    enum gamma_pages pages;
+    uint64_t board_bytes;
+    uint64_t visited_bytes;
+    uint64_t rows_bytes;
+    uint64_t players_bytes;
+    uint64_t lists_bytes;
+    uint64_t summary_bytes;
+    uint64_t components_bytes;
+    uint64_t undo_bytes;
+    uint64_t struct_bytes;
+    uint64_t scratch_bytes;
+    uint64_t total_bytes;
+};
+
+/** @brief Podaje statystyki silnika dla gry.
+ * @param[in] g       – wskaźnik na strukturę przechowującą stan gry,
+ * @param[out] out    – wskaźnik na strukturę, w której zostaną zapisane
+ *                      statystyki.
+ * @return Wartość @p true, jeśli statystyki zostały zapisane, a @p false,
+ * gdy któryś z parametrów jest NULL.
+ */
+bool gamma_stats(gamma_t *g, struct gamma_stats *out);
+
 /** @brief Daje napis opisujący stan planszy.
  * Alokuje w pamięci bufor, w którym umieszcza napis zawierający tekstowy
  * opis aktualnego stanu planszy. Przykład znajduje się w pliku gamma_test.c.
@@ -120,6 +628,18 @@ bool gamma_golden_possible(gamma_t *g, uint32_t player);
  */
 char* gamma_board(gamma_t *g);
 
+/** @brief Zapisuje napis opisujący stan planszy do podanego bufora.
+ * Działa jak @ref gamma_board, ale używa bufora @p buffer o rozmiarze
+ * @p *size, powiększając go (realloc) tylko wtedy, gdy jest za mały –
+ * podobnie jak getline. Bufor może być NULL przy @p *size równym 0.
+ * @param[in] g          – wskaźnik na strukturę przechowującą stan gry,
+ * @param[in] buffer     – bufor lub NULL,
+ * @param[in,out] size   – rozmiar bufora.
+ * @return Wskaźnik na bufor z napisem (być może przeniesiony) lub NULL,
+ * jeśli nie udało się zaalokować pamięci – wtedy @p buffer pozostaje ważny.
+ */
+char* gamma_board_into(gamma_t *g, char *buffer, size_t *size);
+
 /** @brief Daje napis opisujący stan planszy dla trybu interactive.
  * Alokuje w pamięci bufor, w którym umieszcza napis zawierający tekstowy
  * opis aktualnego stanu planszy. Zawiera w sobie kody ANSI zmieniajave kolory pol.
@@ -0,0 +1,361 @@
+/** @file
+ * @brief microbenchmarks of the gamma engine.
+ * usage: gamma_bench [-s max_side] [-p max_players] [-t budget_ms] [-r seed]
+ *                    [-T threads]
+ *
+ * for every board side (10 to max_side), player count (1 to max_players),
+ * fill level and area limit state prints one CSV line per engine function:
+ * function,width,height,players,areas,fill,limit,ops,ns_per_op
+ * "limit" means the measured player already has the maximal amount of areas,
+ * which is the worst case for gamma_move, gamma_free_fields
+ * and gamma_golden_possible.
+ * every board keeps a checkpoint (see gamma_checkpoint): moves are taken
+ * back by gamma_rollback, so the fill level stays the same and times
+ * of gamma_move and gamma_golden_move include the rollback. in "limit"
+ * variant gamma_free_fields and gamma_golden_possible are preceded by
+ * a move on the frontier of the measured player (taken back the same way),
+ * so they measure recomputation and not answers cached by the engine.
+ * -T sets amount of threads recounting areas (see gamma_threads).
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "gamma.h"
+#include "rng.h"
+
+/** longest run of tiles of one owner created while filling the board */
+#define MAX_RUN 16
+
+/** most of frontier tiles remembered for "limit" variant */
+#define MAX_FRONTIER 4096
+
+/**
+ * benchmark configuration read from command line.
+ */
+struct bench_options{
+    uint32_t max_side;
+    uint32_t max_players;
+    double budget_ns;
+    uint64_t seed;
+    uint32_t threads;
+};
+
+/**
+ * xorshift64* generator state.
+ */
+static uint64_t rng_state=88172645463325252ull;
+
+/**
+ * returns current time in nanoseconds.
+ */
+static double now_ns(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC,&t);
+    return t.tv_sec*1e9+t.tv_nsec;
+}
+
+/**
+ * state of one benchmarked configuration.
+ * hot -player measured in "limit" variant (the one with most areas)
+ * frontier -empty tiles next to tiles of hot (x+y*width), at most MAX_FRONTIER
+ */
+struct bench_case{
+    gamma_t *g;
+    double fill;
+    bool limit;
+    uint32_t hot;
+    uint64_t *frontier;
+    size_t frontier_size;
+};
+
+/**
+ * returns player used in next operation.
+ */
+static uint32_t bench_player(struct bench_case *c)
+{
+    if(c->limit)return c->hot;
+    else return rng_below(&rng_state,c->g->players)+1;
+}
+
+/** one operation of benchmarked function */
+typedef void (*bench_op)(struct bench_case *c);
+
+/**
+ * in "limit" variant hot player takes random tile of its frontier,
+ * so that engine cannot answer next query of that player from its cache.
+ */
+static void bench_touch(struct bench_case *c)
+{
+    if(c->limit && c->frontier_size>0)
+    {
+        uint64_t cell=c->frontier[rng_below(&rng_state,c->frontier_size)];
+        gamma_move(c->g,c->hot,cell%c->g->width,cell/c->g->width);
+    }
+}
+
+/** normal move on random tile */
+static void op_move(struct bench_case *c)
+{
+    gamma_move(c->g,bench_player(c),rng_below(&rng_state,c->g->width),rng_below(&rng_state,c->g->height));
+    gamma_rollback(c->g);
+}
+
+/** golden move on random tile */
+static void op_golden_move(struct bench_case *c)
+{
+    //rollback gives golden move back too, so every operation can succeed
+    gamma_golden_move(c->g,bench_player(c),rng_below(&rng_state,c->g->width),rng_below(&rng_state,c->g->height));
+    gamma_rollback(c->g);
+}
+
+/** gamma_busy_fields call */
+static void op_busy_fields(struct bench_case *c)
+{
+    gamma_busy_fields(c->g,bench_player(c));
+}
+
+/** gamma_free_fields call */
+static void op_free_fields(struct bench_case *c)
+{
+    bench_touch(c);
+    gamma_free_fields(c->g,bench_player(c));
+    if(c->limit)gamma_rollback(c->g);
+}
+
+/** gamma_golden_possible call */
+static void op_golden_possible(struct bench_case *c)
+{
+    bench_touch(c);
+    gamma_golden_possible(c->g,bench_player(c));
+    if(c->limit)gamma_rollback(c->g);
+}
+
+/** full recount of areas of all players */
+static void op_recount_areas(struct bench_case *c)
+{
+    gamma_recount_areas(c->g);
+}
+
+/** rendering of whole board */
+static void op_board(struct bench_case *c)
+{
+    free(gamma_board(c->g));
+}
+
+/**
+ * benchmarked functions and their names.
+ */
+static const struct{
+    const char *name;
+    bench_op op;
+} bench_list[]={
+    {"gamma_move",op_move},
+    {"gamma_golden_move",op_golden_move},
+    {"gamma_busy_fields",op_busy_fields},
+    {"gamma_free_fields",op_free_fields},
+    {"gamma_golden_possible",op_golden_possible},
+    {"gamma_board",op_board},
+    {"gamma_recount_areas",op_recount_areas},
+};
+
+/**
+ * fills board of @p g: rows are split into runs of random length,
+ * each run is empty with probability 1-@p fill or belongs to random player.
+ */
+static void bench_fill(gamma_t *g,double fill)
+{
+    uint64_t threshold=(uint64_t)(fill*4294967296.0);
+    for(uint32_t y=0;y<g->height;y++)
+    {
+        uint32_t x=0;
+        while(x<g->width)
+        {
+            uint32_t run=rng_below(&rng_state,MAX_RUN)+1;
+            uint32_t owner=0;
+            if((rng_next(&rng_state)>>32)<threshold)owner=rng_below(&rng_state,g->players)+1;
+            for(uint32_t i=0;i<run && x<g->width;i++,x++)
+            {
+                if(owner!=0)gamma_set_field(g,owner,x,y);
+            }
+        }
+    }
+    gamma_recount_areas(g);
+}
+
+/**
+ * remembers up to MAX_FRONTIER empty tiles next to tiles of hot player.
+ * if memory runs out frontier stays empty and queries are not preceded by moves.
+ */
+static void bench_frontier(struct bench_case *c)
+{
+    gamma_t *g=c->g;
+    c->frontier=malloc(MAX_FRONTIER*sizeof(uint64_t));
+    for(uint32_t y=0;y<g->height && c->frontier!=NULL && c->frontier_size<MAX_FRONTIER;y++)
+    {
+        for(uint32_t x=0;x<g->width && c->frontier_size<MAX_FRONTIER;x++)
+        {
+            if(gamma_field(g,x,y)==0
+               && ((x>0 && gamma_field(g,x-1,y)==c->hot)
+                   || (x+1<g->width && gamma_field(g,x+1,y)==c->hot)
+                   || (y>0 && gamma_field(g,x,y-1)==c->hot)
+                   || (y+1<g->height && gamma_field(g,x,y+1)==c->hot)))
+            {
+                c->frontier[c->frontier_size++]=(uint64_t)y*g->width+x;
+            }
+        }
+    }
+}
+
+/**
+ * creates filled game, for @p limit areas of the game are set
+ * to the amount of areas of player who has most of them.
+ */
+static bool bench_setup(struct bench_case *c,uint32_t side,uint32_t players,double fill,bool limit,uint64_t seed)
+{
+    c->fill=fill;
+    c->limit=limit;
+    c->hot=1;
+    rng_state=seed;
+    c->g=gamma_new(side,side,players,UINT32_MAX);
+    if(c->g!=NULL)bench_fill(c->g,fill);
+    if(c->g!=NULL && limit)
+    {
+        uint32_t areas=1;
+        for(uint32_t i=0;i<players;i++)
+        {
+            if(c->g->players_area[i]>areas)
+            {
+                areas=c->g->players_area[i];
+                c->hot=i+1;
+            }
+        }
+        gamma_t *h=gamma_new(side,side,players,areas);
+        if(h!=NULL)
+        {
+            for(uint32_t y=0;y<side;y++)
+            {
+                for(uint32_t x=0;x<side;x++)gamma_set_field(h,gamma_field(c->g,x,y),x,y);
+            }
+            gamma_recount_areas(h);
+        }
+        gamma_delete(c->g);
+        c->g=h;
+    }
+    c->frontier=NULL;
+    c->frontier_size=0;
+    if(c->g!=NULL && limit)bench_frontier(c);
+    //moves of operations are taken back to this checkpoint
+    if(c->g!=NULL && !gamma_checkpoint(c->g))
+    {
+        gamma_delete(c->g);
+        c->g=NULL;
+    }
+    return c->g!=NULL;
+}
+
+/**
+ * frees game and frontier of @p c .
+ */
+static void bench_free(struct bench_case *c)
+{
+    gamma_delete(c->g);
+    free(c->frontier);
+}
+
+/**
+ * runs @p op in growing batches until @p budget_ns nanoseconds pass.
+ * @returns average time of one operation in nanoseconds, amount of
+ * operations is stored in @p ops
+ */
+static double bench_run(struct bench_case *c,bench_op op,double budget_ns,uint64_t *ops)
+{
+    uint64_t batch=1;
+    double elapsed=0;
+    *ops=0;
+    while(elapsed<budget_ns)
+    {
+        double start=now_ns();
+        for(uint64_t i=0;i<batch;i++)op(c);
+        elapsed+=now_ns()-start;
+        *ops+=batch;
+        batch*=2;
+    }
+    return elapsed/(*ops);
+}
+
+/**
+ * reads command line options.
+ * @returns false if options are not valid
+ */
+static bool bench_options_read(int argc,char *argv[],struct bench_options *o)
+{
+    bool ok=true;
+    o->max_side=1000;
+    o->max_players=1000000;
+    o->budget_ns=20e6;
+    o->seed=88172645463325252ull;
+    o->threads=0;
+    for(int i=1;i+1<argc && ok;i+=2)
+    {
+        if(strcmp(argv[i],"-s")==0)o->max_side=strtoul(argv[i+1],NULL,10);
+        else if(strcmp(argv[i],"-p")==0)o->max_players=strtoul(argv[i+1],NULL,10);
+        else if(strcmp(argv[i],"-t")==0)o->budget_ns=strtod(argv[i+1],NULL)*1e6;
+        else if(strcmp(argv[i],"-r")==0)o->seed=strtoull(argv[i+1],NULL,10)|1;
+        else if(strcmp(argv[i],"-T")==0)o->threads=strtoul(argv[i+1],NULL,10);
+        else ok=false;
+    }
+    return ok && argc%2==1;
+}
+
+int main(int argc,char *argv[])
+{
+    static const uint32_t sides[]={10,100,1000,10000};
+    static const uint32_t players[]={1,2,10,1000,1000000};
+    static const double fills[]={0.0,0.5,0.95};
+    struct bench_options o;
+    if(!bench_options_read(argc,argv,&o))
+    {
+        fprintf(stderr,"usage: %s [-s max_side] [-p max_players] [-t budget_ms] [-r seed]"
+                " [-T threads]\n",argv[0]);
+        return 1;
+    }
+    gamma_threads(o.threads);
+    printf("function,width,height,players,areas,fill,limit,ops,ns_per_op\n");
+    for(size_t s=0;s<sizeof sides/sizeof sides[0] && sides[s]<=o.max_side;s++)
+    {
+        for(size_t p=0;p<sizeof players/sizeof players[0] && players[p]<=o.max_players;p++)
+        {
+            for(size_t f=0;f<sizeof fills/sizeof fills[0];f++)
+            {
+                for(int limit=0;limit<=(fills[f]>0);limit++)
+                {
+                    for(size_t b=0;b<sizeof bench_list/sizeof bench_list[0];b++)
+                    {
+                        //every function starts from the same board
+                        struct bench_case c;
+                        if(!bench_setup(&c,sides[s],players[p],fills[f],limit,o.seed))
+                        {
+                            fprintf(stderr,"cannot create %ux%u board\n",sides[s],sides[s]);
+                            continue;
+                        }
+                        uint64_t ops;
+                        double ns=bench_run(&c,bench_list[b].op,o.budget_ns,&ops);
+                        printf("%s,%u,%u,%u,%u,%.2f,%d,%"PRIu64",%.1f\n",bench_list[b].name,
+                               c.g->width,c.g->height,c.g->players,c.g->areas,
+                               c.fill,limit,ops,ns);
+                        fflush(stdout);
+                        bench_free(&c);
+                    }
+                }
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,242 @@
+/** @file
+ * loops over row-major array board written once for all cell widths.
+ * this file is included by gamma.c once for every width, with CELL_T
+ * defined as type of a cell and CELL_FN(name) giving name of the variant
+ * of a function; it has no include guard on purpose.
+ * values of cells are known at compile time, so loops have no per-cell
+ * branching on width and can be vectorized.
+ */
+
+/**
+ * fills all tiles of board of @p g with '.'.
+ */
+static void CELL_FN(board_fill)(gamma_t *g)
+{
+    CELL_T *board=g->board;
+    size_t cells=(size_t)g->width*g->height;
+    for(size_t i=0;i<cells;i++)board[i]='.';
+}
+
+/**
+ * returns 1 if tile @p j of @p row of length @p w is empty and next to
+ * tile @p v , rows @p up and @p down can be NULL.
+ */
+static uint64_t CELL_FN(empty_next)(const CELL_T *row,const CELL_T *up,const CELL_T *down,
+                                    uint32_t w,uint32_t j,CELL_T v)
+{
+    return row[j]=='.' && ((j+1<w && row[j+1]==v) || (j>0 && row[j-1]==v)
+                           || (up!=NULL && up[j]==v) || (down!=NULL && down[j]==v));
+}
+
+/**
+ * count amount of free tiles next to @p player tiles in board of @p g ,
+ * row by row, with rows above and below read directly. parts of rows in
+ * blocks skipped by summaries of @p g are not read.
+ */
+static uint64_t CELL_FN(empty_fields)(gamma_t *g,uint32_t player)
+{
+    const CELL_T *board=g->board;
+    const CELL_T v='0'+player;
+    uint32_t w=g->width;
+    uint64_t result=0;
+    for(uint32_t i=0;i<g->height;i++)
+    {
+        const CELL_T *row=board+(size_t)i*w;
+        const CELL_T *down=i>0 ? row-w : NULL;
+        const CELL_T *up=i+1<g->height ? row+w : NULL;
+        //first or last row (or both) has only one row next to it
+        const CELL_T *other=up!=NULL ? up : down!=NULL ? down : row;
+        for(uint32_t start=0;start<w;start+=SUMMARY_COLUMNS)
+        {
+            uint32_t end=w-start>SUMMARY_COLUMNS ? start+SUMMARY_COLUMNS : w;
+            if(summary_skip(g,start>>SUMMARY_COLUMN_BITS,i>>SUMMARY_ROW_BITS,summary_bit(v)))
+            {
+                STAT_ADD(g,summary_skipped_tiles,end-start);
+            }
+            else
+            {
+                //ends of the row are checked apart, so inner loops have no bounds checks
+                if(start==0)result+=CELL_FN(empty_next)(row,up,down,w,0,v);
+                if(end==w && w>1)result+=CELL_FN(empty_next)(row,up,down,w,w-1,v);
+                uint32_t first=start>0 ? start : 1;
+                uint32_t last=end<w ? end : w-1;
+                if(up!=NULL && down!=NULL)
+                {
+                    for(uint32_t j=first;j<last;j++)
+                    {
+                        result+=(row[j]=='.') & ((row[j+1]==v) | (row[j-1]==v) | (up[j]==v) | (down[j]==v));
+                    }
+                }
+                else
+                {
+                    for(uint32_t j=first;j<last;j++)
+                    {
+                        result+=(row[j]=='.') & ((row[j+1]==v) | (row[j-1]==v) | (other[j]==v));
+                    }
+                }
+            }
+        }
+    }
+    return result;
+}
+
+/**
+ * adds 1 to @p out for every distinct player owning one of tiles @p a ,
+ * @p b , @p c , @p d (next to the same free tile) of game @p g ;
+ * missing neighbours are '.'.
+ */
+static void CELL_FN(owners_add)(gamma_t *g,uint64_t *out,CELL_T a,CELL_T b,CELL_T c,CELL_T d)
+{
+    if(a!='.' && (uint32_t)(a-'1')<g->players)out[a-'1']++;
+    if(b!='.' && b!=a && (uint32_t)(b-'1')<g->players)out[b-'1']++;
+    if(c!='.' && c!=a && c!=b && (uint32_t)(c-'1')<g->players)out[c-'1']++;
+    if(d!='.' && d!=a && d!=b && d!=c && (uint32_t)(d-'1')<g->players)out[d-'1']++;
+}
+
+/**
+ * adds amount of free tiles next to tiles of every player of @p g to
+ * @p out (indexed by player-1) in one pass over the board; blocks
+ * without free tiles or taken tiles around are not read.
+ */
+static void CELL_FN(empty_fields_all)(gamma_t *g,uint64_t *out)
+{
+    const CELL_T *board=g->board;
+    uint32_t w=g->width;
+    for(uint32_t i=0;i<g->height;i++)
+    {
+        const CELL_T *row=board+(size_t)i*w;
+        const CELL_T *down=i>0 ? row-w : NULL;
+        const CELL_T *up=i+1<g->height ? row+w : NULL;
+        for(uint32_t start=0;start<w;start+=SUMMARY_COLUMNS)
+        {
+            uint32_t end=w-start>SUMMARY_COLUMNS ? start+SUMMARY_COLUMNS : w;
+            if(summary_skip(g,start>>SUMMARY_COLUMN_BITS,i>>SUMMARY_ROW_BITS,UINT64_MAX))
+            {
+                STAT_ADD(g,summary_skipped_tiles,end-start);
+            }
+            else for(uint32_t j=start;j<end;j++)
+            {
+                if(row[j]=='.')
+                {
+                    CELL_FN(owners_add)(g,out,j+1<w ? row[j+1] : '.',j>0 ? row[j-1] : '.',
+                                        up!=NULL ? up[j] : '.',down!=NULL ? down[j] : '.');
+                }
+            }
+        }
+    }
+}
+
+/**
+ * sets bits of free tiles of board of @p g in zeroed bitmap @p bits
+ * (bit y*width+x), blocks without free tiles are not read.
+ * @returns amount of free tiles
+ */
+static uint64_t CELL_FN(empty_bits)(gamma_t *g,uint64_t *bits)
+{
+    const CELL_T *board=g->board;
+    uint32_t w=g->width;
+    uint64_t result=0;
+    for(uint32_t i=0;i<g->height;i++)
+    {
+        const CELL_T *row=board+(size_t)i*w;
+        uint64_t first=(uint64_t)i*w;
+        for(uint32_t start=0;start<w;start+=SUMMARY_COLUMNS)
+        {
+            uint32_t end=w-start>SUMMARY_COLUMNS ? start+SUMMARY_COLUMNS : w;
+            if(summary_at(g->summary,g->summary_columns,start,i)->empty==0)
+            {
+                STAT_ADD(g,summary_skipped_tiles,end-start);
+            }
+            else for(uint32_t j=start;j<end;j++)
+            {
+                uint64_t k=first+j;
+                uint64_t empty=row[j]=='.';
+                bits[k>>6]|=empty<<(k&63);
+                result+=empty;
+            }
+        }
+    }
+    return result;
+}
+
+/**
+ * counts tiles of value @p v in columns @p x0 to @p x1 of rows @p y0
+ * to @p y1 (inclusive, inside of the board) of board of @p g .
+ */
+static uint64_t CELL_FN(rect_count)(gamma_t *g,int v,uint32_t x0,uint32_t y0,
+                                    uint32_t x1,uint32_t y1)
+{
+    const CELL_T *board=g->board;
+    const CELL_T value=v;
+    uint64_t result=0;
+    for(uint32_t i=y0;i<=y1;i++)
+    {
+        const CELL_T *row=board+(size_t)i*g->width;
+        uint32_t count=0;
+        for(uint32_t j=x0;j<=x1;j++)count+=row[j]==value;
+        result+=count;
+    }
+    return result;
+}
+
+/**
+ * prints board of @p g with less than 10 players to @p result ,
+ * row by row from the top.
+ */
+static void CELL_FN(board_print)(gamma_t *g,char *result)
+{
+    const CELL_T *board=g->board;
+    size_t line=(size_t)g->width+1;
+    for(uint32_t i=0;i<g->height;i++)
+    {
+        const CELL_T *row=board+(size_t)i*g->width;
+        char *out=result+(size_t)(g->height-i-1)*line;
+        for(uint32_t j=0;j<g->width;j++)out[j]=row[j];
+        out[line-1]='\n';
+    }
+    result[(size_t)g->height*line]=0;
+}
+
+/**
+ * adds amount of tiles of every player of board of @p g to @p out
+ * (indexed by player-1) and Zobrist keys of taken tiles to @p hash .
+ * parts of rows of free tiles only are counted without looking at every
+ * tile on its own.
+ * @returns false if one of tiles is neither free nor of a player
+ */
+static bool CELL_FN(board_count)(gamma_t *g,uint64_t *out,uint64_t *hash)
+{
+    const CELL_T *board=g->board;
+    size_t cells=(size_t)g->width*g->height;
+    bool result=true;
+    for(size_t start=0;start<cells && result;start+=SUMMARY_COLUMNS)
+    {
+        size_t end=cells-start>SUMMARY_COLUMNS ? start+SUMMARY_COLUMNS : cells;
+        uint32_t empty=0;
+        for(size_t i=start;i<end;i++)empty+=board[i]=='.';
+        for(size_t i=start;i<end && empty<end-start && result;i++)
+        {
+            uint32_t player=(uint32_t)board[i]-'0';
+            if(board[i]=='.');
+            else if(player>0 && player<=g->players)
+            {
+                out[player-1]++;
+                *hash^=zobrist_cell(i,board[i]);
+            }
+            else result=false;
+        }
+    }
+    return result;
+}
+
+/** functions for board of CELL_T cells */
+static const struct cell_ops CELL_FN(ops)={
+    sizeof(CELL_T),
+    CELL_FN(board_fill),
+    CELL_FN(empty_fields),
+    CELL_FN(empty_fields_all),
+    CELL_FN(empty_bits),
+    CELL_FN(rect_count),
+    CELL_FN(board_print),
+    CELL_FN(board_count)
+};
@@ -0,0 +1,615 @@
+/** @file
+ * @brief self-play of the gamma engine: random playouts from one position.
+ * usage: gamma_selfplay [-w width] [-h height] [-k players] [-a areas]
+ *                       [-n playouts] [-o opening_moves] [-P policy]
+ *                       [-T threads] [-s seed]
+ *
+ * every thread builds its own copy of the position (the same random
+ * opening of -o moves), sets a checkpoint in it and plays playouts to the
+ * end, going back to the position with gamma_rollback after each of them,
+ * so a playout costs only its own moves.
+ * players move in turns; the game ends when all players in a row can not
+ * move. the winner is the player with most taken tiles, equal scores are
+ * a draw.
+ * threads keep free tiles and frontiers of players (free tiles next to
+ * them) updated by every move, so choosing a move costs O(1) whatever
+ * the size of the board. the sets are built once from the position and
+ * their changes are logged, so they go back with the board after a playout.
+ * policy "random" takes every legal move with the same chance, "greedy"
+ * prefers a tile next to more own tiles (growing areas instead of opening
+ * new ones); golden moves are tried only by players who have no normal
+ * move.
+ * prints "name value" lines: totals, speed and wins of every player.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "gamma.h"
+#include "rng.h"
+
+/** frontier tiles compared by greedy policy */
+#define SELFPLAY_TRIES 8
+
+/** random tiles tried for a golden move */
+#define SELFPLAY_GOLDEN_TRIES 32
+
+/** most threads started */
+#define SELFPLAY_MAX_THREADS 256
+
+/** index of tile which is not in a set */
+#define SET_NONE UINT32_MAX
+
+/**
+ * self-play configuration read from command line.
+ */
+struct selfplay_options{
+    uint32_t width;
+    uint32_t height;
+    uint32_t players;
+    uint32_t areas;
+    uint64_t playouts;
+    uint64_t opening;
+    bool greedy;
+    uint32_t threads;
+    uint64_t seed;
+};
+
+/**
+ * set of tiles with O(1) adding, removing and random choice:
+ * cells -tiles of the set (numbered y*width+x) in no particular order
+ * index -index of every tile of the board in @p cells or SET_NONE
+ * length -amount of tiles in the set
+ */
+struct tile_set{
+    uint32_t *cells;
+    uint32_t *index;
+    uint32_t length;
+};
+
+/**
+ * change of a tile set made during playout: @p cell was added to @p set
+ * (or removed from it, if not @p added ).
+ */
+struct set_change{
+    struct tile_set *set;
+    uint32_t cell;
+    bool added;
+};
+
+/**
+ * work and results of one thread:
+ * o -configuration
+ * seed -state of generator of the thread
+ * free -free tiles
+ * frontier -free tiles next to tiles of every player (indexed by player-1)
+ * log -changes of sets made in current playout, log_lost if memory for
+ *      them ran out (sets are built from the board again then)
+ * playouts -amount of playouts to play
+ * moves -amount of moves made (normal and golden)
+ * wins -wins of every player (indexed by player-1)
+ * draws -games ended with equal best scores
+ * ok -the position was created
+ */
+struct selfplay_worker{
+    const struct selfplay_options *o;
+    uint64_t seed;
+    struct tile_set free;
+    struct tile_set *frontier;
+    struct set_change *log;
+    size_t log_length;
+    size_t log_size;
+    bool log_lost;
+    uint64_t playouts;
+    uint64_t moves;
+    uint64_t *wins;
+    uint64_t draws;
+    bool ok;
+};
+
+/**
+ * returns current time in seconds.
+ */
+static double now_s(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC,&t);
+    return t.tv_sec+t.tv_nsec*1e-9;
+}
+
+/**
+ * allocates empty set @p s of tiles of board of @p cells tiles.
+ * @returns false if there is no memory
+ */
+static bool set_init(struct tile_set *s,uint64_t cells)
+{
+    s->cells=malloc(cells*sizeof(uint32_t));
+    s->index=malloc(cells*sizeof(uint32_t));
+    s->length=0;
+    if(s->index!=NULL)
+    {
+        for(uint64_t i=0;i<cells;i++)s->index[i]=SET_NONE;
+    }
+    return s->cells!=NULL && s->index!=NULL;
+}
+
+/**
+ * removes all tiles from @p s .
+ */
+static void set_clear(struct tile_set *s)
+{
+    for(uint32_t i=0;i<s->length;i++)s->index[s->cells[i]]=SET_NONE;
+    s->length=0;
+}
+
+/**
+ * adds tile @p cell to @p s , if it is not there yet.
+ * @returns true if the tile was added
+ */
+static bool set_add(struct tile_set *s,uint32_t cell)
+{
+    bool result=s->index[cell]==SET_NONE;
+    if(result)
+    {
+        s->index[cell]=s->length;
+        s->cells[s->length++]=cell;
+    }
+    return result;
+}
+
+/**
+ * removes tile @p cell from @p s , if it is there; last tile takes its place.
+ * @returns true if the tile was removed
+ */
+static bool set_remove(struct tile_set *s,uint32_t cell)
+{
+    uint32_t i=s->index[cell];
+    bool result=i!=SET_NONE;
+    if(result)
+    {
+        uint32_t last=s->cells[--s->length];
+        s->cells[i]=last;
+        s->index[last]=i;
+        s->index[cell]=SET_NONE;
+    }
+    return result;
+}
+
+/**
+ * returns random tile of not empty set @p s .
+ */
+static uint32_t set_random(struct tile_set *s,uint64_t *seed)
+{
+    return s->cells[rng_below(seed,s->length)];
+}
+
+/**
+ * frees buffers of @p s .
+ */
+static void set_free(struct tile_set *s)
+{
+    free(s->cells);
+    free(s->index);
+}
+
+/**
+ * stores numbers of tiles next to tile @p cell of @p g in @p out .
+ * @returns amount of such tiles
+ */
+static uint32_t neighbours(gamma_t *g,uint32_t cell,uint32_t *out)
+{
+    uint32_t x=cell%g->width;
+    uint32_t n=0;
+    if(x+1<g->width)out[n++]=cell+1;
+    if(x>0)out[n++]=cell-1;
+    if(cell/g->width+1<g->height)out[n++]=cell+g->width;
+    if(cell>=g->width)out[n++]=cell-g->width;
+    return n;
+}
+
+/**
+ * returns owner of tile @p cell of @p g , 0 for free tile.
+ */
+static uint32_t owner(gamma_t *g,uint32_t cell)
+{
+    return gamma_field(g,cell%g->width,cell/g->width);
+}
+
+/**
+ * returns amount of tiles of @p player next to tile @p cell of @p g .
+ */
+static uint32_t own_neighbours(gamma_t *g,uint32_t player,uint32_t cell)
+{
+    uint32_t near[4];
+    uint32_t n=neighbours(g,cell,near);
+    uint32_t result=0;
+    for(uint32_t i=0;i<n;i++)result+=owner(g,near[i])==player;
+    return result;
+}
+
+/**
+ * remembers change of set @p s of @p w , so that it can be undone.
+ */
+static void sets_log(struct selfplay_worker *w,struct tile_set *s,uint32_t cell,bool added)
+{
+    if(!w->log_lost && w->log_length==w->log_size)
+    {
+        size_t size=w->log_size*2+64;
+        struct set_change *log=realloc(w->log,size*sizeof(struct set_change));
+        if(log!=NULL)
+        {
+            w->log=log;
+            w->log_size=size;
+        }
+        else w->log_lost=true;
+    }
+    if(!w->log_lost)
+    {
+        struct set_change c={s,cell,added};
+        w->log[w->log_length++]=c;
+    }
+}
+
+/**
+ * adds tile @p cell to set @p s of @p w and logs the change.
+ */
+static void sets_add(struct selfplay_worker *w,struct tile_set *s,uint32_t cell)
+{
+    if(set_add(s,cell))sets_log(w,s,cell,true);
+}
+
+/**
+ * removes tile @p cell from set @p s of @p w and logs the change.
+ */
+static void sets_remove(struct selfplay_worker *w,struct tile_set *s,uint32_t cell)
+{
+    if(set_remove(s,cell))sets_log(w,s,cell,false);
+}
+
+/**
+ * builds free tiles and frontiers of @p w from board of @p g .
+ */
+static void sets_build(struct selfplay_worker *w,gamma_t *g)
+{
+    set_clear(&w->free);
+    for(uint32_t p=0;p<g->players;p++)set_clear(&w->frontier[p]);
+    uint32_t cells=g->width*g->height;
+    for(uint32_t cell=0;cell<cells;cell++)
+    {
+        if(owner(g,cell)==0)
+        {
+            uint32_t near[4];
+            uint32_t n=neighbours(g,cell,near);
+            set_add(&w->free,cell);
+            for(uint32_t i=0;i<n;i++)
+            {
+                uint32_t o=owner(g,near[i]);
+                if(o!=0)set_add(&w->frontier[o-1],cell);
+            }
+        }
+    }
+}
+
+/**
+ * brings sets of @p w back to the position after the board of @p g was
+ * rolled back: logged changes are undone from the last one, or, if the
+ * log is not complete, the sets are built again.
+ */
+static void sets_undo(struct selfplay_worker *w,gamma_t *g)
+{
+    if(w->log_lost)sets_build(w,g);
+    else
+    {
+        for(size_t i=w->log_length;i>0;i--)
+        {
+            const struct set_change *c=&w->log[i-1];
+            if(c->added)set_remove(c->set,c->cell);
+            else set_add(c->set,c->cell);
+        }
+    }
+    w->log_length=0;
+    w->log_lost=false;
+}
+
+/**
+ * updates sets of @p w after @p player took free tile @p cell of @p g :
+ * the tile leaves all sets and free tiles next to it join frontier of
+ * the player.
+ */
+static void sets_take(struct selfplay_worker *w,gamma_t *g,uint32_t player,uint32_t cell)
+{
+    uint32_t near[4];
+    uint32_t n=neighbours(g,cell,near);
+    sets_remove(w,&w->free,cell);
+    for(uint32_t i=0;i<n;i++)
+    {
+        uint32_t o=owner(g,near[i]);
+        if(o==0)sets_add(w,&w->frontier[player-1],near[i]);
+        else sets_remove(w,&w->frontier[o-1],cell);
+    }
+}
+
+/**
+ * updates frontiers of @p w after golden move of @p player on tile
+ * @p cell of @p g , which belonged to @p old : free tiles next to the tile
+ * may leave frontier of @p old and join frontier of @p player .
+ */
+static void sets_golden(struct selfplay_worker *w,gamma_t *g,uint32_t player,uint32_t old,uint32_t cell)
+{
+    uint32_t near[4];
+    uint32_t n=neighbours(g,cell,near);
+    for(uint32_t i=0;i<n;i++)
+    {
+        if(owner(g,near[i])==0)
+        {
+            sets_add(w,&w->frontier[player-1],near[i]);
+            if(own_neighbours(g,old,near[i])==0)sets_remove(w,&w->frontier[old-1],near[i]);
+        }
+    }
+}
+
+/**
+ * makes normal move of @p player in @p g on tile @p cell .
+ * @returns true if the move was made
+ */
+static bool selfplay_take(struct selfplay_worker *w,gamma_t *g,uint32_t player,uint32_t cell)
+{
+    bool result=gamma_move(g,player,cell%g->width,cell/g->width);
+    if(result)sets_take(w,g,player,cell);
+    return result;
+}
+
+/**
+ * makes normal move of @p player in @p g .
+ * random policy takes a random free tile while the player has room for
+ * a new area and a random tile of its frontier when it has not, those are
+ * exactly its legal moves, so every legal move is equally likely.
+ * greedy policy takes the tile next to most own tiles of a few from the
+ * frontier and starts a new area only when the frontier is empty.
+ * @returns true if a move was made
+ */
+static bool selfplay_move(struct selfplay_worker *w,gamma_t *g,uint32_t player)
+{
+    bool result=false;
+    struct tile_set *frontier=&w->frontier[player-1];
+    if(w->o->greedy && frontier->length>0)
+    {
+        uint32_t best=0,best_cell=0;
+        for(uint32_t i=0;i<SELFPLAY_TRIES;i++)
+        {
+            uint32_t cell=set_random(frontier,&w->seed);
+            uint32_t own=own_neighbours(g,player,cell);
+            if(i==0 || own>best)
+            {
+                best=own;
+                best_cell=cell;
+            }
+        }
+        result=selfplay_take(w,g,player,best_cell);
+    }
+    else
+    {
+        //counts of areas are exact during playouts (see selfplay_thread)
+        struct tile_set *legal=g->players_area[player-1]<g->areas ? &w->free : frontier;
+        if(legal->length>0)result=selfplay_take(w,g,player,set_random(legal,&w->seed));
+    }
+    return result;
+}
+
+/**
+ * makes golden move of @p player in @p g on random tile, if it has one.
+ * @returns true if a move was made
+ */
+static bool selfplay_golden(struct selfplay_worker *w,gamma_t *g,uint32_t player)
+{
+    bool result=false;
+    if(gamma_golden_possible(g,player))
+    {
+        for(uint32_t i=0;i<SELFPLAY_GOLDEN_TRIES && !result;i++)
+        {
+            uint32_t cell=rng_below(&w->seed,(uint64_t)g->width*g->height);
+            uint32_t old=owner(g,cell);
+            result=gamma_golden_move(g,player,cell%g->width,cell/g->width);
+            if(result)
+            {
+                sets_golden(w,g,player,old,cell);
+                //golden move recounts areas of both players exactly, but it
+                //may split an area, so area ids are built again for next moves
+                gamma_area_size(g,1);
+            }
+        }
+    }
+    return result;
+}
+
+/**
+ * plays one game in @p g to the end and counts its result.
+ */
+static void selfplay_playout(struct selfplay_worker *w,gamma_t *g)
+{
+    uint32_t passes=0;
+    for(uint32_t player=1;passes<g->players;player=player%g->players+1)
+    {
+        if(selfplay_move(w,g,player) || selfplay_golden(w,g,player))
+        {
+            w->moves++;
+            passes=0;
+        }
+        else passes++;
+    }
+    uint64_t best=0;
+    uint32_t winner=0;
+    bool draw=false;
+    for(uint32_t player=1;player<=g->players;player++)
+    {
+        uint64_t busy=gamma_busy_fields(g,player);
+        if(busy>best || winner==0)
+        {
+            best=busy;
+            winner=player;
+            draw=false;
+        }
+        else if(busy==best)draw=true;
+    }
+    if(draw)w->draws++;
+    else w->wins[winner-1]++;
+}
+
+/**
+ * creates position of @p o : empty board with random opening moves
+ * made by players in turns.
+ */
+static gamma_t* selfplay_position(const struct selfplay_options *o)
+{
+    gamma_t *g=gamma_new(o->width,o->height,o->players,o->areas);
+    uint64_t seed=o->seed;
+    for(uint64_t i=0;g!=NULL && i<o->opening;i++)
+    {
+        gamma_move(g,i%o->players+1,rng_below(&seed,o->width),rng_below(&seed,o->height));
+    }
+    return g;
+}
+
+/**
+ * plays all playouts of worker @p arg from its own copy of the position.
+ */
+static void* selfplay_thread(void *arg)
+{
+    struct selfplay_worker *w=arg;
+    gamma_t *g=selfplay_position(w->o);
+    bool ready=false;
+    if(g!=NULL)
+    {
+        uint64_t cells=(uint64_t)g->width*g->height;
+        w->frontier=calloc(g->players,sizeof(struct tile_set));
+        ready=w->frontier!=NULL && set_init(&w->free,cells);
+        for(uint32_t p=0;ready && p<g->players;p++)ready=set_init(&w->frontier[p],cells);
+        //counts of areas are exact from here and up to date area ids keep
+        //them exact during playouts (rollback brings both back)
+        gamma_recount_areas(g);
+        gamma_area_size(g,1);
+    }
+    if(ready && gamma_checkpoint(g))
+    {
+        w->ok=true;
+        sets_build(w,g);
+        for(uint64_t i=0;i<w->playouts && w->ok;i++)
+        {
+            selfplay_playout(w,g);
+            w->ok=gamma_rollback(g);
+            sets_undo(w,g);
+        }
+    }
+    free(w->log);
+    set_free(&w->free);
+    for(uint32_t p=0;w->frontier!=NULL && p<g->players;p++)set_free(&w->frontier[p]);
+    free(w->frontier);
+    gamma_delete(g);
+    return NULL;
+}
+
+/**
+ * reads command line options.
+ * @returns false if options are not valid
+ */
+static bool selfplay_options_read(int argc,char *argv[],struct selfplay_options *o)
+{
+    bool ok=true;
+    o->width=100;
+    o->height=100;
+    o->players=2;
+    o->areas=10;
+    o->playouts=1000;
+    o->opening=0;
+    o->greedy=false;
+    o->threads=0;
+    o->seed=88172645463325252ull;
+    for(int i=1;i+1<argc && ok;i+=2)
+    {
+        if(strcmp(argv[i],"-w")==0)o->width=strtoul(argv[i+1],NULL,10);
+        else if(strcmp(argv[i],"-h")==0)o->height=strtoul(argv[i+1],NULL,10);
+        else if(strcmp(argv[i],"-k")==0)o->players=strtoul(argv[i+1],NULL,10);
+        else if(strcmp(argv[i],"-a")==0)o->areas=strtoul(argv[i+1],NULL,10);
+        else if(strcmp(argv[i],"-n")==0)o->playouts=strtoull(argv[i+1],NULL,10);
+        else if(strcmp(argv[i],"-o")==0)o->opening=strtoull(argv[i+1],NULL,10);
+        else if(strcmp(argv[i],"-T")==0)o->threads=strtoul(argv[i+1],NULL,10);
+        else if(strcmp(argv[i],"-s")==0)o->seed=strtoull(argv[i+1],NULL,10)|1;
+        else if(strcmp(argv[i],"-P")==0 && strcmp(argv[i+1],"greedy")==0)o->greedy=true;
+        else if(strcmp(argv[i],"-P")!=0 || strcmp(argv[i+1],"random")!=0)ok=false;
+    }
+    if(o->threads==0)
+    {
+        long cpus=sysconf(_SC_NPROCESSORS_ONLN);
+        o->threads=cpus>0 ? cpus : 1;
+    }
+    if(o->threads>SELFPLAY_MAX_THREADS)o->threads=SELFPLAY_MAX_THREADS;
+    return ok && argc%2==1 && o->players>0 && (uint64_t)o->width*o->height<UINT32_MAX;
+}
+
+int main(int argc,char *argv[])
+{
+    struct selfplay_options o;
+    if(!selfplay_options_read(argc,argv,&o))
+    {
+        fprintf(stderr,"usage: %s [-w width] [-h height] [-k players] [-a areas]"
+                " [-n playouts] [-o opening_moves] [-P random|greedy] [-T threads]"
+                " [-s seed]\n",argv[0]);
+        return 1;
+    }
+    //playouts run in parallel already, areas are recounted by one thread
+    gamma_threads(1);
+    struct selfplay_worker workers[SELFPLAY_MAX_THREADS];
+    pthread_t threads[SELFPLAY_MAX_THREADS];
+    bool started[SELFPLAY_MAX_THREADS];
+    bool ok=true;
+    double start=now_s();
+    for(uint32_t t=0;t<o.threads;t++)
+    {
+        struct selfplay_worker *w=&workers[t];
+        memset(w,0,sizeof *w);
+        w->o=&o;
+        w->seed=(o.seed^(0x9e3779b97f4a7c15ull*(t+1)))|1;
+        w->playouts=o.playouts/o.threads+(t<o.playouts%o.threads);
+        w->wins=calloc(o.players,sizeof(uint64_t));
+        started[t]=w->wins!=NULL && pthread_create(&threads[t],NULL,selfplay_thread,w)==0;
+        ok=ok && started[t];
+    }
+    for(uint32_t t=0;t<o.threads;t++)
+    {
+        if(started[t])pthread_join(threads[t],NULL);
+        ok=ok && workers[t].ok;
+    }
+    double seconds=now_s()-start;
+    if(!ok)fprintf(stderr,"cannot play %ux%u game\n",o.width,o.height);
+    else
+    {
+        uint64_t moves=0,draws=0;
+        for(uint32_t t=0;t<o.threads;t++)
+        {
+            moves+=workers[t].moves;
+            draws+=workers[t].draws;
+        }
+        printf("threads %u\n",o.threads);
+        printf("playouts %"PRIu64"\n",o.playouts);
+        printf("moves %"PRIu64"\n",moves);
+        printf("seconds %.3f\n",seconds);
+        printf("playouts_per_s %.1f\n",o.playouts/seconds);
+        printf("moves_per_s %.1f\n",moves/seconds);
+        for(uint32_t p=0;p<o.players;p++)
+        {
+            uint64_t wins=0;
+            for(uint32_t t=0;t<o.threads;t++)wins+=workers[t].wins[p];
+            printf("wins_%u %"PRIu64"\n",p+1,wins);
+        }
+        printf("draws %"PRIu64"\n",draws);
+    }
+    for(uint32_t t=0;t<o.threads;t++)free(workers[t].wins);
+    return ok ? 0 : 1;
+}
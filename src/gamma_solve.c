@@ -0,0 +1,632 @@
+/** @file
+ * @brief exact solver of small two player games (up to 64 tiles).
+ * usage: gamma_solve [-w width] [-h height] [-a areas] [-o opening_moves]
+ *                    [-s seed] [-t tt_bits] [-S symmetry] [-T threads]
+ *
+ * finds value of the game (tiles of player 1 minus tiles of player 2 at
+ * the end, when both play best) and best move of player 1 from empty
+ * board or after -o random moves made by players in turns (every move is
+ * a random legal normal move, a player without one passes).
+ * a player who can make a move (normal or golden) has to make one, the
+ * game ends when both players in a row can not move.
+ *
+ * search is negamax with alpha-beta pruning, driven from the root by zero
+ * window searches (MTD(f)); positions whose value can not reach the
+ * window (free tiles and golden moves left bound the final difference)
+ * are cut at once. the move from the table is tried first, then two
+ * killer moves of the depth (last normal moves which cut off search at
+ * it), then other normal moves and golden moves; golden moves are listed
+ * only if normal ones did not cut off and only those which keep both
+ * players within the limit of areas.
+ * games are kept as bitboards (bitboard.h) and every
+ * move is made on a copy of the game, so nothing has to be taken back.
+ * positions are remembered in transposition table of
+ * 2^tt_bits entries (0 turns it off) shared by threads without locks:
+ * every entry is two words, the first one is key xor the second one, so
+ * an entry torn by writes of two threads does not match any key.
+ * keys are Zobrist hashes of the game (the same as gamma_hash) with key of player
+ * to move; with -S 1 (default) the least of hashes of all symmetric
+ * boards (4 for rectangle, 8 for square) is used instead, so symmetric
+ * positions share an entry.
+ * threads search the same game in different order of first moves
+ * (lazy SMP) and share the table, the first one to finish gives the result.
+ * prints "name value" lines.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <assert.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bitboard.h"
+#include "rng.h"
+#include "zobrist.h"
+
+/** most tiles of a solved board */
+#define SOLVE_MAX_CELLS 64
+
+/** most symmetries of a board */
+#define SOLVE_MAX_SYMMETRIES 8
+
+/** most threads started */
+#define SOLVE_MAX_THREADS 64
+
+/** code of golden move on tile c is SOLVE_GOLDEN+c */
+#define SOLVE_GOLDEN 64
+
+/** code of no move */
+#define SOLVE_NONE 255
+
+/** amount of codes of moves (normal and golden) */
+#define SOLVE_MOVES (2*SOLVE_MAX_CELLS)
+
+/**
+ * most depth of a position: at least every second ply is a move, there
+ * are at most SOLVE_MAX_CELLS normal moves and two golden ones
+ */
+#define SOLVE_MAX_PLY (2*SOLVE_MAX_CELLS+6)
+
+/** killer moves remembered for every depth */
+#define SOLVE_KILLERS 2
+
+/** value above all values of games */
+#define SOLVE_INF 127
+
+/** kinds of values in transposition table */
+enum solve_bound{
+    BOUND_EXACT=1,
+    BOUND_LOWER=2,
+    BOUND_UPPER=3
+};
+
+/**
+ * solver configuration read from command line.
+ */
+struct solve_options{
+    uint32_t width;
+    uint32_t height;
+    uint32_t areas;
+    uint64_t opening;
+    uint64_t seed;
+    uint32_t tt_bits;
+    bool symmetry;
+    uint32_t threads;
+};
+
+/**
+ * entry of transposition table: check is key xor data, data is value
+ * (bits 0-7, +128), bound (bits 8-9) and best move in canonical board
+ * (bits 10-17).
+ */
+struct tt_entry{
+    _Atomic uint64_t check;
+    _Atomic uint64_t data;
+};
+
+/**
+ * state shared by threads:
+ * o -configuration
+ * symmetries -amount of symmetries of the board
+ * map, unmap -tile which tile goes to by every symmetry and back
+ * keys -keys of tile with value '1' or '2' moved by every symmetry
+ * tt, tt_mask -transposition table and mask of its index (NULL if off)
+ * stop -search was finished by one of threads
+ */
+struct solve_shared{
+    const struct solve_options *o;
+    uint32_t symmetries;
+    uint8_t map[SOLVE_MAX_SYMMETRIES][SOLVE_MAX_CELLS];
+    uint8_t unmap[SOLVE_MAX_SYMMETRIES][SOLVE_MAX_CELLS];
+    uint64_t keys[SOLVE_MAX_SYMMETRIES][SOLVE_MAX_CELLS][2];
+    struct tt_entry *tt;
+    uint64_t tt_mask;
+    atomic_bool stop;
+};
+
+/**
+ * search of one thread:
+ * hashes -hash of board moved by every symmetry (the first one is the
+ * hash of the game without golden moves)
+ * killers -normal moves which cut off search last at every depth,
+ * the newest first (SOLVE_NONE if there is none)
+ * nodes, hits -visited positions and useful table entries
+ * value, move -result of the search, if it was finished
+ */
+struct solve_worker{
+    struct solve_shared *s;
+    uint32_t id;
+    uint64_t hashes[SOLVE_MAX_SYMMETRIES];
+    uint8_t killers[SOLVE_MAX_PLY][SOLVE_KILLERS];
+    uint64_t nodes;
+    uint64_t hits;
+    int value;
+    uint32_t move;
+    bool finished;
+};
+
+/**
+ * returns current time in seconds.
+ */
+static double now_s(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC,&t);
+    return t.tv_sec+t.tv_nsec*1e-9;
+}
+
+/**
+ * fills symmetries of board of @p s : flips and half turn, and also
+ * quarter turns and diagonal flips for square board.
+ */
+static void symmetries_setup(struct solve_shared *s)
+{
+    uint32_t w=s->o->width,h=s->o->height;
+    s->symmetries=s->o->symmetry ? (w==h ? 8 : 4) : 1;
+    for(uint32_t k=0;k<s->symmetries;k++)
+    {
+        for(uint32_t y=0;y<h;y++)
+        {
+            for(uint32_t x=0;x<w;x++)
+            {
+                //first 4: identity, flips and half turn, then the same after transposition
+                uint32_t a=k&1 ? w-1-x : x;
+                uint32_t b=k&2 ? h-1-y : y;
+                uint32_t to=k&4 ? a*w+b : b*w+a;
+                s->map[k][y*w+x]=to;
+                s->unmap[k][to]=y*w+x;
+                s->keys[k][y*w+x][0]=zobrist_cell(to,'1');
+                s->keys[k][y*w+x][1]=zobrist_cell(to,'2');
+            }
+        }
+    }
+}
+
+/**
+ * updates hashes of @p w after tile @p cell changed from @p old to
+ * @p value (player numbers, 0 for free tile).
+ */
+static void hashes_change(struct solve_worker *w,uint32_t cell,uint32_t old,uint32_t value)
+{
+    for(uint32_t k=0;k<w->s->symmetries;k++)
+    {
+        if(old!=0)w->hashes[k]^=w->s->keys[k][cell][old-1];
+        if(value!=0)w->hashes[k]^=w->s->keys[k][cell][value-1];
+    }
+}
+
+/**
+ * returns part of hash of @p b made of keys of players who used their
+ * golden moves, the same for all symmetric boards.
+ */
+static uint64_t golden_key(const bitboard_t *b)
+{
+    uint64_t result=0;
+    for(uint32_t player=1;player<=2;player++)
+    {
+        if((b->golden>>(player-1)&1)==0)result^=zobrist_golden(player);
+    }
+    return result;
+}
+
+/**
+ * returns key of position @p b of @p w with @p player to move and stores
+ * symmetry giving it in @p symmetry .
+ */
+static uint64_t position_key(struct solve_worker *w,const bitboard_t *b,uint32_t player,
+                             uint32_t *symmetry)
+{
+    uint64_t golden=golden_key(b);
+    //hash kept by the game is the one of not moved board
+    assert(b->hash==(w->hashes[0]^golden));
+    uint64_t best=w->hashes[0];
+    *symmetry=0;
+    for(uint32_t k=1;k<w->s->symmetries;k++)
+    {
+        if(w->hashes[k]<best)
+        {
+            best=w->hashes[k];
+            *symmetry=k;
+        }
+    }
+    return best^golden^zobrist_turn(player);
+}
+
+/**
+ * looks @p key up in table of @p s .
+ * @returns true if entry was found, its data is stored in @p data
+ */
+static bool tt_probe(struct solve_shared *s,uint64_t key,uint64_t *data)
+{
+    bool result=false;
+    if(s->tt!=NULL)
+    {
+        struct tt_entry *e=&s->tt[key&s->tt_mask];
+        uint64_t check=atomic_load_explicit(&e->check,memory_order_relaxed);
+        *data=atomic_load_explicit(&e->data,memory_order_relaxed);
+        result=(check^*data)==key && *data!=0;
+    }
+    return result;
+}
+
+/**
+ * stores @p value of kind @p bound and best move @p move (canonical) of
+ * position @p key in table of @p s .
+ */
+static void tt_store(struct solve_shared *s,uint64_t key,int value,enum solve_bound bound,uint32_t move)
+{
+    if(s->tt!=NULL)
+    {
+        struct tt_entry *e=&s->tt[key&s->tt_mask];
+        uint64_t data=(uint64_t)(value+128)|((uint64_t)bound<<8)|((uint64_t)move<<10);
+        atomic_store_explicit(&e->check,key^data,memory_order_relaxed);
+        atomic_store_explicit(&e->data,data,memory_order_relaxed);
+    }
+}
+
+/**
+ * returns move of code @p move (normal or golden move on canonical tile)
+ * moved back from canonical board by @p symmetry .
+ */
+static uint32_t move_uncanonical(struct solve_shared *s,uint32_t move,uint32_t symmetry)
+{
+    uint32_t result=move;
+    if(move<SOLVE_GOLDEN)result=s->unmap[symmetry][move];
+    else if(move!=SOLVE_NONE)result=SOLVE_GOLDEN+s->unmap[symmetry][move-SOLVE_GOLDEN];
+    return result;
+}
+
+/**
+ * returns move of code @p move moved to canonical board by @p symmetry .
+ */
+static uint32_t move_canonical(struct solve_shared *s,uint32_t move,uint32_t symmetry)
+{
+    uint32_t result=move;
+    if(move<SOLVE_GOLDEN)result=s->map[symmetry][move];
+    else if(move!=SOLVE_NONE)result=SOLVE_GOLDEN+s->map[symmetry][move-SOLVE_GOLDEN];
+    return result;
+}
+
+/**
+ * lists moves of @p player in game @p b of @p w at depth @p ply in
+ * @p moves . for not @p golden : @p first (move from table), killer moves
+ * and other normal moves, which are rotated by number of thread in
+ * near-root positions; golden moves (other than @p first ) otherwise.
+ * golden moves are listed only when normal ones did not cut off, so most
+ * positions never check them.
+ * @returns amount of moves
+ */
+static uint32_t moves_list(struct solve_worker *w,const bitboard_t *b,uint32_t player,
+                           uint32_t first,uint32_t ply,bool golden,uint8_t *moves)
+{
+    uint32_t n=0;
+    if(!golden)
+    {
+        if(first!=SOLVE_NONE)moves[n++]=first;
+        uint64_t legal=bitboard_legal_moves(b,player);
+        uint32_t normal=__builtin_popcountll(legal);
+        uint32_t shift=ply<2 && normal>0 ? (w->id*7)%normal : 0;
+        if(first<SOLVE_GOLDEN)legal&=~((uint64_t)1<<first);
+        for(uint32_t i=0;i<SOLVE_KILLERS;i++)
+        {
+            uint32_t killer=w->killers[ply][i];
+            if(killer<SOLVE_GOLDEN && (legal>>killer&1)!=0)
+            {
+                moves[n++]=killer;
+                legal&=~((uint64_t)1<<killer);
+            }
+        }
+        uint32_t start=n;
+        for(uint64_t bits=legal;bits!=0;bits&=bits-1)moves[n++]=__builtin_ctzll(bits);
+        //rotation keeps the set of moves, only their order changes
+        for(uint32_t i=0;i<shift && n-start>1;i++)
+        {
+            uint8_t head=moves[start];
+            memmove(moves+start,moves+start+1,n-start-1);
+            moves[n-1]=head;
+        }
+    }
+    else
+    {
+        for(uint64_t bits=bitboard_golden_moves(b,player);bits!=0;bits&=bits-1)
+        {
+            uint32_t cell=__builtin_ctzll(bits);
+            if(SOLVE_GOLDEN+cell!=first)moves[n++]=SOLVE_GOLDEN+cell;
+        }
+    }
+    return n;
+}
+
+/**
+ * remembers normal move @p move which cut off search at depth @p ply of
+ * @p w as its newest killer move.
+ */
+static void killer_add(struct solve_worker *w,uint32_t ply,uint32_t move)
+{
+    uint8_t *killers=w->killers[ply];
+    if(killers[0]!=move)
+    {
+        memmove(killers+1,killers,SOLVE_KILLERS-1);
+        killers[0]=move;
+    }
+}
+
+/**
+ * makes move of code @p move of @p player in game @p b of @p w .
+ * @returns false if move is not legal
+ */
+static bool move_make(struct solve_worker *w,bitboard_t *b,uint32_t player,uint32_t move)
+{
+    bool result=false;
+    if(move<SOLVE_GOLDEN)
+    {
+        result=bitboard_move(b,player,move%b->width,move/b->width);
+        if(result)hashes_change(w,move,0,player);
+    }
+    else
+    {
+        uint32_t cell=move-SOLVE_GOLDEN;
+        result=bitboard_golden_move(b,player,cell%b->width,cell/b->width);
+        if(result)hashes_change(w,cell,3-player,player);
+    }
+    return result;
+}
+
+/**
+ * returns value of game @p b of @p w for @p player to move (own tiles
+ * minus tiles of the other player at the end), exact if it is inside of
+ * ( @p alpha , @p beta ), bound otherwise. @p passes -players in a row
+ * who could not move, @p ply -depth of the position. best move is stored
+ * in @p best .
+ */
+static int search(struct solve_worker *w,const bitboard_t *b,uint32_t player,int alpha,int beta,
+                  uint32_t passes,uint32_t ply,uint32_t *best)
+{
+    uint32_t other=3-player;
+    int result=-SOLVE_INF;
+    *best=SOLVE_NONE;
+    w->nodes++;
+    int own=bitboard_busy_fields(b,player);
+    int rival=bitboard_busy_fields(b,other);
+    int free=b->width*b->height-own-rival;
+    //at best player takes all free tiles and steals one with golden move,
+    //at worst the other player does it
+    int high=own+free-rival+2*(int)(b->golden>>(player-1)&1);
+    int low=own-free-rival-2*(int)(b->golden>>(other-1)&1);
+    if(passes>=2)result=own-rival;
+    else if(high<=alpha)result=high;
+    else if(low>=beta)result=low;
+    else if(!atomic_load_explicit(&w->s->stop,memory_order_relaxed))
+    {
+        int alpha0=alpha;
+        uint32_t symmetry;
+        uint64_t key=position_key(w,b,player,&symmetry);
+        uint64_t data;
+        uint32_t first=SOLVE_NONE;
+        bool done=false;
+        if(tt_probe(w->s,key,&data))
+        {
+            int value=(int)(data&255)-128;
+            enum solve_bound bound=(data>>8)&3;
+            first=move_uncanonical(w->s,(data>>10)&255,symmetry);
+            if(bound==BOUND_EXACT || (bound==BOUND_LOWER && value>=beta)
+               || (bound==BOUND_UPPER && value<=alpha))
+            {
+                result=value;
+                *best=first;
+                done=true;
+                w->hits++;
+            }
+        }
+        if(!done)
+        {
+            uint8_t moves[SOLVE_MOVES+1];
+            uint64_t hashes[SOLVE_MAX_SYMMETRIES];
+            memcpy(hashes,w->hashes,sizeof hashes);
+            bool moved=false;
+            for(int golden=0;golden<2 && alpha<beta;golden++)
+            {
+                uint32_t n=moves_list(w,b,player,first,ply,golden,moves);
+                for(uint32_t i=0;i<n && alpha<beta;i++)
+                {
+                    bitboard_t next=*b;
+                    if(move_make(w,&next,player,moves[i]))
+                    {
+                        uint32_t reply;
+                        int value=-search(w,&next,other,-beta,-alpha,0,ply+1,&reply);
+                        memcpy(w->hashes,hashes,sizeof hashes);
+                        moved=true;
+                        if(value>result)
+                        {
+                            result=value;
+                            *best=moves[i];
+                        }
+                        if(value>alpha)alpha=value;
+                        if(alpha>=beta && moves[i]<SOLVE_GOLDEN)killer_add(w,ply,moves[i]);
+                    }
+                }
+            }
+            if(!moved)
+            {
+                uint32_t reply;
+                result=-search(w,b,other,-beta,-alpha,passes+1,ply+1,&reply);
+            }
+            if(!atomic_load_explicit(&w->s->stop,memory_order_relaxed))
+            {
+                enum solve_bound bound=BOUND_EXACT;
+                if(result<=alpha0)bound=BOUND_UPPER;
+                else if(result>=beta)bound=BOUND_LOWER;
+                tt_store(w->s,key,result,bound,move_canonical(w->s,*best,symmetry));
+            }
+        }
+    }
+    return result;
+}
+
+/**
+ * creates in @p b position of @p o : empty board with random opening
+ * moves made by players in turns.
+ * @returns false if options are not valid for a game, player to move is
+ * stored in @p player otherwise
+ */
+static bool solve_position(const struct solve_options *o,bitboard_t *b,uint32_t *player)
+{
+    bool result=bitboard_init(b,o->width,o->height,2,o->areas);
+    uint64_t seed=o->seed;
+    *player=1;
+    for(uint64_t i=0;result && i<o->opening;i++)
+    {
+        uint64_t legal=bitboard_legal_moves(b,*player);
+        if(legal!=0)
+        {
+            //k-th legal tile, counting from the lowest one
+            for(uint64_t k=rng_below(&seed,__builtin_popcountll(legal));k>0;k--)legal&=legal-1;
+            uint32_t cell=__builtin_ctzll(legal);
+            bitboard_move(b,*player,cell%o->width,cell/o->width);
+        }
+        *player=3-*player;
+    }
+    return result;
+}
+
+/**
+ * searches the position of its own game, stops other threads when done.
+ */
+static void* solve_thread(void *arg)
+{
+    struct solve_worker *w=arg;
+    uint32_t player;
+    bitboard_t b;
+    if(solve_position(w->s->o,&b,&player))
+    {
+        memset(w->hashes,0,sizeof w->hashes);
+        for(uint32_t cell=0;cell<b.width*b.height;cell++)
+        {
+            uint32_t owner=bitboard_field(&b,cell%b.width,cell/b.width);
+            if(owner!=0)hashes_change(w,cell,0,owner);
+        }
+        memset(w->killers,SOLVE_NONE,sizeof w->killers);
+        //MTD(f): zero window searches around guess, table keeps their bounds
+        int low=-SOLVE_INF,high=SOLVE_INF;
+        w->value=0;
+        while(low<high && !atomic_load(&w->s->stop))
+        {
+            int beta=w->value==low ? w->value+1 : w->value;
+            uint32_t move;
+            w->value=search(w,&b,player,beta-1,beta,0,0,&move);
+            if(w->value<beta)high=w->value;
+            else
+            {
+                //only move failing high is known to reach the value
+                low=w->value;
+                w->move=move;
+            }
+        }
+        //value of player 1
+        if(player==2)w->value=-w->value;
+        w->finished=!atomic_exchange(&w->s->stop,true);
+    }
+    return NULL;
+}
+
+/**
+ * reads command line options.
+ * @returns false if options are not valid
+ */
+static bool solve_options_read(int argc,char *argv[],struct solve_options *o)
+{
+    bool ok=true;
+    o->width=4;
+    o->height=4;
+    o->areas=2;
+    o->opening=0;
+    o->seed=88172645463325252ull;
+    o->tt_bits=22;
+    o->symmetry=true;
+    o->threads=1;
+    for(int i=1;i+1<argc && ok;i+=2)
+    {
+        if(strcmp(argv[i],"-w")==0)o->width=strtoul(argv[i+1],NULL,10);
+        else if(strcmp(argv[i],"-h")==0)o->height=strtoul(argv[i+1],NULL,10);
+        else if(strcmp(argv[i],"-a")==0)o->areas=strtoul(argv[i+1],NULL,10);
+        else if(strcmp(argv[i],"-o")==0)o->opening=strtoull(argv[i+1],NULL,10);
+        else if(strcmp(argv[i],"-s")==0)o->seed=strtoull(argv[i+1],NULL,10)|1;
+        else if(strcmp(argv[i],"-t")==0)o->tt_bits=strtoul(argv[i+1],NULL,10);
+        else if(strcmp(argv[i],"-S")==0)o->symmetry=strtoul(argv[i+1],NULL,10)!=0;
+        else if(strcmp(argv[i],"-T")==0)o->threads=strtoul(argv[i+1],NULL,10);
+        else ok=false;
+    }
+    return ok && argc%2==1 && o->width>0 && o->height>0
+           && (uint64_t)o->width*o->height<=SOLVE_MAX_CELLS
+           && o->tt_bits<=32 && o->threads>0 && o->threads<=SOLVE_MAX_THREADS;
+}
+
+int main(int argc,char *argv[])
+{
+    struct solve_options o;
+    if(!solve_options_read(argc,argv,&o))
+    {
+        fprintf(stderr,"usage: %s [-w width] [-h height] [-a areas] [-o opening_moves]"
+                " [-s seed] [-t tt_bits] [-S symmetry] [-T threads]"
+                " (at most %d tiles)\n",argv[0],SOLVE_MAX_CELLS);
+        return 1;
+    }
+    struct solve_shared *s=calloc(1,sizeof(struct solve_shared));
+    bool ok=s!=NULL;
+    if(ok)
+    {
+        s->o=&o;
+        symmetries_setup(s);
+        if(o.tt_bits>0)
+        {
+            s->tt=calloc((size_t)1<<o.tt_bits,sizeof(struct tt_entry));
+            s->tt_mask=((uint64_t)1<<o.tt_bits)-1;
+            ok=s->tt!=NULL;
+        }
+    }
+    struct solve_worker workers[SOLVE_MAX_THREADS];
+    pthread_t threads[SOLVE_MAX_THREADS];
+    bool started[SOLVE_MAX_THREADS];
+    double start=now_s();
+    for(uint32_t t=0;t<o.threads && ok;t++)
+    {
+        memset(&workers[t],0,sizeof workers[t]);
+        workers[t].s=s;
+        workers[t].id=t;
+        started[t]=pthread_create(&threads[t],NULL,solve_thread,&workers[t])==0;
+        ok=started[t];
+    }
+    const struct solve_worker *result=NULL;
+    uint64_t nodes=0,hits=0;
+    for(uint32_t t=0;t<o.threads && s!=NULL;t++)
+    {
+        if(started[t])
+        {
+            pthread_join(threads[t],NULL);
+            if(workers[t].finished)result=&workers[t];
+            nodes+=workers[t].nodes;
+            hits+=workers[t].hits;
+        }
+    }
+    double seconds=now_s()-start;
+    if(!ok || result==NULL)fprintf(stderr,"cannot solve %ux%u game\n",o.width,o.height);
+    else
+    {
+        printf("value %d\n",result->value);
+        if(result->move==SOLVE_NONE)printf("move none\n");
+        else if(result->move<SOLVE_GOLDEN)printf("move %u %u\n",result->move%o.width,result->move/o.width);
+        else printf("golden_move %u %u\n",(result->move-SOLVE_GOLDEN)%o.width,(result->move-SOLVE_GOLDEN)/o.width);
+        printf("nodes %"PRIu64"\n",nodes);
+        printf("tt_hits %"PRIu64"\n",hits);
+        printf("seconds %.3f\n",seconds);
+        printf("nodes_per_s %.1f\n",nodes/seconds);
+    }
+    if(s!=NULL)free(s->tt);
+    free(s);
+    return ok && result!=NULL ? 0 : 1;
+}
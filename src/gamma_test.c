@@ -10,10 +10,16 @@
 
 #include <assert.h>
 #include <errno.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
 
+#include "bitboard.h"
+#include "journal.h"
+#include "tile_list.h"
+#include "zobrist.h"
+
 /** FUNKCJE POMOCNE PRZY DEBUGOWANIU TESTÓW **/
 
 #if 0
@@ -757,6 +763,1283 @@ static int middle_board(void) {
   return PASS;
 }
 
+/* Zmienia ostatni bajt pliku. */
+static bool snapshot_poke(const char *path, char value) {
+  FILE *f = fopen(path, "r+b");
+  bool ok = f != NULL && fseek(f, -1, SEEK_END) == 0 && fputc(value, f) != EOF;
+  if (f != NULL && fclose(f) != 0)
+    ok = false;
+  return ok;
+}
+
+/* Testuje zapis i odczyt stanu gry. */
+static int snapshot(void) {
+  static const char path[] = "gamma_test_snapshot.bin";
+  gamma_t *g = gamma_new(SMALL_BOARD_SIZE, SMALL_BOARD_SIZE + 1, 3, 2);
+  assert(g != NULL);
+
+  assert(gamma_move(g, 1, 0, 0));
+  assert(gamma_move(g, 1, 2, 0));
+  assert(gamma_move(g, 2, 1, 0));
+  assert(gamma_move(g, 3, 9, 10));
+  assert(gamma_golden_move(g, 3, 1, 0));
+  assert(gamma_save(g, path));
+
+  gamma_t *h = gamma_load(path);
+  assert(h != NULL);
+  /* Listy pól są budowane dopiero przy pierwszym pytaniu. */
+  struct gamma_stats st;
+  assert(gamma_stats(h, &st));
+  uint64_t lists_bytes = st.lists_bytes;
+  assert(gamma_free_fields(h, 1) == gamma_free_fields(g, 1));
+  assert(gamma_stats(h, &st) && st.lists_bytes > lists_bytes);
+  char *p = gamma_board(g);
+  char *q = gamma_board(h);
+  assert(p != NULL && q != NULL);
+  assert(strcmp(p, q) == 0);
+  free(p);
+  free(q);
+  for (uint32_t player = 1; player <= 3; ++player) {
+    assert(gamma_busy_fields(g, player) == gamma_busy_fields(h, player));
+    assert(gamma_free_fields(g, player) == gamma_free_fields(h, player));
+    assert(gamma_golden_possible(g, player) == gamma_golden_possible(h, player));
+  }
+  assert(gamma_hash(h) == gamma_hash(g));
+  for (uint32_t player = 0; player <= 3; ++player)
+    assert(gamma_count_rect(g, player, 0, 0, SMALL_BOARD_SIZE - 1, SMALL_BOARD_SIZE) ==
+           gamma_count_rect(h, player, 0, 0, SMALL_BOARD_SIZE - 1, SMALL_BOARD_SIZE));
+  assert(!gamma_move(h, 1, 5, 5));
+  assert(!gamma_golden_move(h, 3, 0, 0));
+  assert(gamma_move(h, 2, 5, 5));
+  assert(gamma_busy_fields(h, 2) == 1);
+  gamma_delete(h);
+
+  /* Ruch po wczytaniu nie zmienia pliku. */
+  h = gamma_load(path);
+  assert(h != NULL);
+  assert(gamma_busy_fields(h, 2) == 0);
+  gamma_delete(h);
+  gamma_delete(g);
+
+  /* Uszkodzona plansza jest wykrywana przy pierwszym pytaniu, gra odrzuca
+   * wtedy ruchy i pytania. Plansza kończy plik, ostatnie pole należy do
+   * gracza 3. */
+  assert(snapshot_poke(path, 'z'));
+  h = gamma_load(path);
+  assert(h != NULL);
+  assert(!gamma_move(h, 2, 5, 5));
+  assert(gamma_field(h, 9, 10) == 0 && gamma_busy_fields(h, 1) == 0);
+  assert(gamma_board(h) == NULL);
+  gamma_delete(h);
+  assert(snapshot_poke(path, '.'));
+  h = gamma_load(path);
+  assert(h != NULL);
+  assert(gamma_free_fields(h, 1) == 0 && !gamma_move(h, 2, 5, 5));
+  gamma_delete(h);
+  assert(snapshot_poke(path, '3'));
+  h = gamma_load(path);
+  assert(h != NULL);
+  assert(gamma_field(h, 9, 10) == 3 && gamma_busy_fields(h, 3) == 2);
+  gamma_delete(h);
+
+  /* Liczby obszarów z pliku są przeliczane: zaniżona liczba nie pozwala
+   * na nowy obszar ponad limit, a zbyt wiele obszarów psuje grę. */
+  g = gamma_new(5, 5, 2, 1);
+  assert(g != NULL);
+  assert(gamma_set_field(g, 1, 0, 0));
+  assert(gamma_save(g, path));
+  h = gamma_load(path);
+  assert(h != NULL);
+  assert(!gamma_move_legal(h, 1, 4, 4));
+  assert(!gamma_move(h, 1, 4, 4));
+  assert(gamma_move(h, 1, 1, 0));
+  gamma_delete(h);
+  assert(gamma_set_field(g, 1, 4, 4));
+  assert(gamma_save(g, path));
+  h = gamma_load(path);
+  assert(h != NULL);
+  assert(!gamma_move(h, 2, 2, 2) && gamma_busy_fields(h, 1) == 0);
+  gamma_delete(h);
+  gamma_delete(g);
+
+  assert(remove(path) == 0);
+  assert(gamma_load(path) == NULL);
+  return PASS;
+}
+
+/* Testuje statystyki silnika. */
+static int stats(void) {
+  gamma_t *g = gamma_new(SMALL_BOARD_SIZE, SMALL_BOARD_SIZE, 2, 1);
+  assert(g != NULL);
+  struct gamma_stats st;
+  assert(!gamma_stats(NULL, &st));
+  assert(!gamma_stats(g, NULL));
+  assert(gamma_stats(g, &st));
+  assert(st.board_bytes >= SMALL_BOARD_SIZE * SMALL_BOARD_SIZE);
+  assert(st.total_bytes >= st.board_bytes + st.players_bytes);
+  assert(!st.board_mapped);
+
+  assert(gamma_move(g, 1, 0, 0));
+  assert(!gamma_move(g, 1, 5, 5));
+  assert(gamma_stats(g, &st));
+  if (st.counters_enabled) {
+    assert(st.counters.rescans_one_player >= 1);
+    assert(st.counters.labeled_tiles >= 1);
+    assert(st.counters.bytes_allocated >= st.board_bytes);
+  }
+  else {
+    assert(st.counters.rescans_one_player == 0);
+  }
+
+  /* Punkt kontrolny i numery obszarów są liczone w pamięci gry. */
+  uint64_t allocated = st.counters.bytes_allocated;
+  assert(st.undo_bytes == 0 && st.components_bytes == 0);
+  assert(gamma_checkpoint(g));
+  assert(gamma_move(g, 1, 1, 0));
+  assert(gamma_area_id(g, 0, 0) != 0);
+  assert(gamma_stats(g, &st));
+  assert(st.undo_bytes > 0 && st.components_bytes > 0);
+  assert(st.total_bytes >= st.undo_bytes + st.components_bytes + st.board_bytes);
+  if (st.counters_enabled)
+    assert(st.counters.bytes_allocated >= allocated + st.undo_bytes + st.components_bytes);
+
+  gamma_delete(g);
+  return PASS;
+}
+
+static int pool(void) {
+  gamma_pool_limit(2);
+  gamma_t *g = gamma_new(SMALL_BOARD_SIZE, SMALL_BOARD_SIZE, 3, 2);
+  assert(g != NULL);
+  assert(gamma_move(g, 1, 0, 0));
+  assert(gamma_move(g, 2, 1, 0));
+  assert(gamma_golden_move(g, 3, 0, 0));
+  gamma_t *old = g;
+  gamma_delete(g);
+
+  g = gamma_new(SMALL_BOARD_SIZE, SMALL_BOARD_SIZE, 3, 2);
+  assert(g == old);
+  assert(gamma_busy_fields(g, 1) == 0);
+  assert(gamma_busy_fields(g, 3) == 0);
+  assert(gamma_free_fields(g, 1) == SMALL_BOARD_SIZE * SMALL_BOARD_SIZE);
+  assert(gamma_field(g, 0, 0) == 0);
+  assert(gamma_move(g, 3, 0, 0));
+  assert(gamma_move(g, 1, 1, 0));
+  assert(gamma_golden_move(g, 3, 1, 0));
+  assert(gamma_busy_fields(g, 3) == 2);
+  gamma_delete(g);
+
+  g = gamma_new(SMALL_BOARD_SIZE + 1, SMALL_BOARD_SIZE, 3, 2);
+  assert(g != NULL);
+  assert(gamma_busy_fields(g, 3) == 0);
+  assert(gamma_move(g, 3, SMALL_BOARD_SIZE, 0));
+  gamma_delete(g);
+
+  gamma_pool_limit(0);
+  return PASS;
+}
+
+/* Testuje zapamiętywanie wyników zapytań między ruchami. */
+static int query_cache(void) {
+  gamma_t *g = gamma_new(10, 10, 3, 1);
+  assert(g != NULL);
+  struct gamma_stats st;
+  assert(gamma_move(g, 1, 0, 0));
+  assert(gamma_move(g, 2, 1, 0));
+  assert(gamma_free_fields(g, 1) == 1);
+  assert(gamma_free_fields(g, 1) == 1);
+  assert(gamma_golden_possible(g, 1));
+  assert(gamma_golden_possible(g, 1));
+  assert(gamma_stats(g, &st));
+  if (st.counters_enabled) {
+    assert(st.counters.free_fields_cached == 1);
+    assert(st.counters.golden_possible_cached == 1);
+  }
+
+  /* Ruchy, które nie dotykają pól gracza 1 ani wolnych pól obok nich,
+   * oraz nieudane ruchy nie zmieniają jego wyniku... */
+  assert(gamma_move(g, 3, 5, 5));
+  assert(gamma_free_fields(g, 1) == 1);
+  assert(gamma_move(g, 2, 0, 1) == false);
+  assert(gamma_free_fields(g, 1) == 1);
+  assert(gamma_move(g, 2, 1, 1));
+  assert(gamma_free_fields(g, 1) == 1);
+  assert(gamma_stats(g, &st));
+  if (st.counters_enabled)
+    assert(st.counters.free_fields_cached == 4);
+
+  /* ...a ruchy na jego granicy zmieniają. */
+  assert(gamma_move(g, 2, 0, 1));
+  assert(gamma_free_fields(g, 1) == 0);
+  assert(gamma_golden_possible(g, 1));
+  assert(gamma_golden_move(g, 1, 1, 0));
+  assert(gamma_free_fields(g, 1) == 1);
+  assert(gamma_free_fields(g, 2) == 3);
+  assert(gamma_golden_possible(g, 1) == false);
+
+  /* Zmiany poza ruchami też unieważniają zapamiętane wyniki. */
+  assert(gamma_set_golden(g, 1, true));
+  assert(gamma_golden_possible(g, 1));
+  assert(gamma_set_field(g, 0, 1, 1));
+  assert(gamma_free_fields(g, 2) == 2);
+  assert(gamma_free_fields(g, 1) == 2);
+  gamma_delete(g);
+  return PASS;
+}
+
+/* Testuje grę umieszczoną na dużych stronach pamięci. */
+static int huge_pages(void) {
+  struct gamma_stats st;
+  gamma_t *g = gamma_new(SMALL_BOARD_SIZE, SMALL_BOARD_SIZE, 3, 2);
+  assert(g != NULL);
+  assert(gamma_stats(g, &st) && st.pages == GAMMA_PAGES_NORMAL);
+  gamma_delete(g);
+
+  /* Rodzaj stron zależy od systemu, ale gra musi działać na każdym. */
+  gamma_pool_limit(2);
+  gamma_huge_pages(1);
+  for (int i = 0; i < 3; ++i) {
+    g = gamma_new_storage(SMALL_BOARD_SIZE, SMALL_BOARD_SIZE, 3, 2, i);
+    assert(g != NULL);
+    assert(gamma_move(g, 1, 0, 0));
+    assert(gamma_move(g, 2, 1, 0));
+    assert(gamma_golden_move(g, 3, 0, 0));
+    assert(gamma_free_fields(g, 1) == SMALL_BOARD_SIZE * SMALL_BOARD_SIZE - 2);
+    assert(gamma_stats(g, &st));
+    assert(st.pages == GAMMA_PAGES_NORMAL ||
+           st.pages == GAMMA_PAGES_TRANSPARENT || st.pages == GAMMA_PAGES_HUGE);
+    gamma_delete(g);
+  }
+  g = gamma_new(SMALL_BOARD_SIZE, SMALL_BOARD_SIZE, 3, 2);
+  assert(g != NULL);
+  assert(gamma_busy_fields(g, 2) == 0);
+  gamma_delete(g);
+
+  gamma_huge_pages((uint64_t)256 << 20);
+  gamma_pool_limit(0);
+  return PASS;
+}
+
+/* Sprawdza, czy przeliczenie obszarów w wielu wątkach daje te same wyniki. */
+static int parallel_areas(void) {
+  const uint32_t width = 1200, height = 1000, players = 5;
+  gamma_t *g = gamma_new(width, height, players, UINT32_MAX);
+  assert(g != NULL);
+  uint64_t seed = 12345;
+  for (uint32_t y = 0; y < height; ++y)
+    for (uint32_t x = 0; x < width; ++x) {
+      seed = seed * 6364136223846793005u + 1442695040888963407u;
+      uint32_t player = (seed >> 33) % (players + 1);
+      /* Pionowe pasy gracza 1 przecinają granice wszystkich pasów wierszy. */
+      if (x % 100 == 0)
+        player = 1;
+      else if (x % 100 == 1)
+        player = 0;
+      gamma_set_field(g, player, x, y);
+    }
+
+  uint32_t areas[players];
+  gamma_threads(1);
+  gamma_recount_areas(g);
+  for (uint32_t i = 0; i < players; ++i)
+    areas[i] = g->players_area[i];
+  assert(areas[0] >= width / 100);
+
+  gamma_threads(4);
+  gamma_recount_areas(g);
+  for (uint32_t i = 0; i < players; ++i)
+    assert(g->players_area[i] == areas[i]);
+  for (uint32_t i = 0; i < width * height; ++i)
+    assert(g->visited[i] == 0);
+
+  gamma_threads(0);
+  gamma_delete(g);
+  return PASS;
+}
+
+/* Sprawdza, czy plansza przechowywana w sposób @p storage działa tak samo
+ * jak zwykła tablica w losowej grze. */
+static void storage_same(enum gamma_storage storage, uint32_t width,
+                         uint32_t height, uint32_t players, uint32_t areas) {
+  gamma_t *a = gamma_new_storage(width, height, players, areas,
+                                 GAMMA_STORAGE_ARRAY);
+  gamma_t *r = gamma_new_storage(width, height, players, areas, storage);
+  assert(a != NULL && r != NULL);
+  uint64_t seed = 2020;
+  for (uint32_t i = 0; i < 20000; ++i) {
+    seed = seed * 6364136223846793005u + 1442695040888963407u;
+    uint32_t player = (seed >> 33) % players + 1;
+    /* Ruchy skupione w pasie planszy tworzą długie serie. */
+    uint32_t x = (seed >> 40) % width;
+    uint32_t y = (seed >> 20) % height;
+    if ((seed >> 60) == 0)
+      assert(gamma_golden_move(a, player, x, y) ==
+             gamma_golden_move(r, player, x, y));
+    else
+      assert(gamma_move(a, player, x, y) == gamma_move(r, player, x, y));
+    assert(gamma_busy_fields(a, player) == gamma_busy_fields(r, player));
+    assert(gamma_free_fields(a, player) == gamma_free_fields(r, player));
+    if (i % 97 == 0) {
+      assert(gamma_golden_possible(a, player) ==
+             gamma_golden_possible(r, player));
+      char *pa = gamma_board(a), *pr = gamma_board(r);
+      assert(pa != NULL && pr != NULL && strcmp(pa, pr) == 0);
+      free(pa);
+      free(pr);
+      gamma_recount_areas(r);
+      for (uint32_t k = 0; k < players; ++k)
+        assert(a->players_area[k] == r->players_area[k]);
+    }
+  }
+
+  /* Zapis zawsze ma zwykłą postać i wczytuje się jako tablica. */
+  static const char path[] = "gamma_test_storage.bin";
+  assert(gamma_save(r, path));
+  gamma_t *h = gamma_load(path);
+  assert(h != NULL);
+  char *pa = gamma_board(a), *ph = gamma_board(h);
+  assert(pa != NULL && ph != NULL && strcmp(pa, ph) == 0);
+  free(pa);
+  free(ph);
+  gamma_delete(h);
+  assert(remove(path) == 0);
+  gamma_delete(a);
+  gamma_delete(r);
+}
+
+/* Sprawdza, czy plansza z wierszami kodowanymi długościami serii działa
+ * tak samo jak zwykła tablica. */
+static int rle_storage(void) {
+  storage_same(GAMMA_STORAGE_RLE, 37, 23, 4, 6);
+  assert(gamma_new_storage(37, 23, 4, 6, 7) == NULL);
+
+  /* Plansza, która nie była zmieniana, zajmuje jedynie tablicę wierszy. */
+  gamma_t *r = gamma_new_storage(20000, 20000, 2, 2, GAMMA_STORAGE_RLE);
+  assert(r != NULL);
+  struct gamma_stats st;
+  gamma_stats(r, &st);
+  assert(st.board_bytes == 0 && st.visited_bytes == 0);
+  assert(gamma_move(r, 1, 19999, 19999));
+  assert(gamma_free_fields(r, 1) == 20000ull * 20000 - 1);
+  gamma_delete(r);
+  return PASS;
+}
+
+/* Sprawdza, czy plansza podzielona na bloki działa tak samo jak zwykła
+ * tablica, także gdy bloki wystają poza planszę. */
+static int tiled_storage(void) {
+  storage_same(GAMMA_STORAGE_TILED, 37, 23, 4, 6);
+  storage_same(GAMMA_STORAGE_TILED, 16, 8, 3, 2);
+  storage_same(GAMMA_STORAGE_TILED, 1, 29, 12, 3);
+
+  gamma_t *g = gamma_new_storage(9, 9, 2, 1, GAMMA_STORAGE_TILED);
+  assert(g != NULL);
+  struct gamma_stats st;
+  gamma_stats(g, &st);
+  assert(st.board_bytes == 4 * 64 * sizeof(int) && st.rows_bytes == 0);
+  assert(gamma_move(g, 1, 8, 8));
+  assert(gamma_move(g, 1, 7, 8));
+  assert(gamma_move(g, 2, 8, 7));
+  assert(gamma_free_fields(g, 1) == 2);
+  char *p = gamma_board(g);
+  assert(p != NULL && strncmp(p, ".......11\n........2\n", 20) == 0);
+  free(p);
+  gamma_delete(g);
+  return PASS;
+}
+
+/* Sprawdza, czy plansza z komórkami szerokości dobranej do liczby graczy
+ * działa tak samo jak plansza z blokami o komórkach typu int. */
+static int cell_widths(void) {
+  storage_same(GAMMA_STORAGE_TILED, 37, 23, 4, 6);
+  storage_same(GAMMA_STORAGE_TILED, 31, 17, 300, 40);
+  storage_same(GAMMA_STORAGE_TILED, 13, 11, 70000, 9);
+
+  static const uint32_t players[] = {207, 208, 65487, 65488};
+  static const uint64_t bytes[] = {1, 2, 2, 4};
+  static const char path[] = "gamma_test_cells.bin";
+  for (size_t i = 0; i < SIZE(players); ++i) {
+    gamma_t *g = gamma_new(5, 4, players[i], 1);
+    assert(g != NULL);
+    struct gamma_stats st;
+    gamma_stats(g, &st);
+    assert(st.board_bytes == 5 * 4 * bytes[i]);
+    assert(gamma_move(g, players[i], 4, 3));
+    assert(gamma_move(g, players[i], 3, 3));
+    assert(gamma_move(g, 1, 0, 0));
+    assert(gamma_free_fields(g, players[i]) == 3);
+
+    /* Zapis zachowuje szerokość komórek. */
+    assert(gamma_save(g, path));
+    gamma_t *h = gamma_load(path);
+    assert(h != NULL);
+    gamma_stats(h, &st);
+    assert(st.board_bytes == 5 * 4 * bytes[i]);
+    assert(gamma_busy_fields(h, players[i]) == 2);
+    assert(gamma_free_fields(h, players[i]) == 3);
+    char *pg = gamma_board(g), *ph = gamma_board(h);
+    assert(pg != NULL && ph != NULL && strcmp(pg, ph) == 0);
+    free(pg);
+    free(ph);
+    gamma_delete(h);
+    assert(remove(path) == 0);
+    gamma_delete(g);
+  }
+  return PASS;
+}
+
+/* Sprawdza, czy przeliczanie obszarów i liczenie pól po listach pól graczy
+ * daje to samo co przejście całej planszy (plansza RLE nie ma list). */
+static int tile_lists(void) {
+  storage_same(GAMMA_STORAGE_RLE, 64, 48, 400, 2);
+  storage_same(GAMMA_STORAGE_RLE, 60, 70, 500, 1);
+
+  gamma_t *g = gamma_new(100, 100, 3, 1);
+  assert(g != NULL);
+  struct gamma_stats st;
+  gamma_stats(g, &st);
+  assert(st.lists_bytes == 3 * sizeof(struct tile_list));
+  assert(gamma_move(g, 1, 50, 50));
+  assert(gamma_move(g, 1, 51, 50));
+  assert(gamma_move(g, 2, 52, 50));
+  assert(gamma_move(g, 3, 53, 50));
+  assert(!gamma_move(g, 1, 60, 60));
+  assert(gamma_free_fields(g, 1) == 5);
+  assert(gamma_free_fields(g, 3) == 3);
+  assert(gamma_golden_possible(g, 3));
+  assert(gamma_golden_move(g, 3, 52, 50));
+  assert(gamma_free_fields(g, 3) == 5);
+  assert(gamma_busy_fields(g, 2) == 0);
+  gamma_stats(g, &st);
+  assert(st.lists_bytes > 3 * sizeof(struct tile_list));
+
+  /* Wczytana gra odtwarza listy z planszy. */
+  static const char path[] = "gamma_test_lists.bin";
+  assert(gamma_save(g, path));
+  gamma_t *h = gamma_load(path);
+  assert(h != NULL);
+  assert(gamma_free_fields(h, 1) == 5);
+  assert(!gamma_move(h, 1, 60, 60));
+  assert(gamma_move(h, 2, 49, 50));
+  assert(gamma_free_fields(h, 1) == 4);
+  gamma_delete(h);
+  assert(remove(path) == 0);
+  gamma_delete(g);
+  return PASS;
+}
+
+/* Sprawdza, czy przejścia planszy pomijające bloki na podstawie ich
+ * podsumowań liczą to samo co plansza RLE (bez podsumowań). */
+static int block_summaries(void) {
+  storage_same(GAMMA_STORAGE_RLE, 150, 40, 3, 4);
+  storage_same(GAMMA_STORAGE_RLE, 70, 20, 2, 1);
+
+  static const enum gamma_storage storage[] = {GAMMA_STORAGE_ARRAY,
+                                               GAMMA_STORAGE_TILED};
+  for (size_t i = 0; i < SIZE(storage); ++i) {
+    gamma_t *g = gamma_new_storage(200, 100, 3, 1, storage[i]);
+    assert(g != NULL);
+    /* Pełne bloki jednego gracza i puste bloki z dala od niego. */
+    for (uint32_t y = 0; y < 16; ++y)
+      for (uint32_t x = 0; x < 128; ++x)
+        assert(gamma_move(g, 1, x, y));
+    assert(gamma_move(g, 2, 150, 90));
+    assert(gamma_move(g, 3, 128, 0));
+    assert(gamma_free_fields(g, 1) == 128 + 15);
+    assert(!gamma_move(g, 1, 180, 50));
+    assert(gamma_golden_possible(g, 3));
+    assert(gamma_golden_move(g, 3, 127, 0));
+    assert(gamma_move(g, 2, 149, 90));
+    assert(gamma_free_fields(g, 1) == 128 + 15);
+    gamma_recount_areas(g);
+    assert(g->players_area[0] == 1 && g->players_area[2] == 1);
+    struct gamma_stats st;
+    gamma_stats(g, &st);
+    assert(!st.counters_enabled || st.counters.summary_skipped_tiles > 0);
+    assert(st.summary_bytes > 0);
+    gamma_delete(g);
+  }
+  return PASS;
+}
+
+/* Porównuje wyniki wszystkich graczy naraz z wynikami dla pojedynczych
+ * graczy w takiej samej grze, w której nic innego nie jest liczone. */
+static void all_fields_same(enum gamma_storage storage, uint32_t width,
+                            uint32_t height, uint32_t players, uint32_t areas) {
+  gamma_t *a = gamma_new_storage(width, height, players, areas, storage);
+  gamma_t *o = gamma_new_storage(width, height, players, areas, storage);
+  uint64_t *busy = malloc(players * sizeof(uint64_t));
+  uint64_t *free_fields = malloc(players * sizeof(uint64_t));
+  assert(a != NULL && o != NULL && busy != NULL && free_fields != NULL);
+  uint64_t seed = 42;
+  for (uint32_t i = 0; i < 3000; ++i) {
+    seed = seed * 6364136223846793005u + 1442695040888963407u;
+    uint32_t player = (seed >> 33) % players + 1;
+    uint32_t x = (seed >> 40) % width;
+    uint32_t y = (seed >> 20) % height;
+    if ((seed >> 59) == 0)
+      assert(gamma_golden_move(a, player, x, y) ==
+             gamma_golden_move(o, player, x, y));
+    else
+      assert(gamma_move(a, player, x, y) == gamma_move(o, player, x, y));
+    if (i % 31 == 0) {
+      assert(gamma_all_busy_fields(a, busy));
+      assert(gamma_all_free_fields(a, free_fields));
+      for (uint32_t k = 0; k < players; ++k) {
+        assert(busy[k] == gamma_busy_fields(o, k + 1));
+        assert(free_fields[k] == gamma_free_fields(o, k + 1));
+      }
+    }
+  }
+  free(busy);
+  free(free_fields);
+  gamma_delete(a);
+  gamma_delete(o);
+}
+
+/* Sprawdza wyniki wszystkich graczy naraz. */
+static int all_fields(void) {
+  all_fields_same(GAMMA_STORAGE_ARRAY, 90, 70, 5, 3);
+  all_fields_same(GAMMA_STORAGE_ARRAY, 40, 30, 300, 1);
+  all_fields_same(GAMMA_STORAGE_ARRAY, 40, 30, 3, 8);
+  all_fields_same(GAMMA_STORAGE_ARRAY, 30, 30, 2, 30);
+  all_fields_same(GAMMA_STORAGE_TILED, 50, 40, 4, 2);
+  all_fields_same(GAMMA_STORAGE_RLE, 50, 40, 4, 2);
+
+  uint64_t out[3];
+  assert(!gamma_all_busy_fields(NULL, out));
+  assert(!gamma_all_free_fields(NULL, out));
+  gamma_t *g = gamma_new(4, 4, 3, 1);
+  assert(g != NULL);
+  assert(!gamma_all_free_fields(g, NULL));
+  assert(gamma_move(g, 1, 0, 0));
+  assert(gamma_move(g, 2, 3, 3));
+  assert(gamma_move(g, 3, 1, 1));
+  assert(gamma_all_free_fields(g, out));
+  assert(out[0] == 2 && out[1] == 2 && out[2] == 4);
+  assert(gamma_all_busy_fields(g, out));
+  assert(out[0] == 1 && out[1] == 1 && out[2] == 1);
+  gamma_delete(g);
+  return PASS;
+}
+
+/* Porównuje ciągi ruchów z kolejnymi wywołaniami gamma_move. */
+static void move_batch_same(enum gamma_storage storage, uint32_t width,
+                            uint32_t height, uint32_t players, uint32_t areas,
+                            size_t length) {
+  gamma_t *a = gamma_new_storage(width, height, players, areas, storage);
+  gamma_t *o = gamma_new_storage(width, height, players, areas, storage);
+  struct gamma_move_request *moves = malloc(length * sizeof(*moves));
+  bool *results = malloc(length * sizeof(bool));
+  bool *expected = malloc(length * sizeof(bool));
+  assert(a != NULL && o != NULL && moves != NULL && results != NULL &&
+         expected != NULL);
+  uint64_t seed = 7;
+  for (uint32_t round = 0; round < 40; ++round) {
+    for (size_t i = 0; i < length; ++i) {
+      seed = seed * 6364136223846793005u + 1442695040888963407u;
+      /* Czasem niepoprawny gracz albo pole poza planszą. */
+      moves[i].player = (seed >> 33) % (players + 1) + (seed >> 62 == 0);
+      moves[i].x = (seed >> 40) % (width + 1);
+      moves[i].y = (seed >> 20) % height;
+    }
+    size_t made = 0;
+    for (size_t i = 0; i < length; ++i) {
+      expected[i] = gamma_move(o, moves[i].player, moves[i].x, moves[i].y);
+      made += expected[i];
+    }
+    assert(gamma_move_batch(a, moves, length, results) == made);
+    assert(memcmp(results, expected, length * sizeof(bool)) == 0);
+    for (uint32_t k = 1; k <= players; ++k) {
+      assert(gamma_busy_fields(a, k) == gamma_busy_fields(o, k));
+      assert(gamma_free_fields(a, k) == gamma_free_fields(o, k));
+      assert(gamma_golden_possible(a, k) == gamma_golden_possible(o, k));
+    }
+  }
+  char *board_a = gamma_board(a);
+  char *board_o = gamma_board(o);
+  assert(board_a != NULL && board_o != NULL && strcmp(board_a, board_o) == 0);
+  free(board_a);
+  free(board_o);
+  free(moves);
+  free(results);
+  free(expected);
+  gamma_delete(a);
+  gamma_delete(o);
+}
+
+/* Sprawdza wykonywanie ciągów ruchów. */
+static int move_batch(void) {
+  move_batch_same(GAMMA_STORAGE_ARRAY, 30, 20, 4, 3, 100);
+  move_batch_same(GAMMA_STORAGE_ARRAY, 30, 20, 4, 1, 3);
+  move_batch_same(GAMMA_STORAGE_ARRAY, 25, 25, 2, 12, 50);
+  move_batch_same(GAMMA_STORAGE_ARRAY, 20, 20, 300, 2, 200);
+  move_batch_same(GAMMA_STORAGE_TILED, 30, 20, 4, 3, 100);
+  move_batch_same(GAMMA_STORAGE_RLE, 30, 20, 4, 3, 100);
+
+  struct gamma_move_request moves[3] = {{1, 0, 0}, {2, 0, 0}, {1, 1, 1}};
+  bool results[3];
+  assert(gamma_move_batch(NULL, moves, 3, results) == 0);
+  gamma_t *g = gamma_new(4, 4, 2, 1);
+  assert(g != NULL);
+  assert(gamma_move_batch(g, NULL, 3, results) == 0);
+  assert(gamma_move_batch(g, moves, 0, results) == 0);
+  assert(gamma_free_fields(g, 2) == 16);
+  assert(gamma_move_batch(g, moves, 3, results) == 1);
+  assert(results[0] && !results[1] && !results[2]);
+  /* Zapamiętany wynik zapytania musi się zmienić. */
+  assert(gamma_free_fields(g, 2) == 15);
+  assert(gamma_move_batch(g, moves + 2, 1, NULL) == 0);
+  gamma_delete(g);
+  return PASS;
+}
+
+/* Porównuje legalne ruchy z wynikami gamma_move. */
+static void legal_moves_same(enum gamma_storage storage, uint32_t width,
+                             uint32_t height, uint32_t players,
+                             uint32_t areas) {
+  gamma_t *a = gamma_new_storage(width, height, players, areas, storage);
+  gamma_t *o = gamma_new_storage(width, height, players, areas, storage);
+  size_t words = ((size_t)width * height + 63) / 64;
+  uint64_t *bits = malloc(words * sizeof(uint64_t));
+  assert(a != NULL && o != NULL && bits != NULL);
+  uint64_t seed = 11;
+  for (uint32_t i = 0; i < 2000; ++i) {
+    seed = seed * 6364136223846793005u + 1442695040888963407u;
+    uint32_t player = (seed >> 33) % players + 1;
+    uint32_t x = (seed >> 40) % width;
+    uint32_t y = (seed >> 20) % height;
+    bool legal = gamma_move_legal(a, player, x, y);
+    assert(gamma_move(a, player, x, y) == legal);
+    assert(gamma_move(o, player, x, y) == legal);
+    if (i % 97 == 0) {
+      uint32_t k = i % players + 1;
+      uint64_t count = 0;
+      assert(gamma_legal_moves(a, k, bits) <= (uint64_t)width * height);
+      for (uint32_t yy = 0; yy < height; ++yy)
+        for (uint32_t xx = 0; xx < width; ++xx) {
+          uint64_t bit = (uint64_t)yy * width + xx;
+          bool set = (bits[bit / 64] >> (bit % 64)) & 1;
+          assert(set == gamma_move_legal(a, k, xx, yy));
+          count += set;
+        }
+      assert(gamma_legal_moves(a, k, bits) == count);
+    }
+  }
+  char *board_a = gamma_board(a);
+  char *board_o = gamma_board(o);
+  assert(board_a != NULL && board_o != NULL && strcmp(board_a, board_o) == 0);
+  free(board_a);
+  free(board_o);
+  free(bits);
+  gamma_delete(a);
+  gamma_delete(o);
+}
+
+/* Sprawdza legalność ruchów bez ich wykonywania. */
+static int legal_moves(void) {
+  legal_moves_same(GAMMA_STORAGE_ARRAY, 70, 30, 4, 3);
+  legal_moves_same(GAMMA_STORAGE_ARRAY, 30, 30, 2, 20);
+  legal_moves_same(GAMMA_STORAGE_ARRAY, 20, 20, 300, 1);
+  legal_moves_same(GAMMA_STORAGE_TILED, 70, 30, 4, 3);
+  legal_moves_same(GAMMA_STORAGE_RLE, 70, 30, 4, 3);
+
+  uint64_t bits[1];
+  assert(!gamma_move_legal(NULL, 1, 0, 0));
+  assert(gamma_legal_moves(NULL, 1, bits) == 0);
+  gamma_t *g = gamma_new(5, 5, 2, 1);
+  assert(g != NULL);
+  assert(gamma_legal_moves(g, 1, NULL) == 0);
+  assert(gamma_legal_moves(g, 3, bits) == 0);
+  assert(!gamma_move_legal(g, 0, 0, 0));
+  assert(!gamma_move_legal(g, 1, 5, 0));
+  assert(gamma_legal_moves(g, 1, bits) == 25);
+  assert(bits[0] == ((uint64_t)1 << 25) - 1);
+  assert(gamma_move(g, 1, 2, 2));
+  assert(gamma_move(g, 2, 2, 3));
+  assert(!gamma_move_legal(g, 1, 2, 2));
+  assert(!gamma_move_legal(g, 1, 0, 0));
+  assert(gamma_move_legal(g, 1, 1, 2));
+  /* Wolne pola obok (2, 2): (1, 2), (3, 2), (2, 1). */
+  assert(gamma_legal_moves(g, 1, bits) == 3);
+  assert(bits[0] == ((uint64_t)1 << 11 | (uint64_t)1 << 13 |
+                     (uint64_t)1 << 7));
+  assert(gamma_busy_fields(g, 1) == 1);
+  gamma_delete(g);
+
+  /* Przy oszacowanej liczbie obszarów sprawdzenie ruchu nie zmienia gry. */
+  g = gamma_new(5, 5, 2, 2);
+  assert(g != NULL);
+  assert(gamma_move(g, 1, 0, 0));
+  assert(gamma_move(g, 1, 2, 0));
+  assert(gamma_move(g, 1, 1, 0));
+  struct gamma_stats before, after;
+  assert(gamma_stats(g, &before));
+  uint64_t hash = gamma_hash(g);
+  assert(gamma_move_legal(g, 1, 4, 4));
+  assert(gamma_move_legal(g, 1, 1, 1));
+  assert(gamma_move_legal(g, 2, 4, 4));
+  assert(gamma_stats(g, &after));
+  assert(after.counters.rescans_one_player == before.counters.rescans_one_player);
+  assert(after.counters.bytes_allocated == before.counters.bytes_allocated);
+  assert(gamma_hash(g) == hash);
+  assert(gamma_move(g, 1, 4, 4));
+  assert(!gamma_move_legal(g, 1, 0, 4));
+  assert(!gamma_move(g, 1, 0, 4));
+  gamma_delete(g);
+  return PASS;
+}
+
+/* Porównuje liczby pól w prostokątach z gamma_field. */
+static void count_rect_same(enum gamma_storage storage, uint32_t width,
+                            uint32_t height, uint32_t players,
+                            uint32_t areas) {
+  gamma_t *g = gamma_new_storage(width, height, players, areas, storage);
+  assert(g != NULL);
+  uint64_t seed = 5;
+  for (uint32_t i = 0; i < 4000; ++i) {
+    seed = seed * 6364136223846793005u + 1442695040888963407u;
+    uint32_t player = (seed >> 33) % players + 1;
+    /* Ruchy skupione w lewej części planszy, żeby były pełne bloki. */
+    uint32_t x = (seed >> 40) % (width / 2);
+    uint32_t y = (seed >> 20) % height;
+    gamma_move(g, player, x, y);
+    if (i % 400 == 0) {
+      for (uint32_t k = 0; k < 20; ++k) {
+        seed = seed * 6364136223846793005u + 1442695040888963407u;
+        uint32_t x0 = (seed >> 33) % width;
+        uint32_t y0 = (seed >> 45) % height;
+        uint32_t x1 = x0 + (seed >> 20) % width;
+        uint32_t y1 = y0 + (seed >> 10) % height;
+        uint32_t p = k % (players + 1);
+        uint64_t count = 0;
+        for (uint32_t yy = y0; yy <= y1 && yy < height; ++yy)
+          for (uint32_t xx = x0; xx <= x1 && xx < width; ++xx)
+            count += gamma_field(g, xx, yy) == p;
+        assert(gamma_count_rect(g, p, x0, y0, x1, y1) == count);
+      }
+      uint64_t taken = 0;
+      for (uint32_t p = 1; p <= players; ++p) {
+        taken += gamma_busy_fields(g, p);
+        assert(gamma_count_rect(g, p, 0, 0, width - 1, height - 1) ==
+               gamma_busy_fields(g, p));
+      }
+      assert(gamma_count_rect(g, 0, 0, 0, width - 1, height - 1) ==
+             (uint64_t)width * height - taken);
+    }
+  }
+  gamma_delete(g);
+}
+
+/* Sprawdza liczenie pól w prostokątach. */
+static int count_rect(void) {
+  count_rect_same(GAMMA_STORAGE_ARRAY, 200, 40, 2, 4);
+  count_rect_same(GAMMA_STORAGE_ARRAY, 150, 30, 5, 40);
+  count_rect_same(GAMMA_STORAGE_ARRAY, 100, 20, 300, 100);
+  count_rect_same(GAMMA_STORAGE_TILED, 150, 30, 2, 40);
+  count_rect_same(GAMMA_STORAGE_RLE, 150, 30, 2, 40);
+
+  assert(gamma_count_rect(NULL, 0, 0, 0, 1, 1) == 0);
+  gamma_t *g = gamma_new(130, 20, 2, 2);
+  assert(g != NULL);
+  assert(gamma_count_rect(g, 3, 0, 0, 1, 1) == 0);
+  assert(gamma_count_rect(g, 0, 130, 0, 131, 1) == 0);
+  assert(gamma_count_rect(g, 0, 5, 0, 4, 1) == 0);
+  assert(gamma_count_rect(g, 0, 0, 0, UINT32_MAX, UINT32_MAX) == 2600);
+  assert(gamma_count_rect(g, 0, 10, 2, 100, 9) == 728);
+  for (uint32_t x = 0; x < 64; ++x)
+    for (uint32_t y = 0; y < 8; ++y)
+      assert(gamma_move(g, 1, x, y));
+  assert(gamma_move(g, 2, 100, 10));
+  assert(gamma_count_rect(g, 1, 0, 0, 129, 19) == 512);
+  assert(gamma_count_rect(g, 1, 3, 2, 70, 10) == 61 * 6);
+  assert(gamma_count_rect(g, 0, 3, 2, 70, 10) == 68 * 9 - 61 * 6);
+  assert(gamma_count_rect(g, 2, 100, 10, 100, 10) == 1);
+  assert(gamma_count_rect(g, 2, 0, 0, 99, 19) == 0);
+  gamma_delete(g);
+  return PASS;
+}
+
+/* Porównuje obszary silnika z obszarami policzonymi przeszukiwaniem. */
+static void area_ids_check(gamma_t *g, uint32_t width, uint32_t height,
+                           uint32_t players, uint32_t *label, uint32_t *stack,
+                           uint64_t *ids) {
+  size_t cells = (size_t)width * height;
+  for (size_t i = 0; i < cells; ++i)
+    label[i] = UINT32_MAX;
+  for (uint32_t p = 1; p <= players; ++p) {
+    uint64_t areas = 0;
+    for (size_t i = 0; i < cells; ++i) {
+      if (label[i] != UINT32_MAX || gamma_field(g, i % width, i / width) != p)
+        continue;
+      /* Nowy obszar: wszystkie jego pola mają ten sam identyfikator. */
+      uint64_t id = gamma_area_id(g, i % width, i / width);
+      uint64_t size = 0;
+      size_t top = 0;
+      stack[top++] = i;
+      label[i] = areas;
+      while (top > 0) {
+        uint32_t c = stack[--top];
+        uint32_t x = c % width, y = c / width;
+        assert(gamma_area_id(g, x, y) == id);
+        size++;
+        uint32_t near[4] = {c + 1, c - 1, c + width, c - width};
+        bool ok[4] = {x + 1 < width, x > 0, y + 1 < height, y > 0};
+        for (int k = 0; k < 4; ++k) {
+          if (ok[k] && label[near[k]] == UINT32_MAX &&
+              gamma_field(g, near[k] % width, near[k] / width) == p) {
+            label[near[k]] = areas;
+            stack[top++] = near[k];
+          }
+        }
+      }
+      assert(gamma_area_size(g, id) == size);
+      /* Identyfikator jest jednym z obszarów gracza. */
+      uint64_t count = gamma_player_areas(g, p, ids, cells);
+      bool found = false;
+      for (uint64_t k = 0; k < count; ++k)
+        found |= ids[k] == id;
+      assert(found);
+      areas++;
+    }
+    assert(gamma_player_areas(g, p, NULL, 0) == areas);
+  }
+}
+
+/* Sprawdza identyfikatory i rozmiary obszarów. */
+static int area_ids(void) {
+  enum gamma_storage storages[3] = {GAMMA_STORAGE_ARRAY, GAMMA_STORAGE_TILED,
+                                    GAMMA_STORAGE_RLE};
+  uint32_t width = 23, height = 17, players = 3;
+  size_t cells = (size_t)width * height;
+  uint32_t *label = malloc(cells * sizeof(uint32_t));
+  uint32_t *stack = malloc(cells * sizeof(uint32_t));
+  uint64_t *ids = malloc(cells * sizeof(uint64_t));
+  assert(label != NULL && stack != NULL && ids != NULL);
+  for (int s = 0; s < 3; ++s) {
+    gamma_t *g = gamma_new_storage(width, height, players, 40, storages[s]);
+    assert(g != NULL);
+    uint64_t seed = 3;
+    for (uint32_t i = 0; i < 600; ++i) {
+      seed = seed * 6364136223846793005u + 1442695040888963407u;
+      uint32_t player = (seed >> 33) % players + 1;
+      uint32_t x = (seed >> 40) % width;
+      uint32_t y = (seed >> 20) % height;
+      if ((seed >> 58) == 0)
+        gamma_golden_move(g, player, x, y);
+      else if ((seed >> 58) == 1)
+        gamma_set_field(g, (seed >> 10) % (players + 1), x, y);
+      else
+        gamma_move(g, player, x, y);
+      if (i % 50 == 0)
+        area_ids_check(g, width, height, players, label, stack, ids);
+    }
+    area_ids_check(g, width, height, players, label, stack, ids);
+    gamma_delete(g);
+  }
+  free(label);
+  free(stack);
+  free(ids);
+
+  assert(gamma_area_id(NULL, 0, 0) == 0);
+  assert(gamma_area_size(NULL, 1) == 0);
+  assert(gamma_player_areas(NULL, 1, NULL, 0) == 0);
+  gamma_t *g = gamma_new(10, 10, 2, 5);
+  assert(g != NULL);
+  assert(gamma_area_id(g, 0, 0) == 0);
+  assert(gamma_area_id(g, 10, 0) == 0);
+  assert(gamma_area_size(g, 0) == 0);
+  assert(gamma_area_size(g, 101) == 0);
+  assert(gamma_player_areas(g, 3, NULL, 0) == 0);
+  assert(gamma_move(g, 1, 0, 0));
+  assert(gamma_move(g, 1, 1, 0));
+  assert(gamma_move(g, 1, 3, 0));
+  uint64_t big = gamma_area_id(g, 0, 0);
+  uint64_t small = gamma_area_id(g, 3, 0);
+  assert(big != 0 && small != 0 && big != small);
+  assert(gamma_area_size(g, big) == 2);
+  assert(gamma_area_size(g, small) == 1);
+  /* Mniejszy obszar dołącza do większego, który zachowuje identyfikator. */
+  assert(gamma_move(g, 1, 2, 0));
+  assert(gamma_area_id(g, 3, 0) == big);
+  assert(gamma_area_size(g, big) == 4);
+  assert(gamma_area_size(g, small) == 0);
+  uint64_t one;
+  assert(gamma_player_areas(g, 1, &one, 1) == 1);
+  assert(one == big);
+  struct gamma_stats st;
+  assert(gamma_stats(g, &st));
+  assert(st.components_bytes >= 100 * 2 * sizeof(uint32_t));
+  gamma_delete(g);
+
+  /* Przy aktualnych identyfikatorach ruchy łączące obszary liczą je
+   * dokładnie. */
+  g = gamma_new(23, 17, 3, 40);
+  assert(g != NULL);
+  assert(gamma_area_id(g, 0, 0) == 0);
+  uint64_t seed = 5;
+  for (uint32_t i = 0; i < 1000; ++i) {
+    seed = seed * 6364136223846793005u + 1442695040888963407u;
+    uint32_t player = (seed >> 33) % 3 + 1;
+    gamma_move(g, player, (seed >> 40) % 23, (seed >> 20) % 17);
+    for (uint32_t p = 1; p <= 3; ++p) {
+      uint32_t counted = g->players_area[p - 1];
+      assert(counted == gamma_player_areas(g, p, NULL, 0));
+    }
+  }
+  gamma_delete(g);
+  return PASS;
+}
+
+static int rollback(void) {
+  enum gamma_storage storages[3] = {GAMMA_STORAGE_ARRAY, GAMMA_STORAGE_TILED,
+                                    GAMMA_STORAGE_RLE};
+  uint32_t width = 19, height = 13, players = 3;
+  for (int s = 0; s < 3; ++s) {
+    gamma_t *g = gamma_new_storage(width, height, players, 4, storages[s]);
+    gamma_t *copy = gamma_new_storage(width, height, players, 4, storages[s]);
+    assert(g != NULL && copy != NULL);
+    uint64_t seed = 11;
+    for (uint32_t round = 0; round < 8; ++round) {
+      /* Pozycja w punkcie kontrolnym jest odtwarzana w kopii. */
+      for (uint32_t i = 0; i < 40; ++i) {
+        seed = seed * 6364136223846793005u + 1442695040888963407u;
+        uint32_t player = (seed >> 33) % players + 1;
+        uint32_t x = (seed >> 40) % width, y = (seed >> 20) % height;
+        assert(gamma_move(g, player, x, y) == gamma_move(copy, player, x, y));
+      }
+      assert(gamma_checkpoint(g));
+      char *before = gamma_board(g);
+      assert(before != NULL);
+      for (uint32_t i = 0; i < 300; ++i) {
+        seed = seed * 6364136223846793005u + 1442695040888963407u;
+        uint32_t player = (seed >> 33) % players + 1;
+        uint32_t x = (seed >> 40) % width, y = (seed >> 20) % height;
+        if ((seed >> 59) == 0)
+          gamma_golden_move(g, player, x, y);
+        else
+          gamma_move(g, player, x, y);
+      }
+      assert(gamma_rollback(g));
+      char *after = gamma_board(g);
+      assert(after != NULL && strcmp(before, after) == 0);
+      free(before);
+      free(after);
+      for (uint32_t p = 1; p <= players; ++p) {
+        assert(gamma_busy_fields(g, p) == gamma_busy_fields(copy, p));
+        assert(gamma_free_fields(g, p) == gamma_free_fields(copy, p));
+        assert(gamma_golden_possible(g, p) == gamma_golden_possible(copy, p));
+      }
+      for (uint32_t y = 0; y < height; ++y)
+        for (uint32_t x = 0; x < width; ++x)
+          for (uint32_t p = 1; p <= players; ++p)
+            assert(gamma_move_legal(g, p, x, y) ==
+                   gamma_move_legal(copy, p, x, y));
+    }
+    /* Cofnięcie bez ruchów niczego nie zmienia. */
+    assert(gamma_rollback(g));
+    gamma_delete(g);
+    gamma_delete(copy);
+  }
+  assert(!gamma_checkpoint(NULL));
+  assert(!gamma_rollback(NULL));
+  gamma_t *g = gamma_new(5, 5, 2, 1);
+  assert(g != NULL);
+  assert(!gamma_rollback(g));
+  assert(gamma_checkpoint(g));
+  assert(gamma_move(g, 1, 0, 0));
+  assert(gamma_move(g, 2, 1, 0));
+  assert(gamma_golden_move(g, 2, 0, 0));
+  assert(gamma_rollback(g));
+  assert(gamma_busy_fields(g, 1) == 0 && gamma_busy_fields(g, 2) == 0);
+  assert(gamma_move(g, 2, 1, 0));
+  assert(gamma_move(g, 1, 0, 0));
+  assert(gamma_golden_possible(g, 2));
+  assert(gamma_golden_move(g, 2, 0, 0));
+  gamma_delete(g);
+
+  /* Zagnieżdżone punkty kontrolne. */
+  g = gamma_new(5, 5, 2, 2);
+  assert(g != NULL);
+  assert(!gamma_checkpoint_drop(g));
+  assert(gamma_checkpoint(g));
+  assert(gamma_move(g, 1, 0, 0));
+  uint64_t one = gamma_hash(g);
+  assert(gamma_checkpoint(g));
+  assert(gamma_move(g, 2, 1, 0));
+  assert(gamma_checkpoint(g));
+  assert(gamma_golden_move(g, 1, 1, 0));
+  assert(gamma_rollback(g));
+  assert(gamma_field(g, 1, 0) == 2 && gamma_golden_possible(g, 1));
+  assert(gamma_checkpoint_drop(g));
+  assert(gamma_move(g, 1, 4, 4));
+  assert(gamma_rollback(g));
+  assert(gamma_field(g, 1, 0) == 0 && gamma_field(g, 4, 4) == 0);
+  assert(gamma_hash(g) == one && gamma_busy_fields(g, 1) == 1);
+  assert(gamma_checkpoint_drop(g));
+  assert(gamma_rollback(g));
+  assert(gamma_hash(g) == 0 && gamma_busy_fields(g, 1) == 0);
+  assert(gamma_checkpoint_drop(g));
+  assert(!gamma_rollback(g));
+  assert(gamma_move(g, 1, 0, 0));
+  gamma_delete(g);
+  return PASS;
+}
+
+/** Liczy skrót gry od nowa, z planszy i złotych ruchów. */
+static uint64_t hash_of(gamma_t *g) {
+  uint64_t h = 0;
+  for (uint32_t y = 0; y < g->height; ++y)
+    for (uint32_t x = 0; x < g->width; ++x)
+      if (gamma_field(g, x, y) != 0)
+        h ^= zobrist_cell((uint64_t)y * g->width + x, '0' + gamma_field(g, x, y));
+  for (uint32_t p = 1; p <= g->players; ++p)
+    if (!g->players_golden[p - 1])
+      h ^= zobrist_golden(p);
+  return h;
+}
+
+static int zobrist(void) {
+  enum gamma_storage storages[3] = {GAMMA_STORAGE_ARRAY, GAMMA_STORAGE_TILED,
+                                    GAMMA_STORAGE_RLE};
+  uint32_t width = 17, height = 11, players = 3;
+  for (int s = 0; s < 3; ++s) {
+    gamma_t *g = gamma_new_storage(width, height, players, 5, storages[s]);
+    assert(g != NULL);
+    assert(gamma_hash(g) == 0);
+    uint64_t seed = 7;
+    for (uint32_t i = 0; i < 800; ++i) {
+      seed = seed * 6364136223846793005u + 1442695040888963407u;
+      uint32_t player = (seed >> 33) % players + 1;
+      uint32_t x = (seed >> 40) % width, y = (seed >> 20) % height;
+      if ((seed >> 59) == 0)
+        gamma_golden_move(g, player, x, y);
+      else if ((seed >> 59) == 1)
+        gamma_golden_possible(g, player);
+      else if ((seed >> 58) == 4)
+        gamma_set_field(g, (seed >> 10) % (players + 1), x, y);
+      else if ((seed >> 58) == 5)
+        gamma_set_golden(g, player, (seed >> 8) & 1);
+      else
+        gamma_move(g, player, x, y);
+      assert(gamma_hash(g) == hash_of(g));
+    }
+    gamma_delete(g);
+  }
+  assert(gamma_hash(NULL) == 0);
+
+  /* Skrót nie zależy od kolejności ruchów. */
+  gamma_t *a = gamma_new(5, 5, 2, 3);
+  gamma_t *b = gamma_new(5, 5, 2, 3);
+  assert(a != NULL && b != NULL);
+  assert(gamma_move(a, 1, 0, 0) && gamma_move(a, 2, 4, 4));
+  assert(gamma_move(a, 1, 1, 0));
+  assert(gamma_move(b, 1, 1, 0) && gamma_move(b, 2, 4, 4));
+  assert(gamma_move(b, 1, 0, 0));
+  assert(gamma_hash(a) == gamma_hash(b));
+  assert(gamma_move(b, 2, 3, 3));
+  assert(gamma_hash(a) != gamma_hash(b));
+  /* Złoty ruch zmienia skrót także wtedy, gdy plansza jest taka sama. */
+  assert(gamma_golden_move(a, 2, 0, 0));
+  assert(gamma_set_field(a, 1, 0, 0));
+  assert(gamma_hash(a) == (hash_of(b) ^ zobrist_cell(18, '2') ^ zobrist_golden(2)));
+  uint64_t saved = gamma_hash(a);
+  assert(gamma_save(a, "gamma_test_zobrist.bin"));
+  gamma_t *c = gamma_load("gamma_test_zobrist.bin");
+  assert(c != NULL && gamma_hash(c) == saved);
+  remove("gamma_test_zobrist.bin");
+  gamma_delete(a);
+  gamma_delete(b);
+  gamma_delete(c);
+  return PASS;
+}
+
+/** Porównuje stan gry na bitboardach ze stanem silnika, także liczby
+ * obszarów graczy, jeśli @p areas (silnik buduje wtedy identyfikatory
+ * obszarów). */
+static void bitboard_compare(gamma_t *g, const bitboard_t *b, bool areas) {
+  assert(gamma_hash(g) == b->hash);
+  for (uint32_t p = 0; p <= g->players + 1; ++p) {
+    uint64_t legal = 0;
+    gamma_legal_moves(g, p, &legal);
+    assert(bitboard_legal_moves(b, p) == legal);
+    assert(bitboard_busy_fields(b, p) == gamma_busy_fields(g, p));
+    assert(bitboard_free_fields(b, p) == gamma_free_fields(g, p));
+    assert(bitboard_golden_possible(b, p) == gamma_golden_possible(g, p));
+    if (areas && p >= 1 && p <= g->players)
+      assert(b->areas[p - 1] == gamma_player_areas(g, p, NULL, 0));
+    /* Lista złotych ruchów zgadza się z ich wykonaniem. */
+    uint64_t golden = bitboard_golden_moves(b, p);
+    assert((golden != 0) == bitboard_golden_possible(b, p));
+    for (uint32_t cell = 0; cell < g->width * g->height; ++cell) {
+      bitboard_t c = *b;
+      assert(((golden >> cell) & 1) ==
+             bitboard_golden_move(&c, p, cell % g->width, cell / g->width));
+    }
+  }
+  for (uint32_t y = 0; y <= g->height; ++y)
+    for (uint32_t x = 0; x <= g->width; ++x)
+      assert(bitboard_field(b, x, y) == gamma_field(g, x, y));
+}
+
+static int bitboard(void) {
+  static const uint32_t sizes[][2] = {{1, 1}, {3, 3}, {5, 7}, {8, 8},
+                                      {16, 4}, {64, 1}, {1, 64}};
+  bitboard_t b;
+  assert(!bitboard_init(NULL, 2, 2, 2, 1));
+  assert(!bitboard_init(&b, 0, 2, 2, 1) && !bitboard_init(&b, 2, 0, 2, 1));
+  assert(!bitboard_init(&b, 2, 2, 0, 1) && !bitboard_init(&b, 2, 2, 2, 0));
+  assert(!bitboard_init(&b, 13, 5, 2, 1));
+  assert(!bitboard_init(&b, 2, 2, BITBOARD_MAX_PLAYERS + 1, 1));
+  assert(!bitboard_move(NULL, 1, 0, 0) && !bitboard_golden_move(NULL, 1, 0, 0));
+  assert(!bitboard_golden_possible(NULL, 1) && bitboard_field(NULL, 0, 0) == 0);
+
+  /* Losowe gry, także z ruchami niepoprawnych graczy i poza planszą. */
+  uint64_t seed = 11;
+  for (size_t s = 0; s < SIZE(sizes); ++s)
+    for (uint32_t players = 1; players <= 4; ++players)
+      for (uint32_t areas = 1; areas <= 3; ++areas)
+        for (uint32_t round = 0; round < 4; ++round) {
+          uint32_t width = sizes[s][0], height = sizes[s][1];
+          gamma_t *g = gamma_new(width, height, players, areas);
+          assert(g != NULL && bitboard_init(&b, width, height, players, areas));
+          bitboard_compare(g, &b, round % 2 == 1);
+          for (uint32_t i = 0; i < 3 * width * height; ++i) {
+            seed = seed * 6364136223846793005u + 1442695040888963407u;
+            uint32_t player = (seed >> 33) % (players + 2);
+            uint32_t x = (seed >> 40) % (width + 1), y = (seed >> 20) % (height + 1);
+            /* Pod koniec gry złote ruchy są częstsze. */
+            if ((seed >> 60) < (i < 2 * width * height ? 2 : 8))
+              assert(bitboard_golden_move(&b, player, x, y) ==
+                     gamma_golden_move(g, player, x, y));
+            else
+              assert(bitboard_move(&b, player, x, y) == gamma_move(g, player, x, y));
+            bitboard_compare(g, &b, round % 2 == 1);
+          }
+          gamma_delete(g);
+        }
+  return PASS;
+}
+
+/** Ruch zapisany w teście dziennika. */
+typedef struct {
+  uint32_t player, x, y;
+  bool golden;
+} journal_entry_t;
+
+/** Odtwarza na nowej planszy pierwsze @p moves ruchów z @p entries. */
+static gamma_t *journal_live(const journal_entry_t *entries, uint64_t moves) {
+  gamma_t *g = gamma_new(20, 20, 6, 4);
+  assert(g != NULL);
+  for (uint64_t i = 0; i < moves; ++i) {
+    const journal_entry_t *e = &entries[i];
+    if (e->golden)
+      assert(gamma_golden_move(g, e->player, e->x, e->y));
+    else
+      assert(gamma_move(g, e->player, e->x, e->y));
+  }
+  return g;
+}
+
+/** Sprawdza, czy gra odtworzona z dziennika @p path po @p moves ruchach
+ * ma taką samą planszę i skrót jak gra rozegrana na żywo. */
+static void journal_check(const char *path, const journal_entry_t *entries,
+                          uint64_t moves) {
+  uint64_t replayed = UINT64_MAX;
+  gamma_t *g = journal_replay(path, moves, &replayed);
+  assert(g != NULL && replayed == moves);
+  gamma_t *h = journal_live(entries, moves);
+  char *p = gamma_board(g);
+  char *q = gamma_board(h);
+  assert(p != NULL && q != NULL);
+  assert(strcmp(p, q) == 0);
+  assert(gamma_hash(g) == gamma_hash(h));
+  free(p);
+  free(q);
+  gamma_delete(g);
+  gamma_delete(h);
+}
+
+/** Skraca plik @p path do @p length bajtów. */
+static bool journal_cut(const char *path, long length) {
+  char *a = malloc(length);
+  FILE *f = fopen(path, "rb");
+  bool ok = a != NULL && f != NULL && fread(a, 1, length, f) == (size_t)length;
+  if (f != NULL && fclose(f) != 0)
+    ok = false;
+  f = ok ? fopen(path, "wb") : NULL;
+  ok = f != NULL && fwrite(a, 1, length, f) == (size_t)length;
+  if (f != NULL && fclose(f) != 0)
+    ok = false;
+  free(a);
+  return ok;
+}
+
+/* Testuje dziennik gry i odtwarzanie z niego gry. */
+static int journal(void) {
+  static const char path[] = "gamma_test_journal.bin";
+  static const uint64_t interval = 50;
+  journal_entry_t entries[400];
+  uint64_t moves = 0, golden = 0;
+  gamma_t *g = gamma_new(20, 20, 6, 4);
+  assert(g != NULL);
+  journal_t *j = journal_create(path, g, interval);
+  assert(j != NULL);
+  /* Losowa gra ze złotymi ruchami, kończy się między punktami kontrolnymi. */
+  uint64_t seed = 5;
+  while (moves < 3 * interval + interval / 2) {
+    seed = seed * 6364136223846793005u + 1442695040888963407u;
+    journal_entry_t e = {(seed >> 33) % 6 + 1, (seed >> 40) % 20,
+                         (seed >> 20) % 20, (seed >> 59) == 0};
+    if (e.golden ? gamma_golden_move(g, e.player, e.x, e.y)
+                 : gamma_move(g, e.player, e.x, e.y)) {
+      if (e.golden) {
+        journal_golden_move(j, g, e.player, e.x, e.y);
+        golden++;
+      }
+      else
+        journal_move(j, g, e.player, e.x, e.y);
+      entries[moves++] = e;
+    }
+  }
+  journal_close(j);
+  assert(golden > 0);
+
+  /* Początek gry, punkt kontrolny, miejsce między punktami i koniec. */
+  journal_check(path, entries, 0);
+  journal_check(path, entries, interval);
+  journal_check(path, entries, 2 * interval + 7);
+  journal_check(path, entries, moves);
+  uint64_t replayed = 0;
+  gamma_t *h = journal_replay(path, UINT64_MAX, &replayed);
+  assert(h != NULL && replayed == moves && gamma_hash(h) == gamma_hash(g));
+  gamma_delete(h);
+
+  /* Dziennik kończy się przesunięciem rekordu końcowego i "GJNE". */
+  FILE *f = fopen(path, "rb");
+  unsigned char trailer[12];
+  assert(f != NULL && fseek(f, -12, SEEK_END) == 0);
+  assert(fread(trailer, 1, 12, f) == 12 && fclose(f) == 0);
+  assert(memcmp(trailer + 8, "GJNE", 4) == 0);
+  long end = 0;
+  for (int i = 0; i < 8; ++i)
+    end |= (long)trailer[i] << (8 * i);
+  /* Niezamknięty dziennik jest odtwarzany do ostatniego całego rekordu, */
+  assert(journal_cut(path, end));
+  journal_check(path, entries, moves);
+  /* a ucięty w środku rekordu jest odrzucany. */
+  assert(journal_cut(path, end - 1));
+  assert(journal_replay(path, UINT64_MAX, NULL) == NULL);
+  journal_check(path, entries, interval);
+  assert(journal_cut(path, 3));
+  assert(journal_replay(path, 0, NULL) == NULL);
+  assert(remove(path) == 0);
+  assert(journal_replay(path, 0, NULL) == NULL);
+
+  gamma_delete(g);
+  return PASS;
+}
+
 /** URUCHAMIANIE TESTÓW **/
 
 typedef struct {
@@ -782,6 +2065,26 @@ static const test_list_t test_list[] = {
   TEST(memory_alloc),
   TEST(big_board),
   TEST(middle_board),
+  TEST(snapshot),
+  TEST(stats),
+  TEST(pool),
+  TEST(huge_pages),
+  TEST(query_cache),
+  TEST(parallel_areas),
+  TEST(rle_storage),
+  TEST(tiled_storage),
+  TEST(cell_widths),
+  TEST(tile_lists),
+  TEST(block_summaries),
+  TEST(all_fields),
+  TEST(move_batch),
+  TEST(legal_moves),
+  TEST(count_rect),
+  TEST(area_ids),
+  TEST(rollback),
+  TEST(zobrist),
+  TEST(bitboard),
+  TEST(journal),
 };
 
 int main(int argc, char *argv[]) {
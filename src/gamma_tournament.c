@@ -0,0 +1,470 @@
+/** @file
+ * @brief round-robin tournament of gamma bots.
+ * usage: gamma_tournament [-w width] [-h height] [-a areas] [-n games]
+ *                         [-b bot,bot,...] [-T threads] [-s seed]
+ *
+ * every ordered pair of different bots (the first one moves first) plays
+ * -n two player games from empty board. games are taken one by one from
+ * a shared counter by a pool of threads (-T, 0 = one per processor);
+ * every thread plays in its own game, going back to the empty board with
+ * gamma_rollback after each game.
+ * a bot is a function making one move (normal or golden) of a player in
+ * a game through gamma.h. it is called only when the player can move;
+ * players move in turns and the game ends when both players in a row can
+ * not move (or bots do not). the winner is the player with more tiles.
+ * random choices of bots depend only on -s and number of the game, so
+ * results do not depend on amount of threads.
+ * prints "name value" lines: totals and speed, then line "bot" of every
+ * bot and line "pair" of every two bots (wins of the first one against
+ * the second one), both followed by names and "name value" pairs.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "gamma.h"
+#include "rng.h"
+
+/** most bots in a tournament */
+#define TOURNAMENT_MAX_BOTS 8
+
+/** most threads started */
+#define TOURNAMENT_MAX_THREADS 256
+
+/** legal moves compared by greedy bot */
+#define TOURNAMENT_TRIES 8
+
+/**
+ * bot: makes one move of @p player in @p g , using functions of gamma.h.
+ * @p g is the game of the thread, which keeps its own checkpoint at the
+ * empty board: a bot may try moves and take them back under checkpoints
+ * of its own (gamma_checkpoint, gamma_rollback, gamma_checkpoint_drop),
+ * but has to remove them before it returns. if gamma_rollback fails, all
+ * checkpoints are gone, so the thread stops after the game and the
+ * tournament fails.
+ * @returns false if it did not move
+ */
+typedef bool (*tournament_bot)(gamma_t *g,uint32_t player);
+
+/**
+ * tournament configuration read from command line:
+ * bots -indexes of playing bots in bot_list
+ */
+struct tournament_options{
+    uint32_t width;
+    uint32_t height;
+    uint32_t areas;
+    uint64_t games;
+    uint32_t bots[TOURNAMENT_MAX_BOTS];
+    uint32_t amount;
+    uint32_t threads;
+    uint64_t seed;
+};
+
+/**
+ * results of one bot (as counted by one thread):
+ * tiles -tiles at the end of its games
+ * decisions, ns -calls of the bot and time spent in them
+ * against -wins, draws and losses against every other bot
+ */
+struct bot_stats{
+    uint64_t games;
+    uint64_t wins;
+    uint64_t draws;
+    uint64_t losses;
+    uint64_t tiles;
+    uint64_t decisions;
+    uint64_t ns;
+    uint64_t against[TOURNAMENT_MAX_BOTS][3];
+};
+
+/**
+ * state shared by threads:
+ * next -number of the next game to play
+ */
+struct tournament_shared{
+    const struct tournament_options *o;
+    _Atomic uint64_t next;
+};
+
+/**
+ * work and results of one thread:
+ * moves -moves made (normal and golden)
+ * ok -game of the thread was created
+ */
+struct tournament_worker{
+    struct tournament_shared *s;
+    struct bot_stats stats[TOURNAMENT_MAX_BOTS];
+    uint64_t moves;
+    bool ok;
+};
+
+/**
+ * state of generator used by bots, set by thread before every game.
+ */
+static _Thread_local uint64_t bot_seed;
+
+/**
+ * returns current time in nanoseconds.
+ */
+static uint64_t now_ns(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC,&t);
+    return (uint64_t)t.tv_sec*1000000000u+t.tv_nsec;
+}
+
+/**
+ * tries moves (golden ones if @p golden ) of @p player on tiles of @p g
+ * from tile @p start on, row by row and back from the first tile.
+ * @returns true if one of them was made
+ */
+static bool scan_move(gamma_t *g,uint32_t player,uint64_t start,bool golden)
+{
+    bool result=false;
+    uint64_t cells=(uint64_t)g->width*g->height;
+    for(uint64_t i=0;i<cells && !result;i++)
+    {
+        uint64_t cell=(start+i)%cells;
+        uint32_t x=cell%g->width,y=cell/g->width;
+        result=golden ? gamma_golden_move(g,player,x,y) : gamma_move(g,player,x,y);
+    }
+    return result;
+}
+
+/**
+ * bot taking the first legal tile in row order, golden move only when
+ * there is no other one.
+ */
+static bool bot_first(gamma_t *g,uint32_t player)
+{
+    bool result=gamma_free_fields(g,player)>0 && scan_move(g,player,0,false);
+    if(!result)result=scan_move(g,player,0,true);
+    return result;
+}
+
+/**
+ * bot taking the first legal tile after a random one, golden move only
+ * when there is no other one.
+ */
+static bool bot_random(gamma_t *g,uint32_t player)
+{
+    uint64_t cells=(uint64_t)g->width*g->height;
+    bool result=gamma_free_fields(g,player)>0 && scan_move(g,player,rng_below(&bot_seed,cells),false);
+    if(!result)result=scan_move(g,player,rng_below(&bot_seed,cells),true);
+    return result;
+}
+
+/**
+ * bot making its golden move as soon as it can (on the first possible
+ * tile after a random one), random otherwise.
+ */
+static bool bot_golden(gamma_t *g,uint32_t player)
+{
+    uint64_t cells=(uint64_t)g->width*g->height;
+    bool result=gamma_golden_possible(g,player) && scan_move(g,player,rng_below(&bot_seed,cells),true);
+    if(!result)result=bot_random(g,player);
+    return result;
+}
+
+/**
+ * returns free tiles @p player of @p g can take minus those the other
+ * player can take.
+ */
+static int64_t mobility(gamma_t *g,uint32_t player)
+{
+    return (int64_t)gamma_free_fields(g,player)-(int64_t)gamma_free_fields(g,3-player);
+}
+
+/**
+ * bot looking one move ahead: of a few legal tiles after a random one it
+ * takes the one leaving it most free tiles compared to the other player.
+ * moves are tried and taken back under a checkpoint of its own, nested in
+ * the one of the thread (see tournament_bot).
+ */
+static bool bot_greedy(gamma_t *g,uint32_t player)
+{
+    bool result=false;
+    uint64_t cells=(uint64_t)g->width*g->height;
+    uint64_t start=rng_below(&bot_seed,cells),best_cell=0;
+    int64_t best=0;
+    uint32_t tried=0;
+    bool undone=true;
+    if(gamma_free_fields(g,player)>0 && gamma_checkpoint(g))
+    {
+        for(uint64_t i=0;i<cells && tried<TOURNAMENT_TRIES && undone;i++)
+        {
+            uint64_t cell=(start+i)%cells;
+            if(gamma_move(g,player,cell%g->width,cell/g->width))
+            {
+                int64_t value=mobility(g,player);
+                if(tried==0 || value>best)
+                {
+                    best=value;
+                    best_cell=cell;
+                }
+                tried++;
+                undone=gamma_rollback(g);
+            }
+        }
+        //failed rollback removed all checkpoints
+        if(undone)gamma_checkpoint_drop(g);
+    }
+    //move which could not be taken back is the move of the bot
+    if(!undone)result=true;
+    else if(tried>0)result=gamma_move(g,player,best_cell%g->width,best_cell/g->width);
+    else result=bot_random(g,player);
+    return result;
+}
+
+/**
+ * bots which can play in tournaments.
+ */
+static const struct{
+    const char *name;
+    tournament_bot move;
+} bot_list[]={
+    {"first",bot_first},
+    {"random",bot_random},
+    {"golden",bot_golden},
+    {"greedy",bot_greedy},
+};
+
+/**
+ * plays game between bots @p a (player 1) and @p b (player 2) of the
+ * tournament in empty game @p g and counts its result in @p w .
+ */
+static void tournament_game(struct tournament_worker *w,gamma_t *g,uint32_t a,uint32_t b)
+{
+    const uint32_t *bots=w->s->o->bots;
+    uint32_t seats[2]={a,b};
+    uint32_t passes=0;
+    for(uint32_t player=1;passes<2;player=3-player)
+    {
+        bool moved=false;
+        if(gamma_free_fields(g,player)>0 || gamma_golden_possible(g,player))
+        {
+            struct bot_stats *stats=&w->stats[seats[player-1]];
+            uint64_t start=now_ns();
+            moved=bot_list[bots[seats[player-1]]].move(g,player);
+            stats->ns+=now_ns()-start;
+            stats->decisions++;
+        }
+        if(moved)
+        {
+            w->moves++;
+            passes=0;
+        }
+        else passes++;
+    }
+    uint64_t tiles[2]={gamma_busy_fields(g,1),gamma_busy_fields(g,2)};
+    for(uint32_t seat=0;seat<2;seat++)
+    {
+        struct bot_stats *stats=&w->stats[seats[seat]];
+        //0 -win, 1 -draw, 2 -loss
+        uint32_t result=tiles[seat]>tiles[1-seat] ? 0 : tiles[seat]==tiles[1-seat] ? 1 : 2;
+        stats->games++;
+        stats->tiles+=tiles[seat];
+        stats->wins+=result==0;
+        stats->draws+=result==1;
+        stats->losses+=result==2;
+        stats->against[seats[1-seat]][result]++;
+    }
+}
+
+/**
+ * plays games of the tournament taken from the shared counter until
+ * there are none left.
+ */
+static void* tournament_thread(void *arg)
+{
+    struct tournament_worker *w=arg;
+    const struct tournament_options *o=w->s->o;
+    uint32_t pairs=o->amount*(o->amount-1);
+    gamma_t *g=gamma_new(o->width,o->height,2,o->areas);
+    if(g!=NULL && gamma_checkpoint(g))
+    {
+        w->ok=true;
+        uint64_t game=atomic_fetch_add(&w->s->next,1);
+        while(game<o->games*pairs && w->ok)
+        {
+            //ordered pair of different bots, b is not a
+            uint32_t pair=game/o->games;
+            uint32_t a=pair/(o->amount-1),b=pair%(o->amount-1);
+            if(b>=a)b++;
+            bot_seed=(o->seed^(0x9e3779b97f4a7c15ull*(game+1)))|1;
+            tournament_game(w,g,a,b);
+            w->ok=gamma_rollback(g);
+            game=atomic_fetch_add(&w->s->next,1);
+        }
+    }
+    gamma_delete(g);
+    return NULL;
+}
+
+/**
+ * reads bots of comma separated list @p list into @p o .
+ * @returns false if a name is not known or there are not 2 to
+ * TOURNAMENT_MAX_BOTS bots
+ */
+static bool bots_read(const char *list,struct tournament_options *o)
+{
+    bool ok=true;
+    o->amount=0;
+    while(ok && *list!='\0')
+    {
+        size_t length=strcspn(list,",");
+        ok=false;
+        for(uint32_t i=0;i<sizeof bot_list/sizeof bot_list[0] && !ok;i++)
+        {
+            if(strlen(bot_list[i].name)==length && strncmp(bot_list[i].name,list,length)==0
+               && o->amount<TOURNAMENT_MAX_BOTS)
+            {
+                o->bots[o->amount++]=i;
+                ok=true;
+            }
+        }
+        list+=length;
+        if(*list==',')list++;
+    }
+    return ok && o->amount>=2;
+}
+
+/**
+ * reads command line options.
+ * @returns false if options are not valid
+ */
+static bool tournament_options_read(int argc,char *argv[],struct tournament_options *o)
+{
+    bool ok=true;
+    o->width=8;
+    o->height=8;
+    o->areas=4;
+    o->games=1000;
+    o->amount=sizeof bot_list/sizeof bot_list[0];
+    for(uint32_t i=0;i<o->amount;i++)o->bots[i]=i;
+    o->threads=0;
+    o->seed=88172645463325252ull;
+    for(int i=1;i+1<argc && ok;i+=2)
+    {
+        if(strcmp(argv[i],"-w")==0)o->width=strtoul(argv[i+1],NULL,10);
+        else if(strcmp(argv[i],"-h")==0)o->height=strtoul(argv[i+1],NULL,10);
+        else if(strcmp(argv[i],"-a")==0)o->areas=strtoul(argv[i+1],NULL,10);
+        else if(strcmp(argv[i],"-n")==0)o->games=strtoull(argv[i+1],NULL,10);
+        else if(strcmp(argv[i],"-b")==0)ok=bots_read(argv[i+1],o);
+        else if(strcmp(argv[i],"-T")==0)o->threads=strtoul(argv[i+1],NULL,10);
+        else if(strcmp(argv[i],"-s")==0)o->seed=strtoull(argv[i+1],NULL,10)|1;
+        else ok=false;
+    }
+    if(o->threads==0)
+    {
+        long cpus=sysconf(_SC_NPROCESSORS_ONLN);
+        o->threads=cpus>0 ? cpus : 1;
+    }
+    if(o->threads>TOURNAMENT_MAX_THREADS)o->threads=TOURNAMENT_MAX_THREADS;
+    return ok && argc%2==1 && (uint64_t)o->width*o->height<UINT32_MAX;
+}
+
+/**
+ * prints results of bots of @p o summed over threads @p workers .
+ */
+static void tournament_print(const struct tournament_options *o,
+                             const struct tournament_worker *workers)
+{
+    for(uint32_t i=0;i<o->amount;i++)
+    {
+        struct bot_stats sum={0};
+        for(uint32_t t=0;t<o->threads;t++)
+        {
+            const struct bot_stats *s=&workers[t].stats[i];
+            sum.games+=s->games;
+            sum.wins+=s->wins;
+            sum.draws+=s->draws;
+            sum.losses+=s->losses;
+            sum.tiles+=s->tiles;
+            sum.decisions+=s->decisions;
+            sum.ns+=s->ns;
+            for(uint32_t j=0;j<o->amount;j++)
+            {
+                for(uint32_t k=0;k<3;k++)sum.against[j][k]+=s->against[j][k];
+            }
+        }
+        printf("bot %s games %"PRIu64" wins %"PRIu64" draws %"PRIu64" losses %"PRIu64
+               " win_rate %.4f tiles_per_game %.2f decisions %"PRIu64" us_per_decision %.3f\n",
+               bot_list[o->bots[i]].name,sum.games,sum.wins,sum.draws,sum.losses,
+               sum.games>0 ? (double)sum.wins/sum.games : 0.0,
+               sum.games>0 ? (double)sum.tiles/sum.games : 0.0,sum.decisions,
+               sum.decisions>0 ? sum.ns/1e3/sum.decisions : 0.0);
+        for(uint32_t j=0;j<o->amount;j++)
+        {
+            uint64_t games=sum.against[j][0]+sum.against[j][1]+sum.against[j][2];
+            if(j!=i)
+            {
+                printf("pair %s %s wins %"PRIu64" draws %"PRIu64" losses %"PRIu64" win_rate %.4f\n",
+                       bot_list[o->bots[i]].name,bot_list[o->bots[j]].name,sum.against[j][0],
+                       sum.against[j][1],sum.against[j][2],
+                       games>0 ? (double)sum.against[j][0]/games : 0.0);
+            }
+        }
+    }
+}
+
+int main(int argc,char *argv[])
+{
+    struct tournament_options o;
+    if(!tournament_options_read(argc,argv,&o))
+    {
+        fprintf(stderr,"usage: %s [-w width] [-h height] [-a areas] [-n games]"
+                " [-b bot,bot,...] [-T threads] [-s seed]\nbots:",argv[0]);
+        for(uint32_t i=0;i<sizeof bot_list/sizeof bot_list[0];i++)
+        {
+            fprintf(stderr," %s",bot_list[i].name);
+        }
+        fprintf(stderr,"\n");
+        return 1;
+    }
+    //games run in parallel already, areas are recounted by one thread
+    gamma_threads(1);
+    struct tournament_shared shared={.o=&o};
+    atomic_init(&shared.next,0);
+    struct tournament_worker *workers=calloc(o.threads,sizeof(struct tournament_worker));
+    pthread_t threads[TOURNAMENT_MAX_THREADS];
+    bool started[TOURNAMENT_MAX_THREADS];
+    bool ok=workers!=NULL;
+    double start=now_ns()/1e9;
+    for(uint32_t t=0;t<o.threads && workers!=NULL;t++)
+    {
+        workers[t].s=&shared;
+        started[t]=pthread_create(&threads[t],NULL,tournament_thread,&workers[t])==0;
+        ok=ok && started[t];
+    }
+    for(uint32_t t=0;t<o.threads && workers!=NULL;t++)
+    {
+        if(started[t])pthread_join(threads[t],NULL);
+        ok=ok && workers[t].ok;
+    }
+    double seconds=now_ns()/1e9-start;
+    if(!ok)fprintf(stderr,"cannot play %ux%u game\n",o.width,o.height);
+    else
+    {
+        uint64_t games=o.games*o.amount*(o.amount-1),moves=0;
+        for(uint32_t t=0;t<o.threads;t++)moves+=workers[t].moves;
+        printf("threads %u\n",o.threads);
+        printf("games %"PRIu64"\n",games);
+        printf("moves %"PRIu64"\n",moves);
+        printf("seconds %.3f\n",seconds);
+        printf("games_per_s %.1f\n",games/seconds);
+        printf("moves_per_s %.1f\n",moves/seconds);
+        tournament_print(&o,workers);
+    }
+    free(workers);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,267 @@
+/** @file
+ * @brief deterministic generator of batch mode scripts and load test driver.
+ * usage: gamma_workload [-m mode] [-w width] [-h height] [-k players]
+ *                       [-a areas] [-n commands] [-s seed] [-x gamma]
+ *
+ * modes:
+ * random  -players grow their areas, sometimes jump to random tile,
+ *          mixed with some queries
+ * limit   -few allowed areas and mostly scattered moves,
+ *          so players hover at their area limit
+ * golden  -heavy use of golden moves
+ * query   -mostly q, f and b commands
+ * dump    -frequent p commands
+ *
+ * without -x script is written to stdout, with -x path to gamma executable
+ * the script is fed to it (output discarded) and one CSV line is printed:
+ * mode,width,height,players,areas,commands,seed,seconds,commands_per_second
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "rng.h"
+
+/**
+ * workload parameters.
+ */
+struct workload{
+    const char *mode;
+    uint32_t width;
+    uint32_t height;
+    uint32_t players;
+    uint32_t areas;
+    uint64_t commands;
+    uint64_t seed;
+    const char *gamma;
+};
+
+/**
+ * probabilities (in percents) of commands in given mode,
+ * remaining percents are normal moves.
+ * near -percent of normal moves placed next to previous move of the player
+ */
+struct mix{
+    const char *mode;
+    int golden;
+    int golden_possible;
+    int free_fields;
+    int busy_fields;
+    int board;
+    int near;
+};
+
+/** command mixes of all modes */
+static const struct mix mixes[]={
+    {"random",2,4,4,4,0,70},
+    {"limit",1,10,10,2,0,10},
+    {"golden",40,10,2,2,0,50},
+    {"query",1,30,30,29,0,50},
+    {"dump",1,2,2,2,30,70},
+};
+
+/**
+ * xorshift64* generator state.
+ */
+static uint64_t rng_state;
+
+/**
+ * growing text buffer for generated script.
+ */
+struct text{
+    char *a;
+    size_t length;
+    size_t size;
+};
+
+/**
+ * appends formatted line to @p t.
+ */
+static void text_printf(struct text *t,const char *format,...)
+{
+    va_list args;
+    if(t->size-t->length<128)
+    {
+        t->size=t->size*2+4096;
+        t->a=realloc(t->a,t->size);
+        if(t->a==NULL)exit(1);//emergency
+    }
+    va_start(args,format);
+    int n=vsnprintf(t->a+t->length,t->size-t->length,format,args);
+    va_end(args);
+    if(n>0)t->length+=n;
+}
+
+/**
+ * picks tile for normal move of @p player, next to his previous move
+ * (stored in @p last_x, @p last_y) with given probability.
+ */
+static void pick_tile(const struct workload *w,const struct mix *m,
+                      uint32_t *last_x,uint32_t *last_y,uint32_t player,
+                      uint32_t *x,uint32_t *y)
+{
+    uint32_t i=player-1;
+    if((int)rng_below(&rng_state,100)<m->near && last_x[i]!=UINT32_MAX)
+    {
+        *x=last_x[i];
+        *y=last_y[i];
+        switch(rng_below(&rng_state,4))
+        {
+            case 0:if(*x+1<w->width)(*x)++;break;
+            case 1:if(*x>0)(*x)--;break;
+            case 2:if(*y+1<w->height)(*y)++;break;
+            default:if(*y>0)(*y)--;break;
+        }
+    }
+    else
+    {
+        *x=rng_below(&rng_state,w->width);
+        *y=rng_below(&rng_state,w->height);
+    }
+    last_x[i]=*x;
+    last_y[i]=*y;
+}
+
+/**
+ * generates whole script of workload @p w into @p t.
+ * @returns false for unknown mode
+ */
+static bool generate(const struct workload *w,struct text *t)
+{
+    const struct mix *m=NULL;
+    for(size_t i=0;i<sizeof mixes/sizeof mixes[0];i++)
+    {
+        if(strcmp(mixes[i].mode,w->mode)==0)m=&mixes[i];
+    }
+    if(m==NULL)return false;
+    //only players seen in the script need their previous moves
+    uint32_t tracked=w->players<(1u<<20) ? w->players : (1u<<20);
+    uint32_t *last_x=malloc(tracked*sizeof(uint32_t));
+    uint32_t *last_y=malloc(tracked*sizeof(uint32_t));
+    if(last_x==NULL || last_y==NULL)exit(1);//emergency
+    for(uint32_t i=0;i<tracked;i++)last_x[i]=UINT32_MAX;
+
+    rng_state=w->seed;
+    text_printf(t,"# gamma_workload %s seed %"PRIu64"\n",w->mode,w->seed/2);
+    text_printf(t,"B %u %u %u %u\n",w->width,w->height,w->players,w->areas);
+    uint32_t player=0;
+    for(uint64_t c=0;c<w->commands;c++)
+    {
+        //players mostly take turns, as in real games
+        if(rng_below(&rng_state,8)==0)player=rng_below(&rng_state,tracked);
+        else player=(player+1)%tracked;
+        uint32_t p=player+1;
+        int r=rng_below(&rng_state,100);
+        uint32_t x,y;
+        if((r-=m->golden)<0)
+        {
+            pick_tile(w,m,last_x,last_y,rng_below(&rng_state,tracked)+1,&x,&y);
+            text_printf(t,"g %u %u %u\n",p,x,y);
+        }
+        else if((r-=m->golden_possible)<0)text_printf(t,"q %u\n",p);
+        else if((r-=m->free_fields)<0)text_printf(t,"f %u\n",p);
+        else if((r-=m->busy_fields)<0)text_printf(t,"b %u\n",p);
+        else if((r-=m->board)<0)text_printf(t,"p\n");
+        else
+        {
+            pick_tile(w,m,last_x,last_y,p,&x,&y);
+            text_printf(t,"m %u %u %u\n",p,x,y);
+        }
+    }
+    free(last_x);
+    free(last_y);
+    return true;
+}
+
+/**
+ * feeds script @p t to gamma executable and measures time.
+ * @returns time in seconds, negative if gamma could not be run
+ */
+static double drive(const struct workload *w,const struct text *t)
+{
+    char command[4096];
+    snprintf(command,sizeof command,"'%s' > /dev/null",w->gamma);
+    struct timespec start,end;
+    clock_gettime(CLOCK_MONOTONIC,&start);
+    FILE *f=popen(command,"w");
+    if(f==NULL)return -1;
+    fwrite(t->a,1,t->length,f);
+    int status=pclose(f);
+    clock_gettime(CLOCK_MONOTONIC,&end);
+    if(status!=0)return -1;
+    return (end.tv_sec-start.tv_sec)+(end.tv_nsec-start.tv_nsec)/1e9;
+}
+
+/**
+ * reads command line options.
+ * @returns false if options are not valid
+ */
+static bool workload_read(int argc,char *argv[],struct workload *w)
+{
+    bool ok=true;
+    w->mode="random";
+    w->width=100;
+    w->height=100;
+    w->players=4;
+    w->areas=0;
+    w->commands=100000;
+    w->seed=1;
+    w->gamma=NULL;
+    for(int i=1;i+1<argc && ok;i+=2)
+    {
+        if(strcmp(argv[i],"-m")==0)w->mode=argv[i+1];
+        else if(strcmp(argv[i],"-w")==0)w->width=strtoul(argv[i+1],NULL,10);
+        else if(strcmp(argv[i],"-h")==0)w->height=strtoul(argv[i+1],NULL,10);
+        else if(strcmp(argv[i],"-k")==0)w->players=strtoul(argv[i+1],NULL,10);
+        else if(strcmp(argv[i],"-a")==0)w->areas=strtoul(argv[i+1],NULL,10);
+        else if(strcmp(argv[i],"-n")==0)w->commands=strtoull(argv[i+1],NULL,10);
+        else if(strcmp(argv[i],"-s")==0)w->seed=strtoull(argv[i+1],NULL,10);
+        else if(strcmp(argv[i],"-x")==0)w->gamma=argv[i+1];
+        else ok=false;
+    }
+    //seed 0 would stop xorshift
+    w->seed=w->seed*2+1;
+    if(w->areas==0)w->areas=strcmp(w->mode,"limit")==0 ? 2 : 16;
+    return ok && argc%2==1 && w->width>0 && w->height>0 && w->players>0;
+}
+
+int main(int argc,char *argv[])
+{
+    struct workload w;
+    if(!workload_read(argc,argv,&w))
+    {
+        fprintf(stderr,"usage: %s [-m random|limit|golden|query|dump] [-w width] [-h height]"
+                " [-k players] [-a areas] [-n commands] [-s seed] [-x gamma]\n",argv[0]);
+        return 1;
+    }
+    struct text t={NULL,0,0};
+    if(!generate(&w,&t))
+    {
+        fprintf(stderr,"unknown mode %s\n",w.mode);
+        return 1;
+    }
+    int result=0;
+    if(w.gamma==NULL)fwrite(t.a,1,t.length,stdout);
+    else
+    {
+        double seconds=drive(&w,&t);
+        if(seconds<0)
+        {
+            fprintf(stderr,"cannot run %s\n",w.gamma);
+            result=1;
+        }
+        else
+        {
+            printf("%s,%u,%u,%u,%u,%"PRIu64",%"PRIu64",%.6f,%.0f\n",w.mode,w.width,w.height,
+                   w.players,w.areas,w.commands,w.seed/2,seconds,w.commands/seconds);
+        }
+    }
+    free(t.a);
+    return result;
+}
@@ -12,6 +12,8 @@
 
 #include "gamma.h"
 #include "dynamic_array.h"
+#include "journal.h"
+#include "interactivemode.h"
 
 #define CTRL_D 4
 #define SPACE 32
@@ -55,10 +57,13 @@ void interactive_gamma_board(gamma_t* g,uint32_t player, uint32_t cursor_x,uint3
  */
 void results(gamma_t* g)
 {
+    uint64_t *busy=malloc((size_t)g->players*sizeof(uint64_t));
+    bool all=gamma_all_busy_fields(g,busy);
     for(uint32_t i=0;i<g->players;i++)
     {
-        printf("PLAYER %d %ld\n",i+1,g->players_tiles[i]);
+        printf("PLAYER %d %ld\n",i+1,all ? busy[i] : gamma_busy_fields(g,i+1));
     }
+    free(busy);
 }
 
 /** read cursor movement from input.
@@ -136,7 +141,7 @@ bool next_player(gamma_t *g,uint32_t* current_player)
  * read input as command
  * calls proper functions for inputs
  */ 
-void interactive_command(gamma_t *g,int *z,bool *ok,uint32_t* x,uint32_t* y,uint32_t *current_player)
+void interactive_command(gamma_t *g,int *z,bool *ok,uint32_t* x,uint32_t* y,uint32_t *current_player,journal_t *j)
 {
     switch(*z)
     {
@@ -151,6 +156,7 @@ void interactive_command(gamma_t *g,int *z,bool *ok,uint32_t* x,uint32_t* y,uint
         case SPACE://gamma_move
             if(gamma_move(g, *current_player,*x,*y))
             {
+                journal_move(j, g, *current_player, *x, *y);
                 *ok=next_player(g, current_player);
             }
         break;
@@ -162,6 +168,7 @@ void interactive_command(gamma_t *g,int *z,bool *ok,uint32_t* x,uint32_t* y,uint
         case 'g':case 'G'://golden_move
             if(gamma_golden_move(g, *current_player, *x, *y))
             {
+                journal_golden_move(j, g, *current_player, *x, *y);
                 *ok=next_player(g, current_player);
             }
         break;
@@ -175,7 +182,7 @@ void interactive_command(gamma_t *g,int *z,bool *ok,uint32_t* x,uint32_t* y,uint
  * changes terminal state,
  * main input loop
  */ 
-void main_interactive(gamma_t* g)
+void main_interactive(gamma_t* g,journal_t *j)
 {
     int z=' ';
     uint32_t cursor_x=0,cursor_y=0;
@@ -189,7 +196,7 @@ void main_interactive(gamma_t* g)
     while(ok)
     {
         z=i_getchar();
-        interactive_command(g ,&z, &ok, &cursor_x, &cursor_y, &current_player);
+        interactive_command(g ,&z, &ok, &cursor_x, &cursor_y, &current_player, j);
     }
     
     //writing end state
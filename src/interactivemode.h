@@ -3,8 +3,11 @@
  */ 
 #ifndef INTERACTIVE_MODE
 #define INTERACTIVE_MODE
+#include "gamma.h"
+#include "journal.h"
 /**
  * @brief runs game in interactive mode.
+ * successful moves are recorded in journal @p j, if it is not NULL.
  */
-void main_interactive(gamma_t* g);
+void main_interactive(gamma_t* g,journal_t *j);
 #endif
\ No newline at end of file
@@ -0,0 +1,577 @@
+/** @file
+ * implements journal.h
+ *
+ * journal layout:
+ * header: "GJNL", version byte, varints width, height, players, areas
+ * move record: varint (zigzag(player-previous player)<<2 | type),
+ *              varint zigzag(tile-previous tile), where tile=y*width+x
+ * checkpoint record: varint type, varint payload length, payload:
+ *              varint moves, varint amount of players without golden move,
+ *              those players delta coded, then board as pairs
+ *              varint owner (0 for empty), varint run length in row-major order.
+ *              previous player and tile are reset to 0 after checkpoint.
+ * end record:  varint type, varint amount of checkpoints,
+ *              pairs of delta coded (moves, offset) for every checkpoint,
+ *              then 8 byte little endian offset of end record and "GJNE".
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "gamma.h"
+#include "journal.h"
+
+#define JOURNAL_MOVE 0
+#define JOURNAL_GOLDEN 1
+#define JOURNAL_CHECKPOINT 2
+#define JOURNAL_END 3
+
+#define JOURNAL_VERSION 1
+/** size of "GJNE" trailer together with offset of end record */
+#define JOURNAL_TRAILER 12
+/** amount of moves replayed together by gamma_move_batch */
+#define REPLAY_BATCH 1024
+
+/**
+ * growing byte buffer used for encoding records.
+ */
+struct buffer{
+    uint8_t *a;
+    size_t length;
+    size_t size;
+};
+
+/**
+ * checkpoint position: amount of moves before it and its offset in file.
+ */
+struct checkpoint{
+    uint64_t moves;
+    uint64_t offset;
+};
+
+/**
+ * state of journal opened for recording:
+ * f -journal file
+ * offset -amount of bytes written so far
+ * moves -amount of recorded moves
+ * interval -amount of moves between checkpoints
+ * since_checkpoint -amount of moves recorded after last checkpoint
+ * prev_player, prev_tile -base for delta coding of next move
+ * record -buffer for currently encoded record
+ * checkpoints -table of written checkpoints, written at the end of journal
+ */
+struct journal{
+    FILE *f;
+    uint64_t offset;
+    uint64_t moves;
+    uint64_t interval;
+    uint64_t since_checkpoint;
+    uint32_t prev_player;
+    uint64_t prev_tile;
+    struct buffer record;
+    struct checkpoint *checkpoints;
+    size_t checkpoints_length;
+    size_t checkpoints_size;
+};
+
+/**
+ * appends byte @p x to buffer @p b.
+ */
+static void buffer_put(struct buffer *b,uint8_t x)
+{
+    if(b->length==b->size)
+    {
+        b->size=b->size*2+64;
+        b->a=realloc(b->a,b->size);
+        if(b->a==NULL)exit(1);//emergency
+    }
+    b->a[b->length]=x;
+    b->length++;
+}
+
+/**
+ * appends @p x to buffer @p b as LEB128 varint.
+ */
+static void buffer_put_varint(struct buffer *b,uint64_t x)
+{
+    while(x>=0x80)
+    {
+        buffer_put(b,(uint8_t)(x|0x80));
+        x>>=7;
+    }
+    buffer_put(b,(uint8_t)x);
+}
+
+/**
+ * maps difference @p d (modulo 2^64) to unsigned number,
+ * small differences of both signs give small numbers.
+ */
+static uint64_t zigzag(uint64_t d)
+{
+    return (d<<1)^(0-(d>>63));
+}
+
+/**
+ * inverse of zigzag.
+ */
+static uint64_t unzigzag(uint64_t z)
+{
+    return (z>>1)^(0-(z&1));
+}
+
+/**
+ * writes content of record buffer to file and empties the buffer.
+ */
+static void journal_flush_record(journal_t *j)
+{
+    if(fwrite(j->record.a,1,j->record.length,j->f)!=j->record.length)
+    {
+        fprintf(stderr,"journal write failed\n");
+    }
+    j->offset+=j->record.length;
+    j->record.length=0;
+}
+
+/**
+ * writes checkpoint with current state of board @p g.
+ */
+static void journal_checkpoint(journal_t *j,gamma_t *g)
+{
+    struct buffer payload={NULL,0,0};
+    buffer_put_varint(&payload,j->moves);
+    uint32_t used=0;
+    for(uint32_t i=0;i<g->players;i++)
+    {
+        if(!g->players_golden[i])used++;
+    }
+    buffer_put_varint(&payload,used);
+    uint32_t prev=0;
+    for(uint32_t i=0;i<g->players;i++)
+    {
+        if(!g->players_golden[i])
+        {
+            buffer_put_varint(&payload,i+1-prev);
+            prev=i+1;
+        }
+    }
+    uint32_t owner=gamma_field(g,0,0);
+    uint64_t run=0;
+    for(uint32_t y=0;y<g->height;y++)
+    {
+        for(uint32_t x=0;x<g->width;x++)
+        {
+            uint32_t k=gamma_field(g,x,y);
+            if(k!=owner)
+            {
+                buffer_put_varint(&payload,owner);
+                buffer_put_varint(&payload,run);
+                owner=k;
+                run=0;
+            }
+            run++;
+        }
+    }
+    buffer_put_varint(&payload,owner);
+    buffer_put_varint(&payload,run);
+
+    if(j->checkpoints_length==j->checkpoints_size)
+    {
+        j->checkpoints_size=j->checkpoints_size*2+8;
+        j->checkpoints=realloc(j->checkpoints,j->checkpoints_size*sizeof(struct checkpoint));
+        if(j->checkpoints==NULL)exit(1);//emergency
+    }
+    j->checkpoints[j->checkpoints_length].moves=j->moves;
+    j->checkpoints[j->checkpoints_length].offset=j->offset;
+    j->checkpoints_length++;
+
+    buffer_put_varint(&j->record,JOURNAL_CHECKPOINT);
+    buffer_put_varint(&j->record,payload.length);
+    journal_flush_record(j);
+    if(fwrite(payload.a,1,payload.length,j->f)!=payload.length)
+    {
+        fprintf(stderr,"journal write failed\n");
+    }
+    j->offset+=payload.length;
+    free(payload.a);
+    j->prev_player=0;
+    j->prev_tile=0;
+    j->since_checkpoint=0;
+}
+
+journal_t* journal_create(const char *path, gamma_t *g, uint64_t interval)
+{
+    journal_t *j=NULL;
+    if(path!=NULL && g!=NULL)
+    {
+        j=calloc(1,sizeof(journal_t));
+        if(j!=NULL)
+        {
+            j->f=fopen(path,"wb");
+            if(j->f==NULL)
+            {
+                free(j);
+                j=NULL;
+            }
+        }
+    }
+    if(j!=NULL)
+    {
+        uint64_t amortized=(uint64_t)g->width*g->height/64;
+        j->interval=interval>amortized ? interval : amortized;
+        if(j->interval==0)j->interval=1;
+        buffer_put(&j->record,'G');
+        buffer_put(&j->record,'J');
+        buffer_put(&j->record,'N');
+        buffer_put(&j->record,'L');
+        buffer_put(&j->record,JOURNAL_VERSION);
+        buffer_put_varint(&j->record,g->width);
+        buffer_put_varint(&j->record,g->height);
+        buffer_put_varint(&j->record,g->players);
+        buffer_put_varint(&j->record,g->areas);
+        journal_flush_record(j);
+    }
+    return j;
+}
+
+/**
+ * records move of given @p type, writes checkpoint if it is time for it.
+ */
+static void journal_record(journal_t *j,gamma_t *g,int type,uint32_t player,uint32_t x,uint32_t y)
+{
+    if(j!=NULL && g!=NULL)
+    {
+        uint64_t tile=(uint64_t)y*g->width+x;
+        buffer_put_varint(&j->record,(zigzag((uint64_t)player-j->prev_player)<<2)|type);
+        buffer_put_varint(&j->record,zigzag(tile-j->prev_tile));
+        journal_flush_record(j);
+        j->prev_player=player;
+        j->prev_tile=tile;
+        j->moves++;
+        j->since_checkpoint++;
+        if(j->since_checkpoint>=j->interval)journal_checkpoint(j,g);
+    }
+}
+
+void journal_move(journal_t *j, gamma_t *g, uint32_t player, uint32_t x, uint32_t y)
+{
+    journal_record(j,g,JOURNAL_MOVE,player,x,y);
+}
+
+void journal_golden_move(journal_t *j, gamma_t *g, uint32_t player, uint32_t x, uint32_t y)
+{
+    journal_record(j,g,JOURNAL_GOLDEN,player,x,y);
+}
+
+void journal_close(journal_t *j)
+{
+    if(j!=NULL)
+    {
+        uint64_t end=j->offset;
+        buffer_put_varint(&j->record,JOURNAL_END);
+        buffer_put_varint(&j->record,j->checkpoints_length);
+        uint64_t moves=0,offset=0;
+        for(size_t i=0;i<j->checkpoints_length;i++)
+        {
+            buffer_put_varint(&j->record,j->checkpoints[i].moves-moves);
+            buffer_put_varint(&j->record,j->checkpoints[i].offset-offset);
+            moves=j->checkpoints[i].moves;
+            offset=j->checkpoints[i].offset;
+        }
+        for(int i=0;i<8;i++)buffer_put(&j->record,(uint8_t)(end>>(8*i)));
+        buffer_put(&j->record,'G');
+        buffer_put(&j->record,'J');
+        buffer_put(&j->record,'N');
+        buffer_put(&j->record,'E');
+        journal_flush_record(j);
+        fclose(j->f);
+        free(j->record.a);
+        free(j->checkpoints);
+        free(j);
+    }
+}
+
+/**
+ * read-only view of mapped journal, @p pos is current reading position.
+ */
+struct reader{
+    const uint8_t *a;
+    size_t length;
+    size_t pos;
+    bool ok;
+};
+
+/**
+ * reads varint from @p r, on truncated input sets r->ok to false.
+ */
+static uint64_t read_varint(struct reader *r)
+{
+    uint64_t result=0;
+    int shift=0;
+    bool more=true;
+    while(more && r->ok)
+    {
+        if(r->pos>=r->length || shift>63)
+        {
+            r->ok=false;
+        }
+        else
+        {
+            uint8_t b=r->a[r->pos];
+            r->pos++;
+            result|=(uint64_t)(b&0x7f)<<shift;
+            shift+=7;
+            more=(b&0x80)!=0;
+        }
+    }
+    return result;
+}
+
+/**
+ * reads checkpoint table from the end record, if journal was closed properly.
+ * @returns amount of read checkpoints, table is stored in @p table
+ */
+static size_t read_checkpoint_index(struct reader *r,struct checkpoint **table)
+{
+    size_t result=0;
+    *table=NULL;
+    if(r->length>=JOURNAL_TRAILER
+       && memcmp(r->a+r->length-4,"GJNE",4)==0)
+    {
+        uint64_t end=0;
+        for(int i=0;i<8;i++)end|=(uint64_t)r->a[r->length-JOURNAL_TRAILER+i]<<(8*i);
+        struct reader t={r->a,r->length-JOURNAL_TRAILER,end,end<r->length};
+        if(t.ok && read_varint(&t)==JOURNAL_END)
+        {
+            uint64_t count=read_varint(&t);
+            if(t.ok && count<=t.length)
+            {
+                *table=malloc((count+1)*sizeof(struct checkpoint));
+                if(*table==NULL)exit(1);//emergency
+                uint64_t moves=0,offset=0;
+                for(uint64_t i=0;i<count && t.ok;i++)
+                {
+                    moves+=read_varint(&t);
+                    offset+=read_varint(&t);
+                    (*table)[i].moves=moves;
+                    (*table)[i].offset=offset;
+                }
+                if(t.ok)result=count;
+            }
+        }
+    }
+    return result;
+}
+
+/**
+ * scans records of unclosed journal looking for checkpoints,
+ * skips checkpoint payloads without decoding them.
+ * @returns amount of found checkpoints, table is stored in @p table
+ */
+static size_t scan_checkpoints(struct reader *r,struct checkpoint **table)
+{
+    size_t result=0,size=0;
+    *table=NULL;
+    struct reader t=*r;
+    bool end=false;
+    while(!end && t.ok && t.pos<t.length)
+    {
+        uint64_t offset=t.pos;
+        uint64_t head=read_varint(&t);
+        switch(head&3)
+        {
+            case JOURNAL_MOVE:case JOURNAL_GOLDEN:
+                read_varint(&t);
+            break;
+            case JOURNAL_CHECKPOINT:
+            {
+                uint64_t length=read_varint(&t);
+                uint64_t payload=t.pos;
+                uint64_t moves=read_varint(&t);
+                if(t.ok && length<=t.length-payload)
+                {
+                    if(result==size)
+                    {
+                        size=size*2+8;
+                        *table=realloc(*table,size*sizeof(struct checkpoint));
+                        if(*table==NULL)exit(1);//emergency
+                    }
+                    (*table)[result].moves=moves;
+                    (*table)[result].offset=offset;
+                    result++;
+                    t.pos=payload+length;
+                }
+                else t.ok=false;
+            }
+            break;
+            default:end=true;break;
+        }
+    }
+    return result;
+}
+
+/**
+ * restores state of game @p g from checkpoint record at current position of @p r.
+ * @returns amount of moves made before checkpoint
+ */
+static uint64_t restore_checkpoint(struct reader *r,gamma_t *g)
+{
+    read_varint(r);//type
+    read_varint(r);//length
+    uint64_t moves=read_varint(r);
+    uint64_t used=read_varint(r);
+    uint64_t player=0;
+    for(uint64_t i=0;i<used && r->ok;i++)
+    {
+        player+=read_varint(r);
+        if(!gamma_set_golden(g,player,false))r->ok=false;
+    }
+    uint64_t tile=0,size=(uint64_t)g->width*g->height;
+    while(tile<size && r->ok)
+    {
+        uint64_t owner=read_varint(r);
+        uint64_t run=read_varint(r);
+        if(run>size-tile || owner>g->players)r->ok=false;
+        else if(owner!=0)
+        {
+            for(uint64_t i=tile;i<tile+run;i++)
+            {
+                gamma_set_field(g,owner,i%g->width,i/g->width);
+            }
+        }
+        tile+=run;
+    }
+    gamma_recount_areas(g);
+    return moves;
+}
+
+/**
+ * makes @p length moves buffered in @p batch in @p g at once and empties
+ * the buffer; @p done grows by amount of moves made before the first
+ * illegal one. returns false if one of the moves was illegal (journal
+ * is damaged).
+ */
+static bool replay_flush(gamma_t *g,struct gamma_move_request *batch,size_t *length,uint64_t *done)
+{
+    bool results[REPLAY_BATCH];
+    size_t made=gamma_move_batch(g,batch,*length,results);
+    bool result=made==*length;
+    if(result)*done+=made;
+    else
+    {
+        size_t i=0;
+        while(results[i])i++;
+        *done+=i;
+    }
+    *length=0;
+    return result;
+}
+
+gamma_t* journal_replay(const char *path, uint64_t moves, uint64_t *replayed)
+{
+    gamma_t *g=NULL;
+    uint64_t done=0;
+    int fd=open(path,O_RDONLY);
+    struct stat st;
+    if(fd>=0 && fstat(fd,&st)==0 && st.st_size>0)
+    {
+        void *map=mmap(NULL,st.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+        if(map!=MAP_FAILED)
+        {
+            struct reader r={map,st.st_size,0,true};
+            if(r.length>5 && memcmp(r.a,"GJNL",4)==0 && r.a[4]==JOURNAL_VERSION)
+            {
+                r.pos=5;
+                uint64_t width=read_varint(&r);
+                uint64_t height=read_varint(&r);
+                uint64_t players=read_varint(&r);
+                uint64_t areas=read_varint(&r);
+                if(r.ok && width<=UINT32_MAX && height<=UINT32_MAX
+                   && players<=UINT32_MAX && areas<=UINT32_MAX)
+                {
+                    g=gamma_new(width,height,players,areas);
+                }
+            }
+            if(g!=NULL)
+            {
+                struct checkpoint *table=NULL;
+                size_t count=read_checkpoint_index(&r,&table);
+                if(count==0)
+                {
+                    free(table);
+                    count=scan_checkpoints(&r,&table);
+                }
+                bool damaged=false;
+                size_t best=count;
+                for(size_t i=0;i<count;i++)
+                {
+                    if(table[i].moves<=moves)best=i;
+                }
+                if(best<count && table[best].offset<r.length)
+                {
+                    r.pos=table[best].offset;
+                    done=restore_checkpoint(&r,g);
+                    damaged=!r.ok;
+                }
+                free(table);
+                uint32_t player=0;
+                uint64_t tile=0;
+                bool end=false;
+                struct gamma_move_request batch[REPLAY_BATCH];
+                size_t length=0;
+                while(r.ok && !damaged && !end && done+length<moves && r.pos<r.length)
+                {
+                    uint64_t head=read_varint(&r);
+                    uint64_t delta=read_varint(&r);
+                    int type=head&3;
+                    //record cut in the middle means that journal is damaged
+                    if(!r.ok)damaged=true;
+                    else if(type==JOURNAL_END)end=true;
+                    else if(type==JOURNAL_CHECKPOINT)
+                    {
+                        //state is the same, only delta coding starts again
+                        if(delta>r.length-r.pos)damaged=true;
+                        else r.pos+=delta;
+                        player=0;
+                        tile=0;
+                    }
+                    else
+                    {
+                        player+=unzigzag(head>>2);
+                        tile+=unzigzag(delta);
+                        uint32_t x=tile%g->width,y=tile/g->width;
+                        if(type==JOURNAL_MOVE)
+                        {
+                            struct gamma_move_request m={player,x,y};
+                            batch[length++]=m;
+                        }
+                        else
+                        {
+                            damaged=!replay_flush(g,batch,&length,&done);
+                            if(!damaged && gamma_golden_move(g,player,x,y))done++;
+                            else damaged=true;
+                        }
+                        if(length==REPLAY_BATCH)damaged=!replay_flush(g,batch,&length,&done);
+                    }
+                }
+                if(!damaged && !replay_flush(g,batch,&length,&done))damaged=true;
+                if(damaged)
+                {
+                    gamma_delete(g);
+                    g=NULL;
+                }
+            }
+            munmap(map,st.st_size);
+        }
+    }
+    if(fd>=0)close(fd);
+    if(replayed!=NULL)*replayed=done;
+    return g;
+}
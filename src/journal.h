@@ -0,0 +1,62 @@
+/** @file
+ * interface of append-only game journal.
+ * Journal stores every successful gamma_move and gamma_golden_move
+ * as a compact binary record (varints, delta coded fields),
+ * with periodic checkpoints of the whole board, so a game can be rebuilt
+ * (or rebuilt up to a given move) without parsing batch text.
+ */
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "gamma.h"
+
+/**
+ * default minimal amount of moves between two checkpoints.
+ */
+#define JOURNAL_DEFAULT_INTERVAL ((uint64_t) 4096)
+
+/**
+ * journal opened for recording.
+ */
+typedef struct journal journal_t;
+
+/**
+ * creates journal file @p path for game @p g (which should be new).
+ * checkpoint is written every @p interval moves, but not more often than
+ * every width*height/64 moves, so their cost stays amortized.
+ * @returns NULL if file could not be created
+ */
+journal_t* journal_create(const char *path, gamma_t *g, uint64_t interval);
+
+/**
+ * records normal move of @p player on tile < @p x, @p y >.
+ * should be called only after gamma_move returned true.
+ */
+void journal_move(journal_t *j, gamma_t *g, uint32_t player, uint32_t x, uint32_t y);
+
+/**
+ * records golden move of @p player on tile < @p x, @p y >.
+ * should be called only after gamma_golden_move returned true.
+ */
+void journal_golden_move(journal_t *j, gamma_t *g, uint32_t player, uint32_t x, uint32_t y);
+
+/**
+ * writes checkpoint index at the end of journal, closes file
+ * and frees memory used by @p j. Does nothing for NULL.
+ */
+void journal_close(journal_t *j);
+
+/**
+ * rebuilds game recorded in journal @p path after @p moves moves
+ * (UINT64_MAX for whole journal). Starts from the nearest checkpoint.
+ * @p replayed (may be NULL) is set to amount of moves actually applied
+ * counting from the beginning of the game. Journal which was not closed
+ * is replayed up to its last whole record.
+ * @returns NULL if journal is damaged (also cut inside of a record needed
+ * for @p moves moves) or memory could not be allocated
+ */
+gamma_t* journal_replay(const char *path, uint64_t moves, uint64_t *replayed);
+
+#endif /* JOURNAL_H */
@@ -0,0 +1,479 @@
+/** @file
+ * implements labeling.h
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "labeling.h"
+#include "rle.h"
+#include "summary.h"
+#include "tile_list.h"
+#include "tiled.h"
+
+/** bands smaller than this are not worth starting a thread */
+#define LABEL_MIN_BAND_TILES (1u<<18)
+/** maximal amount of bands */
+#define LABEL_MAX_BANDS 64
+
+/**
+ * maximal run of labeled tiles [start, end) of the same value in one row,
+ * node -union-find node of the run
+ */
+struct run{
+    uint32_t start;
+    uint32_t end;
+    int value;
+    uint32_t node;
+};
+
+/**
+ * rows [first_row, end_row) of board labeled by one thread.
+ * player1, player2 -values of labeled tiles, unless all tiles are labeled
+ * areas -amount of areas inside of the band, indexed by slot
+ * labeled -amount of labeled tiles
+ * runs -buffer for runs of two rows
+ * width -capacity of one row in @p runs
+ * parent -union-find parents, indexed by node increased by one
+ *         (0 -not labeled); node is first tile of the run for array board
+ *         and number of the run counted from first row for rle board
+ * offsets -number of first run of every row (rle board only)
+ * array_runs -splits row of array board of cells of the right width
+ */
+struct band{
+    gamma_t *g;
+    uint32_t first_row;
+    uint32_t end_row;
+    int player1;
+    int player2;
+    bool all;
+    uint32_t *areas;
+    uint64_t labeled;
+    struct run *runs;
+    uint32_t width;
+    uint32_t *parent;
+    const uint32_t *offsets;
+    uint32_t (*array_runs)(struct band *b,uint32_t y,struct run *runs);
+};
+
+/**
+ * returns slot of tile value @p k in areas of band @p b ,
+ * or -1 if such tiles are not labeled.
+ */
+static int64_t band_slot(const struct band *b,int k)
+{
+    int64_t result=-1;
+    if(b->all)
+    {
+        if(k!='.')result=k-'1';
+    }
+    else if(k==b->player1)result=0;
+    else if(k==b->player2)result=1;
+    return result;
+}
+
+/**
+ * returns root of tile @p i , halving the path on the way.
+ * @p parent keeps index of parent increased by one (0 -not labeled).
+ */
+static uint32_t label_find(uint32_t *parent,uint32_t i)
+{
+    while(parent[i]-1!=i)
+    {
+        parent[i]=parent[parent[i]-1];
+        i=parent[i]-1;
+    }
+    return i;
+}
+
+/**
+ * joins sets of tiles @p a and @p b , root with smaller index stays root.
+ * @returns true if tiles were in different sets
+ */
+static bool label_union(uint32_t *parent,uint32_t a,uint32_t b)
+{
+    bool result=false;
+    a=label_find(parent,a);
+    b=label_find(parent,b);
+    if(a!=b)
+    {
+        if(a<b)parent[b]=a+1;
+        else parent[a]=b+1;
+        result=true;
+    }
+    return result;
+}
+
+/**
+ * stores run [ @p start , @p end ) of @p value of row @p y of array board
+ * or board split into blocks in @p run , if such tiles are labeled in @p b .
+ * @returns amount of stored runs
+ */
+static uint32_t run_add(struct band *b,struct run *run,uint32_t y,uint32_t start,uint32_t end,int value)
+{
+    uint32_t result=0;
+    if(band_slot(b,value)>=0)
+    {
+        run->start=start;
+        run->end=end;
+        run->value=value;
+        run->node=y*b->g->width+start;
+        result=1;
+    }
+    return result;
+}
+
+/** value of tiles of a segment which have no labeled tiles */
+#define SEGMENT_NONE (-1)
+/** value of a segment which tiles have to be read */
+#define SEGMENT_SCAN (-2)
+
+/**
+ * returns value of all tiles of part of row @p y of board of band @p b
+ * inside of block of summaries containing column @p x : SEGMENT_NONE if
+ * none of them is labeled, value of the only owner of the full block,
+ * or SEGMENT_SCAN if the tiles are not known without reading them.
+ */
+static int segment_value(const struct band *b,uint32_t x,uint32_t y)
+{
+    const struct block_summary *s=summary_at(b->g->summary,b->g->summary_columns,x,y);
+    int result=SEGMENT_SCAN;
+    if(s->empty==0 && s->owner!=SUMMARY_MIXED)result=s->owner;
+    else if(s->owner==SUMMARY_NONE)result=SEGMENT_NONE;
+    else if(!b->all && !summary_may_have(s,b->player1) && !summary_may_have(s,b->player2))
+    {
+        result=SEGMENT_NONE;
+    }
+    return result;
+}
+
+#define CELL_T uint8_t
+#define CELL_FN(name) name##_8
+#include "labeling_cells.h"
+#undef CELL_FN
+#undef CELL_T
+#define CELL_T uint16_t
+#define CELL_FN(name) name##_16
+#include "labeling_cells.h"
+#undef CELL_FN
+#undef CELL_T
+#define CELL_T uint32_t
+#define CELL_FN(name) name##_32
+#include "labeling_cells.h"
+#undef CELL_FN
+#undef CELL_T
+
+/**
+ * stores labeled runs of row @p y of band @p b in @p runs .
+ * @returns amount of runs
+ */
+static uint32_t row_runs(struct band *b,uint32_t y,struct run *runs)
+{
+    uint32_t w=b->g->width;
+    uint32_t n=0;
+    if(b->g->rle!=NULL)
+    {
+        //runs of rle row are ready, only unlabeled ones are skipped
+        const struct rle_row *r=&b->g->rle[y];
+        for(uint32_t i=0;i<rle_length(r);i++)
+        {
+            uint32_t end=0;
+            struct rle_run run=rle_run(r,w,i,&end);
+            if(band_slot(b,run.value)>=0)
+            {
+                runs[n].start=run.start;
+                runs[n].end=end;
+                runs[n].value=run.value;
+                runs[n].node=b->offsets[y]+i;
+                n++;
+            }
+        }
+        return n;
+    }
+    if(b->g->tile_columns>0)
+    {
+        //row of board split into blocks is read block by block,
+        //blocks inside of known segments are not read
+        const int *cells=(const int*)b->g->board+tiled_index(b->g->tile_columns,0,y);
+        uint32_t start=0;
+        int value=SEGMENT_NONE;
+        int segment=SEGMENT_SCAN;
+        for(uint32_t k=0;k<w;k+=TILED_SIDE,cells+=TILED_SIDE*TILED_SIDE)
+        {
+            uint32_t length=w-k>TILED_SIDE ? TILED_SIDE : w-k;
+            if(k%SUMMARY_COLUMNS==0)segment=segment_value(b,k,y);
+            if(segment==SEGMENT_SCAN)
+            {
+                for(uint32_t i=0;i<length;i++)
+                {
+                    if(cells[i]!=value)
+                    {
+                        n+=run_add(b,runs+n,y,start,k+i,value);
+                        start=k+i;
+                        value=cells[i];
+                    }
+                }
+            }
+            else if(segment!=value)
+            {
+                n+=run_add(b,runs+n,y,start,k,value);
+                start=k;
+                value=segment;
+            }
+        }
+        n+=run_add(b,runs+n,y,start,w,value);
+        return n;
+    }
+    return b->array_runs(b,y,runs);
+}
+
+/**
+ * joins runs @p cur of a row with overlapping runs @p above of the row
+ * above of the same value, every join removes one area from @p areas .
+ * @p create -runs of row @p y are not labeled yet, run not joined with
+ *            any run above starts new area
+ */
+static void runs_merge(struct band *b,const struct run *cur,uint32_t n,
+                       const struct run *above,uint32_t m,uint32_t *areas,bool create)
+{
+    uint32_t *parent=b->parent;
+    uint32_t j=0;
+    for(uint32_t i=0;i<n;i++)
+    {
+        uint32_t head=cur[i].node;
+        int64_t s=band_slot(b,cur[i].value);
+        bool joined=!create;
+        while(j<m && above[j].end<=cur[i].start)j++;
+        //last overlapping run can overlap next run of the row too
+        for(uint32_t k=j;k<m && above[k].start<cur[i].end;k++)
+        {
+            uint32_t other=above[k].node;
+            if(above[k].value==cur[i].value && !joined)
+            {
+                //any ancestor of run above is good enough as parent
+                parent[head]=parent[other];
+                joined=true;
+            }
+            else if(above[k].value==cur[i].value && label_union(parent,head,other))
+            {
+                areas[s]--;
+            }
+        }
+        if(!joined)
+        {
+            parent[head]=head+1;
+            areas[s]++;
+        }
+        if(create)b->labeled+=cur[i].end-cur[i].start;
+    }
+}
+
+/**
+ * labels runs of band @p arg (struct band) and counts its areas.
+ * runs of previous row are kept in second half of band buffer.
+ */
+static void* band_label(void *arg)
+{
+    struct band *b=arg;
+    struct run *cur=b->runs,*above=b->runs+b->width;
+    uint32_t m=0;
+    for(uint32_t y=b->first_row;y<b->end_row;y++)
+    {
+        uint32_t n=row_runs(b,y,cur);
+        runs_merge(b,cur,n,above,m,b->areas,true);
+        struct run *t=cur;
+        cur=above;
+        above=t;
+        m=n;
+    }
+    return NULL;
+}
+
+/**
+ * zeroes union-find parents of band @p arg (struct band) kept in visited
+ * marks of array board.
+ */
+static void* band_clear(void *arg)
+{
+    struct band *b=arg;
+    size_t w=b->g->width;
+    memset(b->g->visited+b->first_row*w,0,(b->end_row-b->first_row)*w*sizeof(int));
+    return NULL;
+}
+
+/**
+ * runs @p f for all @p count bands of @p b , each but first in new thread.
+ * bands which thread could not be started are run by calling thread.
+ */
+static void bands_run(struct band *b,uint32_t count,void* (*f)(void*))
+{
+    pthread_t thread[LABEL_MAX_BANDS];
+    bool started[LABEL_MAX_BANDS];
+    for(uint32_t k=1;k<count;k++)
+    {
+        started[k]=pthread_create(&thread[k],NULL,f,&b[k])==0;
+        if(!started[k])f(&b[k]);
+    }
+    f(&b[0]);
+    for(uint32_t k=1;k<count;k++)
+    {
+        if(started[k])pthread_join(thread[k],NULL);
+    }
+}
+
+/**
+ * returns amount of bands for board of @p g labeled by @p threads threads.
+ */
+static uint32_t bands_count(gamma_t *g,uint32_t threads)
+{
+    uint64_t result=(uint64_t)g->width*g->height/LABEL_MIN_BAND_TILES;
+    if(result>1 && threads==0)
+    {
+        long processors=sysconf(_SC_NPROCESSORS_ONLN);
+        threads=processors>0 ? processors : 1;
+    }
+    if(result>threads)result=threads;
+    if(result>g->height)result=g->height;
+    if(result>LABEL_MAX_BANDS)result=LABEL_MAX_BANDS;
+    if(result==0)result=1;
+    return result;
+}
+
+/**
+ * returns scratch array of @p g with at least @p size numbers, first
+ * @p zeroed of them set to 0. scratch can not be missing, as every
+ * recount needs it.
+ */
+static uint32_t* label_scratch(gamma_t *g,uint64_t size,uint64_t zeroed)
+{
+    if(size>g->scratch_size)
+    {
+        g->scratch=realloc(g->scratch,size*sizeof(uint32_t));
+        if(g->scratch==NULL)exit(1);//emergency
+#ifdef GAMMA_STATS
+        g->counters.bytes_allocated+=size*sizeof(uint32_t);
+#endif
+        g->scratch_size=size;
+    }
+    memset(g->scratch,0,zeroed*sizeof(uint32_t));
+    return g->scratch;
+}
+
+/**
+ * counts areas of tiles on list @p l of board of @p g , joining every
+ * tile with its left and lower neighbour if they are on the list too.
+ * only parents of listed tiles are written and they are zeroed back.
+ */
+static uint32_t list_areas(gamma_t *g,const struct tile_list *l)
+{
+    uint32_t *parent=(uint32_t*)g->visited;
+    uint32_t w=g->width;
+    uint32_t result=l->length;
+    for(uint32_t i=0;i<l->length;i++)parent[l->cells[i]]=l->cells[i]+1;
+    for(uint32_t i=0;i<l->length;i++)
+    {
+        uint32_t c=l->cells[i];
+        if(c%w>0 && parent[c-1]!=0 && label_union(parent,c,c-1))result--;
+        if(c>=w && parent[c-w]!=0 && label_union(parent,c,c-w))result--;
+    }
+    for(uint32_t i=0;i<l->length;i++)parent[l->cells[i]]=0;
+    return result;
+}
+
+uint64_t label_areas(gamma_t *g,uint32_t player1,uint32_t player2,uint32_t threads)
+{
+    if(player1!=0 && g->players_list!=NULL)
+    {
+        const struct tile_list *l1=&g->players_list[player1-1],*l2=&g->players_list[player2-1];
+        uint64_t listed=l1->length+(player2!=player1 ? l2->length : 0);
+        if(listed*TILE_LIST_RATIO<(uint64_t)g->width*g->height)
+        {
+            //few tiles, only they are visited
+            g->players_area[player1-1]=list_areas(g,l1);
+            if(player2!=player1)g->players_area[player2-1]=list_areas(g,l2);
+            return listed;
+        }
+    }
+
+    struct band b[LABEL_MAX_BANDS];
+    uint32_t pair[2]={0,0};
+    bool all=player1==0;
+    uint32_t slots=all ? g->players : 2;
+    uint32_t *areas=all ? g->players_area : pair;
+    uint32_t count=bands_count(g,threads);
+    uint32_t w=g->width;
+    //scratch: counters of bands but first, for rle board run numbers
+    //of rows and parents of all runs, then buffers of runs of two rows per band
+    uint64_t counters=(uint64_t)(count-1)*slots;
+    uint64_t offsets=0,nodes=0;
+    uint32_t row_width=w;
+    if(g->rle!=NULL)
+    {
+        offsets=g->height;
+        row_width=1;
+        for(uint32_t y=0;y<g->height;y++)
+        {
+            nodes+=rle_length(&g->rle[y]);
+            if(rle_length(&g->rle[y])>row_width)row_width=rle_length(&g->rle[y]);
+        }
+    }
+    uint32_t (*array_runs)(struct band*,uint32_t,struct run*)=array_runs_32;
+    if(g->cell_bytes==1)array_runs=array_runs_8;
+    else if(g->cell_bytes==2)array_runs=array_runs_16;
+    uint64_t per_run=sizeof(struct run)/sizeof(uint32_t);
+    uint32_t *scratch=label_scratch(g,counters+offsets+nodes+count*2*(uint64_t)row_width*per_run,counters);
+    uint32_t *row_offsets=scratch+counters;
+    uint32_t *parent=g->rle!=NULL ? row_offsets+offsets : (uint32_t*)g->visited;
+    struct run *runs=(struct run*)(row_offsets+offsets+nodes);
+    if(g->rle!=NULL)
+    {
+        uint32_t first=0;
+        for(uint32_t y=0;y<g->height;y++)
+        {
+            row_offsets[y]=first;
+            first+=rle_length(&g->rle[y]);
+        }
+    }
+    memset(areas,0,slots*sizeof(uint32_t));
+    for(uint32_t k=0;k<count;k++)
+    {
+        b[k].g=g;
+        b[k].first_row=(uint64_t)g->height*k/count;
+        b[k].end_row=(uint64_t)g->height*(k+1)/count;
+        b[k].player1='0'+player1;
+        b[k].player2='0'+player2;
+        b[k].all=all;
+        b[k].areas=k==0 ? areas : scratch+(uint64_t)(k-1)*slots;
+        b[k].labeled=0;
+        b[k].runs=runs+(uint64_t)k*2*row_width;
+        b[k].width=row_width;
+        b[k].parent=parent;
+        b[k].offsets=row_offsets;
+        b[k].array_runs=array_runs;
+    }
+    bands_run(b,count,band_label);
+
+    uint64_t labeled=b[0].labeled;
+    for(uint32_t k=1;k<count;k++)
+    {
+        labeled+=b[k].labeled;
+        for(uint32_t s=0;s<slots;s++)areas[s]+=b[k].areas[s];
+        //areas touching border of bands were counted in both of them
+        uint32_t y=b[k].first_row;
+        uint32_t n=row_runs(&b[k],y,b[k].runs);
+        uint32_t m=row_runs(&b[k],y-1,b[k].runs+row_width);
+        runs_merge(&b[k],b[k].runs,n,b[k].runs+row_width,m,areas,false);
+    }
+    if(g->rle==NULL)bands_run(b,count,band_clear);
+
+    if(!all)
+    {
+        g->players_area[player1-1]=pair[0];
+        if(player2!=player1)g->players_area[player2-1]=pair[1];
+    }
+    return labeled;
+}
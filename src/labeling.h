@@ -0,0 +1,30 @@
+/** @file
+ * connected component labeling of gamma board, used for area recounts.
+ */
+#ifndef LABELING_H
+#define LABELING_H
+#include <stdint.h>
+#include "gamma.h"
+
+/**
+ * counts areas of @p player1 and @p player2 (of all players if @p player1
+ * is 0) and stores them in players_area of @p g .
+ * rows are split into runs of tiles of the same value, every run is
+ * labeled by its first tile and joined with overlapping runs of the row
+ * above, so the work is proportional to the amount of runs.
+ * board is split into row bands labeled by up to @p threads threads
+ * (0 -one per processor), then labels touching across band borders
+ * are merged with union-find.
+ * g->visited is used as union-find parents (only first tiles of runs
+ * are written) and is left zeroed. runs of rle board are labeled by their
+ * numbers, their parents are kept in scratch array. rows of board split
+ * into blocks are read block by block. parts of rows in blocks of
+ * summaries (g->summary) without labeled tiles, or full of tiles of one
+ * player, are not read.
+ * if tiles of @p player1 and @p player2 are less than 1/TILE_LIST_RATIO
+ * of the board, only tiles on their lists (g->players_list) are labeled.
+ * @returns amount of labeled tiles
+ */
+uint64_t label_areas(gamma_t *g,uint32_t player1,uint32_t player2,uint32_t threads);
+
+#endif
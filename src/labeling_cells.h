@@ -0,0 +1,45 @@
+/** @file
+ * splitting rows of row-major array board into runs, written once for all
+ * cell widths. this file is included by labeling.c once for every width,
+ * with CELL_T defined as type of a cell and CELL_FN(name) giving name of
+ * the variant of a function; it has no include guard on purpose.
+ */
+
+/**
+ * stores labeled runs of row @p y of array board of band @p b in @p runs .
+ * segments of the row which value is known from summaries are not read.
+ * @returns amount of runs
+ */
+static uint32_t CELL_FN(array_runs)(struct band *b,uint32_t y,struct run *runs)
+{
+    uint32_t w=b->g->width;
+    const CELL_T *row=(const CELL_T*)b->g->board+(size_t)y*w;
+    uint32_t n=0;
+    uint32_t start=0;
+    int value=SEGMENT_NONE;
+    for(uint32_t x=0;x<w;x+=SUMMARY_COLUMNS)
+    {
+        uint32_t end=w-x>SUMMARY_COLUMNS ? x+SUMMARY_COLUMNS : w;
+        int segment=segment_value(b,x,y);
+        if(segment==SEGMENT_SCAN)
+        {
+            for(uint32_t i=x;i<end;i++)
+            {
+                if((int)row[i]!=value)
+                {
+                    n+=run_add(b,runs+n,y,start,i,value);
+                    start=i;
+                    value=row[i];
+                }
+            }
+        }
+        else if(segment!=value)
+        {
+            n+=run_add(b,runs+n,y,start,x,value);
+            start=x;
+            value=segment;
+        }
+    }
+    n+=run_add(b,runs+n,y,start,w,value);
+    return n;
+}
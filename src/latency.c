@@ -0,0 +1,242 @@
+/** @file
+ * implements latency.h
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "latency.h"
+
+/** buckets for every power of two */
+#define SUB_BUCKETS 8
+/** log2 of SUB_BUCKETS */
+#define SUB_BITS 3
+/** amount of buckets covering all 64 bit values */
+#define BUCKETS (64*SUB_BUCKETS)
+/** amount of distinct command characters */
+#define COMMANDS 128
+
+/**
+ * histogram of one command letter.
+ */
+struct histogram{
+    uint64_t count;
+    uint64_t max;
+    uint64_t sum;
+    uint64_t bucket[BUCKETS];
+};
+
+/**
+ * one of the slowest commands.
+ */
+struct slow_command{
+    uint64_t ns;
+    int line;
+    int command;
+};
+
+/**
+ * histograms are created when command is seen for the first time,
+ * slowest commands are kept in min-heap of size @p slowest_size.
+ */
+struct latency{
+    struct histogram *histogram[COMMANDS];
+    struct slow_command *slowest;
+    uint32_t slowest_length;
+    uint32_t slowest_size;
+};
+
+latency_t* latency_new(uint32_t slowest)
+{
+    latency_t *l=calloc(1,sizeof(latency_t));
+    if(l!=NULL && slowest>0)
+    {
+        l->slowest=malloc(slowest*sizeof(struct slow_command));
+        l->slowest_size=slowest;
+        if(l->slowest==NULL)
+        {
+            free(l);
+            l=NULL;
+        }
+    }
+    return l;
+}
+
+uint64_t latency_clock(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC,&t);
+    return (uint64_t)t.tv_sec*1000000000u+t.tv_nsec;
+}
+
+/**
+ * returns index of bucket containing @p ns.
+ */
+static int bucket_index(uint64_t ns)
+{
+    int result;
+    if(ns<SUB_BUCKETS)result=ns;
+    else
+    {
+        int e=63-__builtin_clzll(ns);
+        int sub=(ns>>(e-SUB_BITS))&(SUB_BUCKETS-1);
+        result=(e-SUB_BITS+1)*SUB_BUCKETS+sub;
+    }
+    return result;
+}
+
+/**
+ * returns largest value stored in bucket @p index.
+ */
+static uint64_t bucket_top(int index)
+{
+    uint64_t result;
+    if(index<SUB_BUCKETS)result=index;
+    else
+    {
+        int e=index/SUB_BUCKETS+SUB_BITS-1;
+        uint64_t sub=index%SUB_BUCKETS;
+        uint64_t low=(SUB_BUCKETS+sub)<<(e-SUB_BITS);
+        result=low+(((uint64_t)1)<<(e-SUB_BITS))-1;
+    }
+    return result;
+}
+
+/**
+ * restores heap order of slowest commands going down from @p i.
+ */
+static void heap_down(latency_t *l,uint32_t i)
+{
+    bool done=false;
+    while(!done)
+    {
+        uint32_t smallest=i;
+        uint32_t left=2*i+1,right=2*i+2;
+        if(left<l->slowest_length && l->slowest[left].ns<l->slowest[smallest].ns)smallest=left;
+        if(right<l->slowest_length && l->slowest[right].ns<l->slowest[smallest].ns)smallest=right;
+        if(smallest==i)done=true;
+        else
+        {
+            struct slow_command t=l->slowest[i];
+            l->slowest[i]=l->slowest[smallest];
+            l->slowest[smallest]=t;
+            i=smallest;
+        }
+    }
+}
+
+/**
+ * restores heap order of slowest commands going up from @p i.
+ */
+static void heap_up(latency_t *l,uint32_t i)
+{
+    while(i>0 && l->slowest[(i-1)/2].ns>l->slowest[i].ns)
+    {
+        struct slow_command t=l->slowest[i];
+        l->slowest[i]=l->slowest[(i-1)/2];
+        l->slowest[(i-1)/2]=t;
+        i=(i-1)/2;
+    }
+}
+
+void latency_record(latency_t *l,int command,int line,uint64_t ns)
+{
+    if(l!=NULL)
+    {
+        //unprintable commands share one histogram
+        if(command<=' ' || command>=COMMANDS-1)command='?';
+        struct histogram *h=l->histogram[command];
+        if(h==NULL)
+        {
+            h=calloc(1,sizeof(struct histogram));
+            if(h==NULL)exit(1);//emergency
+            l->histogram[command]=h;
+        }
+        h->count++;
+        h->sum+=ns;
+        if(ns>h->max)h->max=ns;
+        h->bucket[bucket_index(ns)]++;
+
+        struct slow_command c={ns,line,command};
+        if(l->slowest_length<l->slowest_size)
+        {
+            l->slowest[l->slowest_length]=c;
+            l->slowest_length++;
+            heap_up(l,l->slowest_length-1);
+        }
+        else if(l->slowest_size>0 && ns>l->slowest[0].ns)
+        {
+            l->slowest[0]=c;
+            heap_down(l,0);
+        }
+    }
+}
+
+/**
+ * returns value below which fraction @p q of recorded times is
+ * (upper bound of bucket, but not more than maximum).
+ */
+static uint64_t percentile(const struct histogram *h,double q)
+{
+    uint64_t rank=(uint64_t)(q*h->count);
+    if(rank>=h->count)rank=h->count-1;
+    uint64_t seen=0;
+    int i=0;
+    while(seen+h->bucket[i]<=rank)
+    {
+        seen+=h->bucket[i];
+        i++;
+    }
+    uint64_t result=bucket_top(i);
+    return result<h->max ? result : h->max;
+}
+
+/**
+ * compares slow commands, slower first.
+ */
+static int slow_compare(const void *a,const void *b)
+{
+    const struct slow_command *x=a,*y=b;
+    if(x->ns!=y->ns)return x->ns<y->ns ? 1 : -1;
+    return x->line-y->line;
+}
+
+void latency_print(latency_t *l,FILE *f)
+{
+    if(l!=NULL && f!=NULL)
+    {
+        fprintf(f,"LATENCY command count mean_ns p50_ns p99_ns p999_ns max_ns\n");
+        for(int i=0;i<COMMANDS;i++)
+        {
+            const struct histogram *h=l->histogram[i];
+            if(h!=NULL)
+            {
+                fprintf(f,"LATENCY %c %"PRIu64" %"PRIu64" %"PRIu64" %"PRIu64" %"PRIu64" %"PRIu64"\n",i,
+                        h->count,h->sum/h->count,percentile(h,0.5),percentile(h,0.99),
+                        percentile(h,0.999),h->max);
+            }
+        }
+        qsort(l->slowest,l->slowest_length,sizeof(struct slow_command),slow_compare);
+        fprintf(f,"SLOWEST line command ns\n");
+        for(uint32_t i=0;i<l->slowest_length;i++)
+        {
+            fprintf(f,"SLOWEST %d %c %"PRIu64"\n",l->slowest[i].line,l->slowest[i].command,l->slowest[i].ns);
+        }
+        //sorting (slowest first) broke heap order, rebuild it
+        for(uint32_t i=l->slowest_length/2+1;i-->0;)heap_down(l,i);
+    }
+}
+
+void latency_delete(latency_t *l)
+{
+    if(l!=NULL)
+    {
+        for(int i=0;i<COMMANDS;i++)free(l->histogram[i]);
+        free(l->slowest);
+        free(l);
+    }
+}
@@ -0,0 +1,51 @@
+/** @file
+ * interface of per-command latency histograms for batch mode.
+ * Times are stored in log-bucketed histograms (8 buckets for every
+ * power of two, so percentiles are exact to about 12%), together with
+ * line numbers of the slowest commands.
+ */
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * default amount of slowest commands remembered.
+ */
+#define LATENCY_DEFAULT_SLOWEST 10
+
+/**
+ * latency histograms of all command letters.
+ */
+typedef struct latency latency_t;
+
+/**
+ * creates empty histograms, @p slowest slowest commands will be remembered.
+ * @returns NULL if memory could not be allocated
+ */
+latency_t* latency_new(uint32_t slowest);
+
+/**
+ * returns monotonic clock time in nanoseconds.
+ */
+uint64_t latency_clock(void);
+
+/**
+ * records that command @p command from line @p line took @p ns nanoseconds.
+ * does nothing for NULL @p l.
+ */
+void latency_record(latency_t *l,int command,int line,uint64_t ns);
+
+/**
+ * prints count, p50, p99, p999 and max for every command letter seen
+ * and the slowest commands (with their line numbers) to @p f.
+ */
+void latency_print(latency_t *l,FILE *f);
+
+/**
+ * frees memory used by @p l. Does nothing for NULL.
+ */
+void latency_delete(latency_t *l);
+
+#endif /* LATENCY_H */
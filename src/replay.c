@@ -0,0 +1,46 @@
+/** @file
+ * @brief rebuilds game from journal written by gamma -j.
+ * usage: gamma_replay journal [moves]
+ * prints board after given amount of moves (whole journal by default)
+ * and replay time on stderr.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "gamma.h"
+#include "journal.h"
+
+int main(int argc,char *argv[])
+{
+    if(argc!=2 && argc!=3)
+    {
+        fprintf(stderr,"usage: %s journal [moves]\n",argv[0]);
+        return 1;
+    }
+    uint64_t moves=UINT64_MAX;
+    if(argc==3)moves=strtoull(argv[2],NULL,10);
+
+    struct timespec start,end;
+    clock_gettime(CLOCK_MONOTONIC,&start);
+    uint64_t replayed=0;
+    gamma_t *g=journal_replay(argv[1],moves,&replayed);
+    clock_gettime(CLOCK_MONOTONIC,&end);
+    if(g==NULL)
+    {
+        fprintf(stderr,"cannot replay journal %s\n",argv[1]);
+        return 1;
+    }
+    double ms=(end.tv_sec-start.tv_sec)*1e3+(end.tv_nsec-start.tv_nsec)/1e6;
+    fprintf(stderr,"replayed %"PRIu64" moves in %.3f ms\n",replayed,ms);
+
+    char *s=gamma_board(g);
+    if(s!=NULL)printf("%s",s);
+    free(s);
+    gamma_delete(g);
+    return 0;
+}
@@ -0,0 +1,187 @@
+/** @file
+ * implements rle.h
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rle.h"
+
+/**
+ * returns run with logical index @p i of @p r .
+ */
+static struct rle_run* rle_at(const struct rle_row *r,uint32_t i)
+{
+    if(i<r->gap)return r->runs+i;
+    else return r->runs+i+(r->capacity-r->length);
+}
+
+/**
+ * returns logical index of run containing column @p x (binary search).
+ */
+static uint32_t rle_find(const struct rle_row *r,uint32_t x)
+{
+    uint32_t low=0,high=r->length;
+    //invariant: run low starts at most at x, runs from high start after x
+    while(high-low>1)
+    {
+        uint32_t middle=low+(high-low)/2;
+        if(rle_at(r,middle)->start<=x)low=middle;
+        else high=middle;
+    }
+    return low;
+}
+
+/**
+ * moves gap of @p r to logical index @p position .
+ */
+static void rle_gap_move(struct rle_row *r,uint32_t position)
+{
+    uint32_t size=r->capacity-r->length;
+    if(position<r->gap)
+    {
+        memmove(r->runs+position+size,r->runs+position,(r->gap-position)*sizeof(struct rle_run));
+    }
+    else if(position>r->gap)
+    {
+        memmove(r->runs+r->gap,r->runs+r->gap+size,(position-r->gap)*sizeof(struct rle_run));
+    }
+    r->gap=position;
+}
+
+/**
+ * inserts @p run into @p r at logical index @p position .
+ */
+static void rle_insert(struct rle_row *r,uint32_t position,struct rle_run run)
+{
+    if(r->length==r->capacity)
+    {
+        //gap is moved to the end, so buffer can simply grow
+        rle_gap_move(r,r->length);
+        r->capacity=r->capacity*2+4;
+        r->runs=realloc(r->runs,r->capacity*sizeof(struct rle_run));
+        if(r->runs==NULL)exit(1);//emergency
+    }
+    rle_gap_move(r,position);
+    r->runs[position]=run;
+    r->gap++;
+    r->length++;
+}
+
+/**
+ * removes run with logical index @p position from @p r .
+ */
+static void rle_remove(struct rle_row *r,uint32_t position)
+{
+    rle_gap_move(r,position+1);
+    r->gap--;
+    r->length--;
+}
+
+int rle_get(const struct rle_row *r,uint32_t x)
+{
+    if(r->length==0)return '.';
+    else return rle_at(r,rle_find(r,x))->value;
+}
+
+uint32_t rle_length(const struct rle_row *r)
+{
+    return r->length>0 ? r->length : 1;
+}
+
+struct rle_run rle_run(const struct rle_row *r,uint32_t width,uint32_t i,uint32_t *end)
+{
+    struct rle_run result={0,'.'};
+    *end=width;
+    if(r->length>0)
+    {
+        result=*rle_at(r,i);
+        if(i+1<r->length)*end=rle_at(r,i+1)->start;
+    }
+    return result;
+}
+
+void rle_set(struct rle_row *r,uint32_t width,uint32_t x,int value)
+{
+    if(r->length==0)
+    {
+        struct rle_run empty={0,'.'};
+        rle_insert(r,0,empty);
+    }
+    uint32_t i=rle_find(r,x);
+    struct rle_run *run=rle_at(r,i);
+    if(run->value!=value)
+    {
+        uint32_t start=run->start;
+        uint32_t end=i+1<r->length ? rle_at(r,i+1)->start : width;
+        int old=run->value;
+        bool join_previous=i>0 && x==start && rle_at(r,i-1)->value==value;
+        bool join_next=i+1<r->length && x==end-1 && rle_at(r,i+1)->value==value;
+        if(end-start==1)
+        {
+            //whole run changes, it can glue neighbours together
+            run->value=value;
+            if(join_next)rle_remove(r,i+1);
+            if(join_previous)rle_remove(r,i);
+        }
+        else if(x==start)
+        {
+            run->start=x+1;
+            if(!join_previous)
+            {
+                struct rle_run single={x,value};
+                rle_insert(r,i,single);
+            }
+        }
+        else if(x==end-1)
+        {
+            if(join_next)rle_at(r,i+1)->start=x;
+            else
+            {
+                struct rle_run single={x,value};
+                rle_insert(r,i+1,single);
+            }
+        }
+        else
+        {
+            struct rle_run single={x,value};
+            struct rle_run rest={x+1,old};
+            rle_insert(r,i+1,single);
+            rle_insert(r,i+2,rest);
+        }
+    }
+}
+
+uint64_t rle_count(const struct rle_row *r,uint32_t width,uint32_t x0,uint32_t x1,int value)
+{
+    uint64_t result=0;
+    if(r->length==0)
+    {
+        if(value=='.')result=(uint64_t)x1-x0+1;
+    }
+    else
+    {
+        uint32_t i=rle_find(r,x0);
+        uint32_t start=x0;
+        while(i<r->length && start<=x1)
+        {
+            const struct rle_run *run=rle_at(r,i);
+            uint32_t end=i+1<r->length ? rle_at(r,i+1)->start : width;
+            if(end>x1+1)end=x1+1;
+            if(run->value==value)result+=end-start;
+            start=end;
+            i++;
+        }
+    }
+    return result;
+}
+
+void rle_free(struct rle_row *r)
+{
+    free(r->runs);
+    r->runs=NULL;
+    r->length=0;
+    r->gap=0;
+    r->capacity=0;
+}
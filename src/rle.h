@@ -0,0 +1,70 @@
+/** @file
+ * run-length encoded board rows, alternative storage of gamma board.
+ */
+#ifndef RLE_H
+#define RLE_H
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * run of tiles of value @p value starting at column @p start,
+ * run ends where next run of the row starts.
+ */
+struct rle_run{
+    uint32_t start;
+    int value;
+};
+
+/**
+ * row kept as gap buffer of runs sorted by start:
+ * runs -buffer of @p capacity runs, runs with logical index from
+ *       @p gap on are stored after the gap (capacity-length runs)
+ * length -amount of runs, 0 for row which was never changed
+ *         (all tiles empty)
+ * gap -logical index at which the gap is
+ * edits next to each other (usual in gamma) move gap only a little.
+ */
+struct rle_row{
+    struct rle_run *runs;
+    uint32_t length;
+    uint32_t gap;
+    uint32_t capacity;
+};
+
+/**
+ * returns value of tile in column @p x of @p r , '.' if never changed.
+ * takes O(log runs) time.
+ */
+int rle_get(const struct rle_row *r,uint32_t x);
+
+/**
+ * sets value of tile in column @p x of @p r of length @p width ,
+ * neighbouring runs of the same value are joined.
+ * takes O(log runs) time plus gap move.
+ */
+void rle_set(struct rle_row *r,uint32_t width,uint32_t x,int value);
+
+/**
+ * returns amount of runs in @p r (at least 1).
+ */
+uint32_t rle_length(const struct rle_row *r);
+
+/**
+ * returns run @p i of @p r (0 <= @p i < rle_length), its end is stored
+ * in @p end .
+ */
+struct rle_run rle_run(const struct rle_row *r,uint32_t width,uint32_t i,uint32_t *end);
+
+/**
+ * returns amount of tiles of value @p value in columns @p x0 to @p x1
+ * (inclusive) of @p r of length @p width .
+ * takes O(log runs) time plus amount of runs in the range.
+ */
+uint64_t rle_count(const struct rle_row *r,uint32_t width,uint32_t x0,uint32_t x1,int value);
+
+/**
+ * frees memory of @p r and makes it empty.
+ */
+void rle_free(struct rle_row *r);
+
+#endif
@@ -0,0 +1,29 @@
+/** @file
+ * xorshift64* pseudo-random generator used by tools (benchmarks,
+ * workloads, self-play, solver and tournament). state is kept by the
+ * caller, so every thread or game can have its own; it must not be 0.
+ */
+#ifndef RNG_H
+#define RNG_H
+#include <stdint.h>
+
+/**
+ * returns next pseudo-random number of generator @p state .
+ */
+static inline uint64_t rng_next(uint64_t *state)
+{
+    *state^=*state>>12;
+    *state^=*state<<25;
+    *state^=*state>>27;
+    return *state*2685821657736338717ull;
+}
+
+/**
+ * returns pseudo-random number from [0, @p n) of generator @p state .
+ */
+static inline uint64_t rng_below(uint64_t *state,uint64_t n)
+{
+    return (uint64_t)(((unsigned __int128)rng_next(state)*n)>>64);
+}
+
+#endif
@@ -5,6 +5,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <termios.h>
 #include <unistd.h>
@@ -14,6 +15,8 @@
 #include "dynamic_array.h"
 #include "batchmode.h"
 #include "interactivemode.h"
+#include "journal.h"
+#include "latency.h"
 
 #define MAX_PROMPT ((unsigned int) 25)
 /** @brief check if board will fit into terminal.
@@ -59,12 +62,90 @@ bool is_window_size_ok(uint32_t width,uint32_t height,uint32_t players)
     }
     return ok;
 }
-int main()
+/** @brief starting options given in command line.
+ * journal_path -file where moves are recorded (-j), NULL if not recorded
+ * latency_path -file for batch mode latency summary (-P), "-" for stderr,
+ *               NULL if commands are not timed
+ * slowest -amount of slowest commands listed in latency summary (-N)
+ * storage -how board is stored (-S array|rle|tiled)
+ */
+struct options{
+    const char *journal_path;
+    const char *latency_path;
+    uint32_t slowest;
+    enum gamma_storage storage;
+};
+
+/** @brief reads command line options.
+ * @returns false if options are not valid
+ */
+bool read_options(int argc,char *argv[],struct options *o)
+{
+    bool ok=true;
+    o->journal_path=NULL;
+    o->latency_path=NULL;
+    o->slowest=LATENCY_DEFAULT_SLOWEST;
+    o->storage=GAMMA_STORAGE_ARRAY;
+    for(int i=1;i<argc && ok;i++)
+    {
+        if(strcmp(argv[i],"-j")==0 && i+1<argc)
+        {
+            i++;
+            o->journal_path=argv[i];
+        }
+        else if(strcmp(argv[i],"-P")==0 && i+1<argc)
+        {
+            i++;
+            o->latency_path=argv[i];
+        }
+        else if(strcmp(argv[i],"-N")==0 && i+1<argc)
+        {
+            i++;
+            o->slowest=strtoul(argv[i],NULL,10);
+        }
+        else if(strcmp(argv[i],"-S")==0 && i+1<argc)
+        {
+            i++;
+            if(strcmp(argv[i],"array")==0)o->storage=GAMMA_STORAGE_ARRAY;
+            else if(strcmp(argv[i],"rle")==0)o->storage=GAMMA_STORAGE_RLE;
+            else if(strcmp(argv[i],"tiled")==0)o->storage=GAMMA_STORAGE_TILED;
+            else ok=false;
+        }
+        else ok=false;
+    }
+    return ok;
+}
+
+/** @brief prints latency summary @p l to file @p path ("-" for stderr).
+ */
+void print_latency(latency_t *l,const char *path)
+{
+    if(l!=NULL)
+    {
+        FILE *f=stderr;
+        if(strcmp(path,"-")!=0)f=fopen(path,"w");
+        if(f!=NULL)
+        {
+            latency_print(l,f);
+            if(f!=stderr)fclose(f);
+        }
+        else fprintf(stderr,"cannot write latency summary %s\n",path);
+    }
+}
+
+int main(int argc,char *argv[])
 {
     int input=' ';
     int line=0;
     gamma_t *g=NULL;
     darray *d=NULL;
+    journal_t *j=NULL;
+    struct options o;
+    if(!read_options(argc,argv,&o))
+    {
+        fprintf(stderr,"usage: %s [-j journal] [-P latency_file|-] [-N slowest] [-S array|rle|tiled]\n",argv[0]);
+        return 1;
+    }
     bool not_done=true;//was batchmode or interactive mode not called earlier
     bool not_ok=true;//used for checking parameters
     while(input!=EOF && not_done)
@@ -79,11 +160,18 @@ int main()
                 not_ok=true;
                 if(d!=NULL && d->length==4)
                 {
-                    g= gamma_new(d->a[0] ,d->a[1] ,d->a[2] ,d->a[3]);
+                    g= gamma_new_storage(d->a[0] ,d->a[1] ,d->a[2] ,d->a[3],o.storage);
                     if(g!=NULL)
                     {
                         printf("OK %d\n",line);
-                        main_batch(g,&line);
+                        j=journal_create(o.journal_path,g,JOURNAL_DEFAULT_INTERVAL);
+                        if(o.journal_path!=NULL && j==NULL)fprintf(stderr,"cannot create journal %s\n",o.journal_path);
+                        latency_t *l=NULL;
+                        if(o.latency_path!=NULL)l=latency_new(o.slowest);
+                        main_batch(g,&line,j,l);
+                        journal_close(j);
+                        print_latency(l,o.latency_path);
+                        latency_delete(l);
                         gamma_delete(g);
                         not_ok=false;
                         not_done=false;
@@ -99,13 +187,16 @@ int main()
                 not_ok=true;
                 if(d!=NULL && d->length==4)
                 {
-                    g=gamma_new(d->a[0], d->a[1], d->a[2], d->a[3]);
+                    g=gamma_new_storage(d->a[0], d->a[1], d->a[2], d->a[3], o.storage);
                     if(g!=NULL)
                     {
                         if(is_window_size_ok(d->a[0], d->a[1], d->a[2]))
                         {
                             printf("OK %d\n",line);
-                            main_interactive(g);
+                            j=journal_create(o.journal_path,g,JOURNAL_DEFAULT_INTERVAL);
+                            if(o.journal_path!=NULL && j==NULL)fprintf(stderr,"cannot create journal %s\n",o.journal_path);
+                            main_interactive(g,j);
+                            journal_close(j);
                             not_ok=false;
                             not_done=false;
                         }
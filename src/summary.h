@@ -0,0 +1,102 @@
+/** @file
+ * summaries of blocks of SUMMARY_COLUMNS x SUMMARY_ROWS tiles of gamma
+ * board, kept up to date by every change of a tile, so that scans of
+ * whole board can skip blocks which can not change their result.
+ */
+#ifndef SUMMARY_H
+#define SUMMARY_H
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** log2 of amount of columns of a block */
+#define SUMMARY_COLUMN_BITS 6
+/** log2 of amount of rows of a block */
+#define SUMMARY_ROW_BITS 3
+/** amount of columns of a block */
+#define SUMMARY_COLUMNS (1u<<SUMMARY_COLUMN_BITS)
+/** amount of rows of a block */
+#define SUMMARY_ROWS (1u<<SUMMARY_ROW_BITS)
+/** owner of block without taken tiles */
+#define SUMMARY_NONE 0
+/** owner of block which may have tiles of more than one player */
+#define SUMMARY_MIXED UINT32_MAX
+
+/**
+ * summary of one block:
+ * empty -amount of empty tiles
+ * busy -amount of taken tiles
+ * owner -value of tiles of the only player having tiles in the block,
+ *        SUMMARY_NONE or SUMMARY_MIXED
+ * players -bit (value-'1')%64 is set if player with tile of such value
+ *          may have tiles in the block
+ * block stays mixed and its bits stay set until none of its tiles is taken.
+ */
+struct block_summary{
+    uint16_t empty;
+    uint16_t busy;
+    uint32_t owner;
+    uint64_t players;
+};
+
+/**
+ * returns bit of tiles of value @p v in players of block summary.
+ */
+static inline uint64_t summary_bit(uint32_t v)
+{
+    return (uint64_t)1<<((v-'1')%64);
+}
+
+/**
+ * returns amount of blocks needed to cover @p length tiles split into
+ * parts of 2^ @p bits tiles.
+ */
+static inline uint32_t summary_blocks(uint64_t length,uint32_t bits)
+{
+    return (length+(1u<<bits)-1)>>bits;
+}
+
+/**
+ * returns summary of block containing tile < @p x , @p y > of board
+ * summarized by @p s with @p columns blocks in a block row.
+ */
+static inline struct block_summary* summary_at(struct block_summary *s,uint32_t columns,
+                                               uint32_t x,uint32_t y)
+{
+    return s+(size_t)(y>>SUMMARY_ROW_BITS)*columns+(x>>SUMMARY_COLUMN_BITS);
+}
+
+/**
+ * records change of tile summarized by @p s from @p old to @p value .
+ */
+static inline void summary_change(struct block_summary *s,int old,int value)
+{
+    if(old=='.')s->empty--;
+    else
+    {
+        s->busy--;
+        if(s->busy==0)
+        {
+            s->owner=SUMMARY_NONE;
+            s->players=0;
+        }
+    }
+    if(value=='.')s->empty++;
+    else
+    {
+        s->busy++;
+        if(s->owner==SUMMARY_NONE)s->owner=value;
+        else if(s->owner!=(uint32_t)value)s->owner=SUMMARY_MIXED;
+        s->players|=summary_bit(value);
+    }
+}
+
+/**
+ * checks if block @p s may have tiles of value @p v .
+ */
+static inline bool summary_may_have(const struct block_summary *s,uint32_t v)
+{
+    return (s->players&summary_bit(v))!=0;
+}
+
+#endif
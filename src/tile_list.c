@@ -0,0 +1,49 @@
+/** @file
+ * implements tile_list.h
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "tile_list.h"
+
+bool tile_list_add(struct tile_list *l,uint32_t cell)
+{
+    bool result=true;
+    if(l->length==l->capacity)
+    {
+        uint32_t capacity=l->capacity*2+4;
+        uint32_t *cells=realloc(l->cells,(size_t)capacity*sizeof(uint32_t));
+        if(cells!=NULL)
+        {
+            l->cells=cells;
+            l->capacity=capacity;
+        }
+        else result=false;
+    }
+    if(result)
+    {
+        l->cells[l->length]=cell;
+        l->length++;
+    }
+    return result;
+}
+
+void tile_list_remove(struct tile_list *l,uint32_t cell)
+{
+    uint32_t i=l->length;
+    while(i>0 && l->cells[i-1]!=cell)i--;
+    if(i>0)
+    {
+        l->cells[i-1]=l->cells[l->length-1];
+        l->length--;
+    }
+}
+
+void tile_list_free(struct tile_list *l)
+{
+    free(l->cells);
+    l->cells=NULL;
+    l->length=0;
+    l->capacity=0;
+}
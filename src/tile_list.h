@@ -0,0 +1,45 @@
+/** @file
+ * lists of tiles of every player, so that work on tiles of one player
+ * costs O(tiles of the player) instead of O(board).
+ */
+#ifndef TILE_LIST_H
+#define TILE_LIST_H
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * lists are used instead of going through whole board when listed
+ * tiles are less than 1/TILE_LIST_RATIO of the board, as tiles on the
+ * list are visited in no particular order.
+ */
+#define TILE_LIST_RATIO 16
+
+/**
+ * tiles of one player in no particular order:
+ * cells -buffer of @p capacity numbers of tiles (y*width+x)
+ * length -amount of tiles on the list
+ */
+struct tile_list{
+    uint32_t *cells;
+    uint32_t length;
+    uint32_t capacity;
+};
+
+/**
+ * adds tile @p cell at the end of @p l .
+ * @returns false if there is no memory for the list to grow
+ */
+bool tile_list_add(struct tile_list *l,uint32_t cell);
+
+/**
+ * removes tile @p cell from @p l , last tile takes its place.
+ * list is searched from the end, so tile added last is removed at once.
+ */
+void tile_list_remove(struct tile_list *l,uint32_t cell);
+
+/**
+ * frees buffer of @p l and leaves it empty.
+ */
+void tile_list_free(struct tile_list *l);
+
+#endif
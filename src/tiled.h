@@ -0,0 +1,40 @@
+/** @file
+ * cache-blocked board layout: board is split into square blocks of
+ * TILED_SIDE x TILED_SIDE tiles stored one after another (block rows
+ * from the bottom, blocks of a block row from the left), tiles inside
+ * of a block are stored row by row.
+ * tiles next to each other vertically are TILED_SIDE tiles apart instead
+ * of whole board width, so neighbour probes mostly stay in the same
+ * few cache lines and page.
+ */
+#ifndef TILED_H
+#define TILED_H
+#include <stddef.h>
+#include <stdint.h>
+
+/** log2 of side of a block */
+#define TILED_BITS 3
+/** side of a block (8 tiles, 256 bytes of int cells) */
+#define TILED_SIDE (1u<<TILED_BITS)
+/** mask of coordinate inside of a block */
+#define TILED_MASK (TILED_SIDE-1)
+
+/**
+ * returns amount of blocks needed to cover @p length tiles.
+ */
+static inline uint64_t tiled_blocks(uint64_t length)
+{
+    return (length+TILED_MASK)>>TILED_BITS;
+}
+
+/**
+ * returns index of tile < @p x , @p y > in board made of blocks with
+ * @p columns blocks in every block row.
+ */
+static inline size_t tiled_index(uint32_t columns,uint32_t x,uint32_t y)
+{
+    size_t block=(size_t)(y>>TILED_BITS)*columns+(x>>TILED_BITS);
+    return (block<<(2*TILED_BITS))|((y&TILED_MASK)<<TILED_BITS)|(x&TILED_MASK);
+}
+
+#endif
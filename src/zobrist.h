@@ -0,0 +1,51 @@
+/** @file
+ * Zobrist keys of a game: hash of a game is xor of keys of its taken
+ * tiles and of players who used their golden move, so a move changes it
+ * by one or two xors and empty game has hash 0.
+ * keys are not kept in tables (boards and amounts of players can be
+ * huge), they are mixed from number of tile and its value instead.
+ */
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+#include <stdint.h>
+
+/**
+ * returns @p x mixed by the finalizer of splitmix64 (a bijection, every
+ * bit of result depends on every bit of @p x ).
+ */
+static inline uint64_t zobrist_mix(uint64_t x)
+{
+    x^=x>>30;
+    x*=0xbf58476d1ce4e5b9ull;
+    x^=x>>27;
+    x*=0x94d049bb133111ebull;
+    x^=x>>31;
+    return x;
+}
+
+/**
+ * returns key of tile @p cell (y*width+x) with value @p value ('0'+player).
+ */
+static inline uint64_t zobrist_cell(uint64_t cell,uint32_t value)
+{
+    return zobrist_mix(zobrist_mix(cell+0x9e3779b97f4a7c15ull)^value);
+}
+
+/**
+ * returns key of @p player who used the golden move.
+ */
+static inline uint64_t zobrist_golden(uint32_t player)
+{
+    return zobrist_mix(zobrist_mix(player)+0xd1b54a32d192ed03ull);
+}
+
+/**
+ * returns key of @p player being next to move (games do not keep it,
+ * searches add it to the hash of a game).
+ */
+static inline uint64_t zobrist_turn(uint32_t player)
+{
+    return zobrist_mix(zobrist_mix(player)+0x8cb92ba72f3d8dd7ull);
+}
+
+#endif